@@ -5,10 +5,11 @@
 #include "gapr/detail/nrrd-output.hh"
 
 #include <fstream>
+#include <thread>
 
 void convert_to_nrrd(const char* input, const char* output) {
 	auto sb=gapr::make_streambuf(input);
-	auto imageReader=gapr::make_cube_loader(input, static_cast<gapr::Streambuf&>(*sb));
+	auto imageReader=gapr::make_cube_loader(input, static_cast<gapr::Streambuf&>(*sb), std::thread::hardware_concurrency());
 	if(!imageReader)
 		gapr::report("Cannot read file: ", input);
 
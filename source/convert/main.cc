@@ -63,6 +63,10 @@ constexpr static const struct option opts_long[]={
 	{"threads", 1, nullptr, 7000+'t'},
 	{"passes", 1, nullptr, 7000+'p'},
 	{"filter", 1, nullptr, 7000+'f'},
+	/*network*/
+	{"connections", 1, nullptr, 8000+'c'},
+	{"pipeline", 1, nullptr, 8000+'p'},
+	{"net-timeout", 1, nullptr, 8000+'t'},
 	/*visor-like*/
 	{"plugin", 1, nullptr, 2000+'p'},
 	{"plugin-args", 1, nullptr, 2000+'a'},
@@ -89,6 +93,12 @@ static void usage(const char* argv0) {
 		"                        Density estimated in spheres with\n"
 		"                        radius <r>.\n\n"
 		"   --f1score <ref>      Calculate F1 score with <ref>.\n"
+		"   --connections <n>    Open at most <n> connections to the\n"
+		"                        server (default: 3).\n"
+		"   --pipeline <n>       Send up to <n> requests on a connection\n"
+		"                        ahead of the responses (default: 1).\n"
+		"   --net-timeout <s>    Give up on a network operation after\n"
+		"                        <s> seconds (default: 30).\n\n"
 		"Arguments:\n"
 		"   <swc-file>           Input file.\n\n"
 		PACKAGE_NAME " " PACKAGE_VERSION "\n"
@@ -275,6 +285,24 @@ int main(int argc, char* argv[]) {
 				case 7000+'f':
 					enc_opts.filter=optarg;
 					break;
+				case 8000+'c':
+					if(!gapr::parse_tuple<unsigned int>(optarg, &srv.connections))
+						throw gapr::reported_error("Please give an integer.\n");
+					if(srv.connections<=0)
+						throw gapr::reported_error("Need a positive integer.\n");
+					break;
+				case 8000+'p':
+					if(!gapr::parse_tuple<unsigned int>(optarg, &srv.pipeline))
+						throw gapr::reported_error("Please give an integer.\n");
+					if(srv.pipeline<=0)
+						throw gapr::reported_error("Need a positive integer.\n");
+					break;
+				case 8000+'t':
+					if(!gapr::parse_tuple<unsigned int>(optarg, &srv.timeout))
+						throw gapr::reported_error("Please give an integer.\n");
+					if(srv.timeout<=0)
+						throw gapr::reported_error("Need a positive integer.\n");
+					break;
 				case '?':
 					cli_helper.report_unknown_opt(argc, argv);
 					break;
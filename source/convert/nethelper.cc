@@ -1,11 +1,18 @@
 #include "nethelper.hh"
 #include "gapr/mem-file.hh"
+#include "gapr/utility.hh"
 
+#include <boost/asio/steady_timer.hpp>
 #include <boost/beast/http/read.hpp>
 #include <boost/beast/http/write.hpp>
 
+#include <random>
+#include <sstream>
+
+#include "../corelib/detail/test-cert.hh"
+
 network_helper::network_helper(boost::asio::io_context& ctx, std::string&& host, std::string&& port):
-	host{std::move(host)}, port{std::move(port)}, _resolver(ctx.get_executor()) {
+	host{std::move(host)}, port{std::move(port)}, _ex{ctx.get_executor()}, _resolver(ctx.get_executor()) {
 		//load_root_certificates(ctx);
 		//helper._ssl_ctx.set_verify_mode(boost::asio::ssl::verify_peer);
 		_ssl_ctx.set_verify_mode(boost::asio::ssl::verify_none);
@@ -13,17 +20,6 @@ network_helper::network_helper(boost::asio::io_context& ctx, std::string&& host,
 	}
 network_helper::~network_helper() {
 }
-void network_helper::do_shutdown(session& sess) {
-	//boost::beast::get_lowest_layer(sess.ssl).expires_after(std::chrono::seconds(30));
-#ifndef NO_SSL
-	sess.ssl->async_shutdown([this,sess=sess.shared_from_this()](boost::beast::error_code ec) {
-		if(ec==boost::asio::error::eof)
-			ec = {};
-		//if(ec)
-			//return fail(ec, "shutdown");
-	});
-#endif
-}
 template<bool PUT>
 static auto& get_res(network_helper::session& sess) {
 	if constexpr(PUT) {
@@ -49,70 +45,203 @@ void call_cb(network_helper::session& sess) {
 	}
 }
 template<bool PUT>
-void network_helper::do_read(session& sess) {
-	boost::beast::http::async_read(sess.sock(), sess.res_buf, get_res<PUT>(sess), [this,sess=sess.shared_from_this()](boost::beast::error_code ec, std::size_t bytes_transferred) {
-		auto ex=_resolver.get_executor();
-		//assert(ex.running_in_this_thread());
+static void reset_res(network_helper::session& sess) {
+	get_res<PUT>(sess)={};
+	if constexpr(!PUT)
+		get_res<PUT>(sess).body().mfile=gapr::mutable_mem_file{false};
+}
+
+template<bool PUT>
+void network_helper::do_read(connection& conn, session& sess) {
+	boost::beast::get_lowest_layer(*conn.ssl).expires_after(timeout);
+	boost::beast::http::async_read(*conn.ssl, conn.buf, get_res<PUT>(sess), [this,conn=conn.shared_from_this()](boost::beast::error_code ec, std::size_t bytes_transferred) {
 		boost::ignore_unused(bytes_transferred);
+		conn->busy_read=false;
+		if(conn->closing)
+			return do_retire(*conn);
 		if(ec)
-			return fail(ec, "read");
-		call_cb<PUT>(*sess);
-		if(!get_res<PUT>(*sess).keep_alive()) {
-			do_shutdown(*sess);
-			if(!_pending.empty()) {
-				auto sessnext=std::move(_pending.front());
-				_pending.pop_front();
-				do_session_conn(*sessnext, *ex.target<boost::asio::io_context::executor_type>());
-			}
-			return;
+			return do_close(*conn, ec, "read");
+		auto sess=std::move(conn->to_read.front());
+		conn->to_read.pop_front();
+		if(!conn->tls_saved) {
+			// tls1.3 tickets arrive after the handshake
+			conn->tls_saved=true;
+			if(auto s=SSL_get1_session(conn->ssl->native_handle()))
+				_tls_session.reset(s);
 		}
-		if(_pending.empty()) {
-			_connections.push_back(std::move(sess->ssl));
-			return;
-		}
-		auto sessnext=std::move(_pending.front());
-		_pending.pop_front();
-		sessnext->ssl=std::move(sess->ssl);
-		if(sessnext->_put)
-			do_send<true>(*sessnext);
-		else
-			do_send<false>(*sessnext);
+		call_cb<PUT>(*sess);
+		if(!get_res<PUT>(*sess).keep_alive())
+			return do_close(*conn);
+		conn->keep_alive=true;
+		do_read(*conn);
+		do_dispatch();
 	});
 }
+void network_helper::do_read(connection& conn) {
+	if(conn.busy_read || conn.to_read.empty())
+		return;
+	conn.busy_read=true;
+	auto& sess=*conn.to_read.front();
+	if(sess._put)
+		do_read<true>(conn, sess);
+	else
+		do_read<false>(conn, sess);
+}
 template<bool PUT>
-void network_helper::do_send(session& sess) {
-	//boost::beast::get_lowest_layer(sess.ssl).expires_after(std::chrono::seconds(30));
-	boost::beast::http::async_write(sess.sock(), get_req<PUT>(sess), [this,sess=sess.shared_from_this()](boost::beast::error_code ec, std::size_t bytes_transferred) {
+void network_helper::do_write(connection& conn, session& sess) {
+	boost::beast::get_lowest_layer(*conn.ssl).expires_after(timeout);
+	boost::beast::http::async_write(*conn.ssl, get_req<PUT>(sess), [this,conn=conn.shared_from_this()](boost::beast::error_code ec, std::size_t bytes_transferred) {
 		boost::ignore_unused(bytes_transferred);
+		conn->busy_write=false;
+		if(conn->closing)
+			return do_retire(*conn);
 		if(ec)
-			return fail(ec, "write");
-		do_read<PUT>(*sess);
+			return do_close(*conn, ec, "write");
+		conn->to_read.push_back(std::move(conn->to_write.front()));
+		conn->to_write.pop_front();
+		do_read(*conn);
+		do_write(*conn);
 	});
 }
-void network_helper::do_handshake(session& sess) {
+void network_helper::do_write(connection& conn) {
+	if(!conn.ready || conn.closing || conn.busy_write || conn.to_write.empty())
+		return;
+	conn.busy_write=true;
+	auto& sess=*conn.to_write.front();
+	if(sess._put)
+		do_write<true>(conn, sess);
+	else
+		do_write<false>(conn, sess);
+}
+void network_helper::do_handshake(connection& conn) {
 #ifndef NO_SSL
-	sess.ssl->async_handshake(boost::asio::ssl::stream_base::client, [this,sess=sess.shared_from_this()](boost::beast::error_code ec) {
+	boost::beast::get_lowest_layer(*conn.ssl).expires_after(timeout);
+	conn.ssl->async_handshake(boost::asio::ssl::stream_base::client, [this,conn=conn.shared_from_this()](boost::beast::error_code ec) {
 		if(ec)
-			return fail(ec, "handshake");
+			return do_close(*conn, ec, "handshake");
 #endif
-		if(sess->_put)
-			do_send<true>(*sess);
-		else
-			do_send<false>(*sess);
+		conn->ready=true;
+		do_write(*conn);
 #ifndef NO_SSL
 	});
 #endif
 }
-void network_helper::do_connect(session& sess) {
-	//boost::beast::get_lowest_layer(sess.ssl).expires_after(std::chrono::seconds(30));
-	boost::beast::get_lowest_layer(sess.sock()).async_connect(addresses, [this,sess=sess.shared_from_this()](boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type::endpoint_type) {
+void network_helper::do_connect(connection& conn) {
+	boost::beast::get_lowest_layer(*conn.ssl).expires_after(timeout);
+	boost::beast::get_lowest_layer(*conn.ssl).async_connect(addresses, [this,conn=conn.shared_from_this()](boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type::endpoint_type) {
+		if(ec)
+			return do_close(*conn, ec, "connect");
+		do_handshake(*conn);
+	});
+}
+
+void network_helper::do_close(connection& conn, boost::beast::error_code ec, const char* what) {
+	if(conn.closing)
+		return;
+	conn.closing=true;
+	conn.ec=ec;
+	conn.what=what;
+	// abandon a stalled or broken connection, and cancel pipelined
+	// operations on one the server is closing
+	if(ec || conn.busy_read || conn.busy_write)
+		boost::beast::get_lowest_layer(*conn.ssl).close();
+	do_retire(conn);
+}
+void network_helper::do_retire(connection& conn) {
+	if(conn.busy_read || conn.busy_write)
+		return;
+	auto it=std::find_if(_conns.begin(), _conns.end(), [&conn](auto& c) { return c.get()==&conn; });
+	assert(it!=_conns.end());
+	auto self=std::move(*it);
+	_conns.erase(it);
+
+	// resend whatever was not answered, in the original order
+	auto requeue=[this,&conn](std::deque<std::shared_ptr<session>>& q) {
+		while(!q.empty()) {
+			auto sess=std::move(q.back());
+			q.pop_back();
+			if(conn.ec && ++sess->_retries>max_retries)
+				return fail(conn.ec, conn.what);
+			if(sess->_put)
+				reset_res<true>(*sess);
+			else
+				reset_res<false>(*sess);
+			_pending.push_front(std::move(sess));
+		}
+	};
+	requeue(conn.to_write);
+	requeue(conn.to_read);
+
+#ifndef NO_SSL
+	if(!conn.ec && conn.ready) {
+		boost::beast::get_lowest_layer(*conn.ssl).expires_after(timeout);
+		conn.ssl->async_shutdown([self](boost::beast::error_code ec) {
+			if(ec==boost::asio::error::eof)
+				ec = {};
+			//if(ec)
+				//return fail(ec, "shutdown");
+		});
+	}
+#endif
+	do_dispatch();
+}
+
+std::shared_ptr<network_helper::connection> network_helper::do_open() {
+	auto conn=std::make_shared<connection>();
+	conn->ssl=std::make_unique<boost::beast::ssl_stream<boost::beast::tcp_stream>>(_ex, _ssl_ctx);
+	if(!SSL_set_tlsext_host_name(conn->ssl->native_handle(), host.c_str())) {
+		boost::beast::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
+		fail(ec, "host name");
+	}
+	// resume the tls session, the handshake falls back to a full one if refused
+	if(_tls_session)
+		SSL_set_session(conn->ssl->native_handle(), _tls_session.get());
+	_conns.push_back(conn);
+	if(!addresses.empty()) {
+		do_connect(*conn);
+		return conn;
+	}
+	_resolver.async_resolve(host, port, [this,conn](boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type results) {
 		if(ec)
-			return fail(ec, "connect");
-		do_handshake(*sess);
+			return fail(ec, "resolve");
+		assert(!results.empty());
+		addresses=std::move(results);
+		//for(auto a: addresses)
+		//a.service_name
+		do_connect(*conn);
 	});
+	return conn;
+}
+void network_helper::do_dispatch() {
+	while(!_pending.empty()) {
+		connection* conn{nullptr};
+		// an idle connection, then a new one, then pipelining
+		for(auto& c: _conns) {
+			if(!c->closing && c->load()==0) {
+				conn=c.get();
+				break;
+			}
+		}
+		if(!conn && _conns.size()<max_conns)
+			conn=do_open().get();
+		if(!conn) {
+			for(auto& c: _conns) {
+				if(c->closing || !c->keep_alive || c->load()>=pipeline || c->held())
+					continue;
+				if(!conn || c->load()<conn->load())
+					conn=c.get();
+			}
+		}
+		if(!conn)
+			break;
+		conn->to_write.push_back(std::move(_pending.front()));
+		_pending.pop_front();
+		do_write(*conn);
+	}
 }
+
 template<bool PUT>
-void network_helper::do_init(session& sess) {
+static void do_init(network_helper::session& sess, const std::string& host) {
 	get_req<PUT>(sess).version(11);
 	get_req<PUT>(sess).set(boost::beast::http::field::host, host);
 	get_req<PUT>(sess).set(boost::beast::http::field::user_agent, "gapr");
@@ -128,44 +257,337 @@ void network_helper::do_init(session& sess) {
 void network_helper::do_session(session& sess, boost::asio::io_context::executor_type ex) {
 	assert(ex.running_in_this_thread());
 	if(sess._put)
-		do_init<true>(sess);
+		do_init<true>(sess, host);
 	else
-		do_init<false>(sess);
-	auto n_sess=sess.bind(this);
-	if(!_connections.empty()) {
-		sess.ssl=std::move(_connections.back());
-		_connections.pop_back();
-		if(sess._put)
-			do_send<true>(sess);
-		else
-			do_send<false>(sess);
-		return;
+		do_init<false>(sess, host);
+	sess.bind(this);
+	_pending.push_back(sess.shared_from_this());
+	do_dispatch();
+}
+
+void pending_poller::prepare(network_helper::session& sess, std::chrono::steady_clock::time_point ts) {
+	assert(!_busy);
+	_busy=true;
+	_start=ts;
+	if(holding()) {
+		sess.req_get.set("GaprWait", std::to_string(wait.count()));
+		sess._long=true;
 	}
-	if(n_sess>3) {
-		_pending.push_back(sess.shared_from_this());
-		return;
+}
+bool pending_poller::done(const boost::beast::http::response_header<>& hdr, bool empty, std::chrono::steady_clock::time_point ts) {
+	assert(_busy);
+	_busy=false;
+	auto backoff=[this,ts]() {
+		_backoff=_backoff.count()==0 ? std::chrono::milliseconds{250} : std::min(_backoff*2, std::chrono::milliseconds{8000});
+		_next=ts+_backoff;
+	};
+	switch(hdr.result()) {
+		case boost::beast::http::status::bad_gateway:
+		case boost::beast::http::status::service_unavailable:
+		case boost::beast::http::status::gateway_timeout:
+			// a proxy gave up on a held request
+			backoff();
+			return false;
+		default:
+			break;
 	}
-	do_session_conn(sess, ex);
+	if(!holding()) {
+		_next=_start+interval;
+		return true;
+	}
+	if(hdr.find("GaprWait")==hdr.end()) {
+		_fallback=true;
+		_next=_start+interval;
+		return true;
+	}
+	// returned early with nothing new
+	if(empty && ts-_start<wait/2) {
+		backoff();
+		return true;
+	}
+	_backoff=std::chrono::milliseconds{0};
+	_next=ts;
+	return true;
 }
-void network_helper::do_session_conn(session& sess, boost::asio::io_context::executor_type ex) {
-	auto ssl=std::make_unique<boost::beast::ssl_stream<boost::beast::tcp_stream>>(ex, _ssl_ctx);
-	if(!SSL_set_tlsext_host_name(ssl->native_handle(), host.c_str())) {
-		boost::beast::error_code ec{static_cast<int>(::ERR_get_error()), boost::asio::error::get_ssl_category()};
-		std::cerr<<ec.message()<<"\n";
-		return;
+
+namespace {
+	struct test_conn;
+	/*! loopback server, responses are made by the handler in order */
+	struct test_server {
+		boost::asio::ip::tcp::acceptor acc;
+		boost::asio::ssl::context ssl_ctx{boost::asio::ssl::context::tlsv12_server};
+		std::function<void(test_conn&)> handler;
+		unsigned int n_accepted{0};
+		unsigned int n_open{0}, peak{0};
+		unsigned int n_pipelined{0};
+		/*! do not respond on the first connection */
+		bool stall_first{false};
+
+		explicit test_server(boost::asio::io_context& ctx):
+			acc{ctx, {boost::asio::ip::make_address("127.0.0.1"), 0}} {
+				// the test key is short, allowed below the default level
+				SSL_CTX_set_security_level(ssl_ctx.native_handle(), 1);
+				ssl_ctx.use_certificate({certif, sizeof(certif)}, boost::asio::ssl::context::pem);
+				ssl_ctx.use_private_key({priv_key, sizeof(priv_key)}, boost::asio::ssl::context::pem);
+			}
+		unsigned short port() const { return acc.local_endpoint().port(); }
+		void accept();
+	};
+	struct test_conn: std::enable_shared_from_this<test_conn> {
+		test_server& srv;
+		boost::beast::ssl_stream<boost::beast::tcp_stream> ssl;
+		boost::beast::flat_buffer buf;
+		std::deque<boost::beast::http::request<boost::beast::http::string_body>> reqs;
+		boost::beast::http::response<boost::beast::http::string_body> res;
+		boost::asio::steady_timer timer;
+		bool stall;
+		bool responding{false};
+		bool closed{false};
+		unsigned int n_served{0};
+
+		test_conn(test_server& srv, boost::asio::ip::tcp::socket&& sock, bool stall):
+			srv{srv}, ssl{std::move(sock), srv.ssl_ctx}, timer{ssl.get_executor()}, stall{stall} {
+				if(!stall && ++srv.n_open>srv.peak)
+					srv.peak=srv.n_open;
+			}
+		void start() {
+			ssl.async_handshake(boost::asio::ssl::stream_base::server, [self=shared_from_this()](boost::beast::error_code ec) {
+				if(ec)
+					return self->close();
+				self->read();
+			});
+		}
+		void read() {
+			reqs.emplace_back();
+			boost::beast::http::async_read(ssl, buf, reqs.back(), [self=shared_from_this()](boost::beast::error_code ec, std::size_t) {
+				if(ec)
+					return self->close();
+				if(self->closed)
+					return;
+				// received while an earlier one is still unanswered
+				if(self->reqs.size()>1)
+					++self->srv.n_pipelined;
+				if(!self->stall && !self->responding) {
+					self->responding=true;
+					self->srv.handler(*self);
+				}
+				self->read();
+			});
+		}
+		const auto& request() const { return reqs.front(); }
+		void reply(std::string&& body, bool keep_alive=true, std::string_view wait={}) {
+			if(closed)
+				return;
+			res={};
+			res.version(11);
+			res.result(boost::beast::http::status::ok);
+			if(!wait.empty())
+				res.set("GaprWait", wait);
+			res.body()=std::move(body);
+			res.keep_alive(keep_alive);
+			res.prepare_payload();
+			reqs.pop_front();
+			++n_served;
+			boost::beast::http::async_write(ssl, res, [self=shared_from_this()](boost::beast::error_code ec, std::size_t) {
+				if(ec || !self->res.keep_alive())
+					return self->close();
+				// the last one is being read
+				if(self->reqs.size()<=1)
+					self->responding=false;
+				else
+					self->srv.handler(*self);
+			});
+		}
+		void close() {
+			if(closed)
+				return;
+			closed=true;
+			if(!stall)
+				--srv.n_open;
+			boost::beast::error_code ec;
+			timer.cancel();
+			boost::beast::get_lowest_layer(ssl).socket().shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+			boost::beast::get_lowest_layer(ssl).close();
+		}
+	};
+	void test_server::accept() {
+		acc.async_accept([this](boost::beast::error_code ec, boost::asio::ip::tcp::socket sock) {
+			if(ec)
+				return;
+			auto stall=stall_first && n_accepted==0;
+			++n_accepted;
+			std::make_shared<test_conn>(*this, std::move(sock), stall)->start();
+			accept();
+		});
 	}
-	sess.ssl=std::move(ssl);
-	if(!addresses.empty()) {
-		do_connect(sess);
-		return;
+	std::string to_string(const gapr::mem_file& file) {
+		std::string body;
+		for(std::size_t off=0; off<file.size(); ) {
+			auto buf=file.map(off);
+			body.append(buf.data(), buf.size());
+			off+=buf.size();
+		}
+		return body;
 	}
-	_resolver.async_resolve(host, port, [this,sess=sess.shared_from_this()](boost::beast::error_code ec, boost::asio::ip::tcp::resolver::results_type results) {
-		if(ec)
-			return fail(ec, "resolve");
-		assert(!results.empty());
-		addresses=std::move(results);
-		//for(auto a: addresses)
-		//a.service_name
-		do_connect(*sess);
-	});
 }
+
+namespace gapr_test { int chk_network_helper() {
+	constexpr unsigned int N=60;
+	boost::asio::io_context ctx;
+	// throttled, and asks to close every 5th connection
+	test_server srv{ctx};
+	srv.stall_first=true;
+	srv.handler=[](test_conn& conn) {
+		conn.timer.expires_after(std::chrono::milliseconds{10});
+		conn.timer.async_wait([conn=conn.shared_from_this()](boost::beast::error_code ec) {
+			if(ec)
+				return;
+			std::string target{conn->request().target()};
+			conn->reply(std::move(target), (conn->n_served+1)%5!=0);
+		});
+	};
+	srv.accept();
+
+	network_helper helper{ctx, "127.0.0.1", std::to_string(srv.port())};
+	helper.max_conns=2;
+	helper.pipeline=3;
+	helper.timeout=std::chrono::milliseconds{300};
+
+	unsigned int n_ok{0}, n_bad{0};
+	boost::asio::post(ctx, [&]() {
+		for(unsigned int i=0; i<N; i++) {
+			auto target="/api/test/"+std::to_string(i);
+			auto sess=std::make_shared<network_helper::session>([&,target](gapr::mem_file&& file, const boost::beast::http::response_header<>& hdr) {
+				if(hdr.result()==boost::beast::http::status::ok && to_string(file)==target)
+					++n_ok;
+				else
+					++n_bad;
+				if(n_ok+n_bad==N)
+					ctx.stop();
+			});
+			sess->req_get.method(boost::beast::http::verb::get);
+			sess->req_get.target(target);
+			helper.do_session(*sess, ctx.get_executor());
+		}
+	});
+	ctx.run_for(std::chrono::seconds{30});
+
+	gapr::print("ok: ", n_ok, ", bad: ", n_bad, ", connections: ", srv.n_accepted,
+			", peak: ", srv.peak, ", pipelined: ", srv.n_pipelined);
+	if(n_ok!=N || n_bad!=0)
+		return -1;
+	// the stalled connection must have been given up
+	if(srv.n_accepted<2 || srv.peak>helper.max_conns)
+		return -1;
+	if(srv.n_pipelined==0)
+		return -1;
+	return 0;
+} }
+
+namespace gapr_test { int chk_pending_poller() {
+	// jobs are published at random, a worker picks them up the way
+	// convert does, with a 1s timer to drive it while idle.
+	// a server that does not hold requests is polled instead.
+	auto handoff=[](bool long_poll) {
+		constexpr unsigned int N=20;
+		boost::asio::io_context ctx;
+		test_server srv{ctx};
+		std::vector<std::chrono::steady_clock::time_point> published;
+		std::vector<std::shared_ptr<test_conn>> held;
+		auto respond=[&published,long_poll](test_conn& conn, uint64_t seq) {
+			std::string body;
+			for(auto i=seq; i<published.size(); i++)
+				body+=std::to_string(i+1)+":job\n";
+			conn.reply(std::move(body), true, long_poll ? conn.request()["GaprWait"] : std::string_view{});
+		};
+		srv.handler=[&](test_conn& conn) {
+			std::string_view target{conn.request().target()};
+			uint64_t seq=std::stoull(std::string{target.substr(target.rfind('/')+1)});
+			auto wait=conn.request()["GaprWait"];
+			if(!long_poll || wait.empty() || seq<published.size())
+				return respond(conn, seq);
+			held.push_back(conn.shared_from_this());
+			conn.timer.expires_after(std::chrono::seconds{std::stoul(std::string{wait})});
+			conn.timer.async_wait([&respond,conn=conn.shared_from_this(),seq](boost::beast::error_code ec) {
+				respond(*conn, seq);
+			});
+		};
+		srv.accept();
+
+		boost::asio::steady_timer pub_timer{ctx};
+		std::mt19937 rng{42};
+		std::function<void()> publish=[&]() {
+			pub_timer.expires_after(std::chrono::milliseconds{std::uniform_int_distribution<int>{50, 150}(rng)});
+			pub_timer.async_wait([&](boost::beast::error_code ec) {
+				if(ec)
+					return;
+				published.push_back(std::chrono::steady_clock::now());
+				for(auto& conn: held)
+					conn->timer.cancel();
+				held.clear();
+				if(published.size()<N)
+					publish();
+			});
+		};
+
+		network_helper helper{ctx, "127.0.0.1", std::to_string(srv.port())};
+		pending_poller poller;
+		poller.wait=std::chrono::seconds{5};
+		poller.interval=std::chrono::milliseconds{200};
+		uint64_t last_seq{0};
+		std::chrono::steady_clock::duration latency{0};
+		boost::asio::steady_timer timer{ctx};
+		bool timer_busy{false};
+		std::function<void()> tick=[&]() {
+			auto ts=std::chrono::steady_clock::now();
+			if(poller.ready(ts)) {
+				auto sess=std::make_shared<network_helper::session>([&](gapr::mem_file&& file, const boost::beast::http::response_header<>& hdr) {
+					auto ts=std::chrono::steady_clock::now();
+					if(!poller.done(hdr, file.size()==0, ts))
+						return tick();
+					std::istringstream str{to_string(file)};
+					uint64_t seq;
+					std::string job;
+					while(str>>seq && std::getline(str, job)) {
+						if(seq<=last_seq)
+							continue;
+						latency+=ts-published[seq-1];
+						last_seq=seq;
+					}
+					if(last_seq==N)
+						return ctx.stop();
+					tick();
+				});
+				sess->req_get.method(boost::beast::http::verb::get);
+				sess->req_get.target("/api/pending/test/"+std::to_string(last_seq));
+				poller.prepare(*sess, ts);
+				helper.do_session(*sess, ctx.get_executor());
+			} else if(!timer_busy) {
+				timer.expires_after(std::chrono::milliseconds{1000});
+				timer_busy=true;
+				timer.async_wait([&](boost::beast::error_code ec) {
+					timer_busy=false;
+					tick();
+				});
+			}
+		};
+		boost::asio::post(ctx, [&]() {
+			publish();
+			tick();
+		});
+		ctx.run_for(std::chrono::seconds{60});
+		if(last_seq!=N || poller.holding()!=long_poll)
+			return std::chrono::microseconds{-1};
+		return std::chrono::duration_cast<std::chrono::microseconds>(latency/N);
+	};
+
+	auto t_poll=handoff(false);
+	auto t_long=handoff(true);
+	gapr::print("mean handoff latency, polling: ", t_poll.count(), "us, long poll: ", t_long.count(), "us");
+	if(t_poll.count()<0 || t_long.count()<0)
+		return -1;
+	if(t_long>=t_poll)
+		return -1;
+	return 0;
+} }
+
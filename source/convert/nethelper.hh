@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <deque>
+#include <chrono>
 
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/context.hpp>
@@ -18,10 +19,23 @@ struct network_helper {
 	std::string host{};
 	std::string port{};
 
+	/*! at most this many connections to the server */
+	unsigned int max_conns{3};
+	/*! requests in flight on one keep-alive connection, 1 disables pipelining */
+	unsigned int pipeline{1};
+	/*! for connecting, and for each read or write */
+	std::chrono::steady_clock::duration timeout{std::chrono::seconds{30}};
+	/*! times a request is resent after its connection stalls or drops */
+	unsigned int max_retries{3};
+
+	boost::asio::io_context::executor_type _ex;
 	boost::asio::ip::tcp::resolver _resolver;
 	boost::asio::ssl::context _ssl_ctx{boost::asio::ssl::context::tlsv12_client};
 	boost::asio::ip::tcp::resolver::results_type addresses;
-	std::vector<std::unique_ptr<boost::beast::ssl_stream<boost::beast::tcp_stream>>> _connections;
+	struct ssl_session_del {
+		void operator()(SSL_SESSION* p) const noexcept { SSL_SESSION_free(p); }
+	};
+	std::unique_ptr<SSL_SESSION, ssl_session_del> _tls_session;
 
 	struct session: public std::enable_shared_from_this<session> {
 		template<typename Cb>
@@ -46,6 +60,9 @@ struct network_helper {
 
 		network_helper* _par{nullptr};
 		bool _put;
+		/*! held by the server, never pipelined behind */
+		bool _long{false};
+		unsigned int _retries{0};
 
 		gapr::mem_file req_file;
 		boost::beast::http::request<mem_file_body> req_put;
@@ -55,16 +72,35 @@ struct network_helper {
 		boost::beast::http::request<boost::beast::http::empty_body> req_get;
 		boost::beast::http::response<mem_file_body> res_get;
 		std::function<void(gapr::mem_file&& file, const boost::beast::http::response_header<>&)> _cb_get;
-
+	};
+	/*! requests are written in order and answered in order, the
+	 * front of each queue is owned by the operation in progress. */
+	struct connection: public std::enable_shared_from_this<connection> {
 		std::unique_ptr<boost::beast::ssl_stream<boost::beast::tcp_stream>> ssl;
-
-		boost::beast::flat_buffer req_buf;
-		boost::beast::flat_buffer res_buf;
-
-		auto& sock() { return *ssl; }
+		boost::beast::flat_buffer buf;
+		std::deque<std::shared_ptr<session>> to_write;
+		std::deque<std::shared_ptr<session>> to_read;
+		bool ready{false};
+		bool keep_alive{false};
+		bool busy_write{false};
+		bool busy_read{false};
+		bool closing{false};
+		bool tls_saved{false};
+		boost::beast::error_code ec{};
+		const char* what{nullptr};
+
+		std::size_t load() const noexcept { return to_write.size()+to_read.size(); }
+		bool held() const noexcept {
+			for(auto& q: {&to_write, &to_read})
+				for(auto& s: *q)
+					if(s->_long)
+						return true;
+			return false;
+		}
 	};
 	std::atomic<unsigned int> _n_active{0};
 	std::deque<std::shared_ptr<session>> _pending;
+	std::vector<std::shared_ptr<connection>> _conns;
 
 	network_helper(boost::asio::io_context& ctx, std::string&& host, std::string&& port);
 	~network_helper();
@@ -73,13 +109,43 @@ struct network_helper {
 		std::cerr << what << ": " << ec.message() << "\n";
 		exit(-1);
 	}
-	void do_shutdown(session& sess);
-	template<bool PUT> void do_read(session& sess);
-	template<bool PUT> void do_send(session& sess);
-	void do_handshake(session& sess);
-	void do_connect(session& sess);
-	template<bool PUT> void do_init(session& sess);
 	void do_session(session& sess, boost::asio::io_context::executor_type ex);
-	void do_session_conn(session& sess, boost::asio::io_context::executor_type ex);
+
+	void do_dispatch();
+	std::shared_ptr<connection> do_open();
+	void do_connect(connection& conn);
+	void do_handshake(connection& conn);
+	void do_write(connection& conn);
+	template<bool PUT> void do_write(connection& conn, session& sess);
+	void do_read(connection& conn);
+	template<bool PUT> void do_read(connection& conn, session& sess);
+	void do_close(connection& conn, boost::beast::error_code ec={}, const char* what=nullptr);
+	void do_retire(connection& conn);
+};
+
+/*! keeps one request for pending jobs in flight.
+ * the server holds it until there are newer jobs (long poll, with
+ * "GaprWait: <seconds>"), servers that answer without the header are
+ * polled at a fixed interval instead. */
+struct pending_poller {
+	/*! how long the server may hold a request, 0 to always poll */
+	std::chrono::seconds wait{0};
+	/*! between polls, if not holding */
+	std::chrono::milliseconds interval{2000};
+
+	bool ready(std::chrono::steady_clock::time_point ts) const noexcept {
+		return !_busy && ts>=_next;
+	}
+	bool holding() const noexcept { return wait.count()>0 && !_fallback; }
+	/*! call before sending the request */
+	void prepare(network_helper::session& sess, std::chrono::steady_clock::time_point ts);
+	/*! call with the response, false if it is to be retried later */
+	bool done(const boost::beast::http::response_header<>& hdr, bool empty, std::chrono::steady_clock::time_point ts);
+
+	bool _busy{false};
+	bool _fallback{false};
+	std::chrono::steady_clock::time_point _start{};
+	std::chrono::steady_clock::time_point _next{};
+	std::chrono::milliseconds _backoff{0};
 };
 
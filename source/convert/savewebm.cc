@@ -17,6 +17,12 @@
 #include <chrono>
 #include <iostream>
 #include <mutex>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
 //#include <sys/stat.h>
 //#include <string.h>
 //#include <libgen.h>
@@ -30,6 +36,7 @@
 #include "gapr/cube.hh"
 #include "gapr/utility.hh"
 #include "gapr/detail/nrrd-output.hh"
+#include "loadtiff.hh"
 //#include "config-fnt.h"
 
 #include <vpx/vpx_encoder.h>
@@ -896,3 +903,200 @@ gapr::mem_file convert_webm(T* data, unsigned int w, unsigned int h, unsigned in
 }
 template gapr::mem_file convert_webm<uint8_t>(uint8_t* data, unsigned int w, unsigned int h, unsigned int d, cube_enc_opts opts);
 template gapr::mem_file convert_webm<uint16_t>(uint16_t* data, unsigned int w, unsigned int h, unsigned int d, cube_enc_opts opts);
+
+/*! synthetic volume for bench_cube_loaders:
+ * smooth blobs plus noise, about as compressible as real data
+ */
+template<typename T>
+static std::vector<T> bench_volume(std::array<unsigned int, 3> sizes, unsigned int maxv) {
+	std::vector<T> data(std::size_t{1}*sizes[0]*sizes[1]*sizes[2]);
+	std::mt19937 rng{1};
+	std::normal_distribution<double> noise{0.0, maxv/64.0};
+	std::size_t i=0;
+	for(unsigned int z=0; z<sizes[2]; z++)
+		for(unsigned int y=0; y<sizes[1]; y++)
+			for(unsigned int x=0; x<sizes[0]; x++) {
+				auto v=std::sin(x*0.05)*std::sin(y*0.07)*std::cos(z*0.03);
+				v=(v*v*0.8+0.05)*maxv+noise(rng);
+				data[i++]=v<0?0:(v>maxv?maxv:static_cast<T>(v));
+			}
+	return data;
+}
+
+static gapr::mem_file bench_mem_file(const char* ptr, std::size_t len) {
+	gapr::mutable_mem_file file{true};
+	std::size_t i=0;
+	while(i<len) {
+		auto buf=file.map_tail();
+		auto n=len-i;
+		if(n>buf.size())
+			n=buf.size();
+		std::copy(&ptr[i], &ptr[i+n], buf.data());
+		i+=n;
+		file.add_tail(n);
+	}
+	return file;
+}
+
+template<typename T>
+static gapr::mem_file bench_encode(std::string_view fmt, std::vector<T>& data, std::array<unsigned int, 3> sizes) {
+	auto [w, h, d]=sizes;
+	if(fmt=="cube.nrrd" || fmt=="cube.gz.nrrd") {
+		std::ostringstream oss;
+		gapr::nrrd_output nrrd{oss, fmt!="cube.nrrd"};
+		nrrd.header();
+		nrrd.finish(data.data(), w, h, d);
+		auto str=oss.str();
+		return bench_mem_file(str.data(), str.size());
+	}
+	if(fmt=="cube.tif" || fmt=="cube.zip.tif") {
+		Tiff tif{"wm"};
+		for(unsigned int z=0; z<d; z++) {
+			TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, w);
+			TIFFSetField(tif, TIFFTAG_IMAGELENGTH, h);
+			TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, sizeof(T)*8);
+			TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+			TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+			TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+			TIFFSetField(tif, TIFFTAG_COMPRESSION, fmt=="cube.tif"?COMPRESSION_NONE:COMPRESSION_ADOBE_DEFLATE);
+			uint32_t rps=TIFFDefaultStripSize(tif, 0);
+			TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rps);
+			for(uint32_t y=0; y<h; y+=rps) {
+				auto n=std::min(rps, h-y);
+				auto ptr=&data[(std::size_t{z}*h+y)*w];
+				if(TIFFWriteEncodedStrip(tif, TIFFComputeStrip(tif, y, 0), ptr, tmsize_t(n)*w*sizeof(T))<0)
+					gapr::report("failed to write strip");
+			}
+			if(!TIFFWriteDirectory(tif))
+				gapr::report("failed to write directory");
+		}
+		if(!TIFFFlush(tif))
+			gapr::report("failed to flush tiff");
+		auto buf=std::move(tif).buffer();
+		return bench_mem_file(buf.data(), buf.size());
+	}
+	if(fmt=="cube.v3draw") {
+		// the loader takes the tag as is, and the fields in host order
+		std::string buf{"raw_image_stack_by_hpengL"};
+		int16_t bpp=sizeof(T);
+		buf.append(reinterpret_cast<const char*>(&bpp), sizeof(bpp));
+		for(int32_t v: {int32_t(w), int32_t(h), int32_t(d), int32_t{1}})
+			buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+		buf.append(reinterpret_cast<const char*>(data.data()), data.size()*sizeof(T));
+		return bench_mem_file(buf.data(), buf.size());
+	}
+	assert(fmt=="cube.webm");
+	return convert_webm<T>(data.data(), w, h, d, {});
+}
+
+/*! decode throughput per format, voxel type and size.
+ * `par' loaders run concurrently (one cube each), `nthr' is the
+ * hint passed to the loader (only webm uses it); peak is the
+ * high-water mark above the resident set before loading.
+ */
+namespace gapr_test { int bench_cube_loaders() {
+	// only resets VmHWM on linux, otherwise peak covers the whole run
+	auto reset_peak=[]() {
+		std::ofstream fs{"/proc/self/clear_refs"};
+		fs<<"5";
+	};
+
+	unsigned int hw=std::thread::hardware_concurrency();
+	if(hw<1)
+		hw=1;
+	std::vector<unsigned int> nthrs{1};
+	if(hw>1)
+		nthrs.push_back(hw);
+	const std::array<unsigned int, 3> all_sizes[]={
+		{128, 128, 128}, {512, 512, 64}, {1024, 1024, 16},
+	};
+	// names double as type hints
+	const char* fmts[]={"cube.nrrd", "cube.gz.nrrd", "cube.tif", "cube.zip.tif", "cube.v3draw", "cube.webm"};
+	constexpr unsigned int rounds=3;
+
+	int ret=0;
+	auto bench=[&](auto tag, std::array<unsigned int, 3> sizes) {
+		using T=decltype(tag);
+		auto data=bench_volume<T>(sizes, sizeof(T)==1?255:4095);
+		std::size_t bytes=data.size()*sizeof(T);
+		for(std::string_view fmt: fmts) {
+			auto file=bench_encode<T>(fmt, data, sizes);
+			if(auto sb=gapr::make_streambuf(gapr::mem_file{file}); !gapr::make_cube_loader(fmt, *sb)) {
+				gapr::print(fmt, ": no loader, skipped");
+				continue;
+			}
+			bool lossless=fmt!="cube.webm";
+			for(auto par: nthrs) {
+				for(auto nthr: nthrs) {
+					if(nthr>1 && lossless)
+						continue;
+					std::vector<std::vector<T>> bufs(par);
+					for(auto& b: bufs)
+						b.resize(data.size());
+					reset_peak();
+					auto rss0=gapr::mem_usage().first;
+					auto t0=std::chrono::steady_clock::now();
+					std::vector<std::thread> thrs;
+					std::vector<std::string> errs(par);
+					for(unsigned int k=0; k<par; k++) {
+						thrs.emplace_back([&,k]() {
+							try {
+								for(unsigned int r=0; r<rounds; r++) {
+									auto sb=gapr::make_streambuf(gapr::mem_file{file});
+									auto loader=gapr::make_cube_loader(fmt, *sb, nthr);
+									if(loader->type()!=gapr::cube_type_from<T>::value)
+										throw std::runtime_error{"wrong type"};
+									if(loader->sizes()!=std::array<int32_t, 3>{int32_t(sizes[0]), int32_t(sizes[1]), int32_t(sizes[2])})
+										throw std::runtime_error{"wrong sizes"};
+									int64_t ystride=sizes[0]*sizeof(T);
+									loader->load(reinterpret_cast<char*>(bufs[k].data()), ystride, ystride*sizes[1]);
+								}
+							} catch(const std::exception& e) {
+								errs[k]=e.what();
+							}
+						});
+					}
+					for(auto& t: thrs)
+						t.join();
+					auto t1=std::chrono::steady_clock::now();
+					auto hwm1=gapr::mem_usage().second;
+					for(auto& e: errs) {
+						if(!e.empty()) {
+							gapr::print(fmt, ": ", e);
+							ret=-1;
+							return;
+						}
+					}
+					double err=0.0;
+					for(auto& b: bufs) {
+						if(lossless) {
+							if(b!=data) {
+								gapr::print(fmt, ": mismatch");
+								ret=-1;
+								return;
+							}
+							continue;
+						}
+						for(std::size_t i=0; i<data.size(); i++)
+							err+=std::abs(double(b[i])-data[i]);
+					}
+					err/=data.size()*par;
+					std::chrono::duration<double> dt=t1-t0;
+					gapr::print(fmt, ' ', sizeof(T)*8, "bit ", sizes[0], 'x', sizes[1], 'x', sizes[2],
+							" (", file.size()*100/bytes, "%) par ", par, " nthr ", nthr, ": ",
+							bytes*par*rounds/dt.count()/1024/1024, "MiB/s, peak +",
+							(hwm1>rss0?hwm1-rss0:0)/1024, "MiB, mean abs err ", err);
+				}
+			}
+		}
+	};
+	for(auto& sizes: all_sizes) {
+		bench(uint8_t{}, sizes);
+		if(ret)
+			return ret;
+		bench(uint16_t{}, sizes);
+		if(ret)
+			return ret;
+	}
+	return 0;
+} }
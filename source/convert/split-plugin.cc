@@ -297,6 +297,11 @@ struct conversion_helper2 {
 		group{std::move(srv.group)},
 		ncpu{ncpu}
 	       	{
+			netaux.max_conns=srv.connections;
+			netaux.pipeline=srv.pipeline;
+			netaux.timeout=std::chrono::seconds{srv.timeout};
+			// leave time for the response within the timeout
+			_poller.wait=std::chrono::seconds{srv.timeout/2};
 		}
 
 
@@ -452,6 +457,14 @@ struct conversion_helper2 {
 		sess->req_get.target(path);
 		netaux.do_session(*sess, _ctx.get_executor());
 	}
+	template<typename Cb>
+	void async_poll(std::string_view path, std::chrono::steady_clock::time_point ts, Cb&& cb) {
+		auto sess=std::make_shared<network_helper::session>(std::forward<Cb>(cb));
+		sess->req_get.method(boost::beast::http::verb::get);
+		sess->req_get.target(path);
+		_poller.prepare(*sess, ts);
+		netaux.do_session(*sess, _ctx.get_executor());
+	}
 
 	void upload_catalog() {
 		std::cerr<<"upload catalog ...";
@@ -782,7 +795,7 @@ struct conversion_helper2 {
 	void add_needed(job_id id, bool loading);
 	void add_suggested(job_id id);
 
-	std::chrono::steady_clock::time_point _last_fetch{};
+	pending_poller _poller{};
 	bool _timer_busy{false};
 	uint64_t _last_sync_needed{0};
 
@@ -808,10 +821,12 @@ struct conversion_helper2 {
 			return;
 
 		auto ts=std::chrono::steady_clock::now();
-		if(std::chrono::duration_cast<std::chrono::milliseconds>(ts-_last_fetch).count()>2000) {
-			_last_fetch=ts;
-			gapr::print("get pending");
-			async_get("/api/pending/"+group+"/"+std::to_string(_last_sync_needed), [this](gapr::mem_file&& file, const auto& hdr) {
+		if(_poller.ready(ts)) {
+			if(!_poller.holding())
+				gapr::print("get pending");
+			async_poll("/api/pending/"+group+"/"+std::to_string(_last_sync_needed), ts, [this](gapr::mem_file&& file, const auto& hdr) {
+				if(!_poller.done(hdr, file.size()==0, std::chrono::steady_clock::now()))
+					return upload_cubes();
 				if(hdr.result()!=boost::beast::http::status::ok)
 					//throw std::runtime_error{std::move(res)};
 					throw std::runtime_error{"asdf"};
@@ -457,6 +457,11 @@ struct conversion_helper {
 		api_root{std::move(srv.api_root)},
 		ncpu{ncpu}
 	       	{
+			netaux.max_conns=srv.connections;
+			netaux.pipeline=srv.pipeline;
+			netaux.timeout=std::chrono::seconds{srv.timeout};
+			// leave time for the response within the timeout
+			_poller.wait=std::chrono::seconds{srv.timeout/2};
 		}
 
 
@@ -707,6 +712,14 @@ struct conversion_helper {
 		sess->req_get.target(api_path(path));
 		netaux.do_session(*sess, _ctx.get_executor());
 	}
+	template<typename Cb>
+	void async_poll(std::string_view path, std::chrono::steady_clock::time_point ts, Cb&& cb) {
+		auto sess=std::make_shared<network_helper::session>(std::forward<Cb>(cb));
+		sess->req_get.method(boost::beast::http::verb::get);
+		sess->req_get.target(api_path(path));
+		_poller.prepare(*sess, ts);
+		netaux.do_session(*sess, _ctx.get_executor());
+	}
 	
 	// void upload_catalog() {
 	// 	std::cerr<<"upload catalog ...";
@@ -1413,7 +1426,7 @@ struct conversion_helper {
 	void add_needed(job_id id, bool loading);
 	void add_suggested(job_id id);
 
-	std::chrono::steady_clock::time_point _last_fetch{};
+	pending_poller _poller{};
 	std::chrono::steady_clock::time_point _last_uploadds{std::chrono::steady_clock::time_point::min()};
 	std::chrono::steady_clock::time_point _last_saveds{};
 	bool _timer_busy{false};
@@ -1441,14 +1454,16 @@ struct conversion_helper {
 			return;
 
 		auto ts=std::chrono::steady_clock::now();
-		if(std::chrono::duration_cast<std::chrono::milliseconds>(ts-_last_fetch).count()>2000) {
-			_last_fetch=ts;
-			gapr::print("get pending");
+		if(_poller.ready(ts)) {
+			if(!_poller.holding())
+				gapr::print("get pending");
 
 			std::string url = "pending/" + group + "/" + std::to_string(_last_sync_needed);
 			Logger::instance().logMessage(__FILE__, "Requesting pending jobs from URL: " + url);
 
-			async_get("pending/"+group+"/"+std::to_string(_last_sync_needed), [this](gapr::mem_file&& file, const auto& hdr) {
+			async_poll("pending/"+group+"/"+std::to_string(_last_sync_needed), ts, [this](gapr::mem_file&& file, const auto& hdr) {
+				if(!_poller.done(hdr, file.size()==0, std::chrono::steady_clock::now()))
+					return upload_cubes();
 				// if(hdr.result()!=boost::beast::http::status::ok){
 				// 	//throw std::runtime_error{std::move(res)};
 				// 	// throw std::runtime_error{"asdf"};
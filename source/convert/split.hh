@@ -28,6 +28,10 @@ struct ServerArgs {
 	unsigned short port{0};
 	std::string group{};
 	std::string api_root{};
+
+	unsigned int connections{3};
+	unsigned int pipeline{1};
+	unsigned int timeout{30};
 };
 
 enum class job_state {
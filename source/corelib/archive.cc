@@ -1,6 +1,8 @@
 #include "gapr/archive.hh"
 
 #include <mutex>
+#include <cstring>
+#include <filesystem>
 
 #include <lmdb.h>
 
@@ -111,6 +113,7 @@ struct archive::PRIV {
 
 	struct WriterImpl;
 	struct ReaderImpl;
+	struct ViewImpl;
 	class ArchiveIn;
 };
 
@@ -332,6 +335,59 @@ std::pair<const char*, std::size_t> archive::reader::do_buffer() {
 	return static_cast<PRIV::ReaderImpl*>(_p.get())->do_buffer2();
 }
 
+struct archive::PRIV::ViewImpl: view_DATA {
+	std::shared_ptr<PRIV> _ref;
+	std::unique_ptr<MDB_txn, mdb_txn_deleter> _txn;
+
+	ViewImpl(const std::shared_ptr<PRIV>& apriv):
+		view_DATA{{}, 0, 0}, _ref{apriv} { }
+	~ViewImpl() { }
+
+	bool map_chunks(std::string_view key) {
+		MDB_txn* txn;
+		if(auto r=mdb_txn_begin(_ref->_env.get(), nullptr, MDB_RDONLY, &txn); r!=0)
+			gapr::report("error txn_begin: ", r);
+		_txn.reset(txn);
+		MDB_cursor* cursor;
+		if(auto r=mdb_cursor_open(txn, _ref->_dbi, &cursor); r!=0)
+			gapr::report("error cursor_open: ", r);
+		std::unique_ptr<MDB_cursor, mdb_cursor_deleter> cursor_{cursor};
+		std::array<char, 512> keybuf;
+		auto key_len=key.size();
+		if(key_len+9>keybuf.size())
+			key_len=keybuf.size()-9;
+		std::memcpy(&keybuf[0], key.data(), key_len);
+		std::size_t off=0;
+		do {
+			auto offset_len=update_offset(&keybuf[key_len], keybuf.size()-key_len, off);
+			MDB_val key{key_len+offset_len, keybuf.data()};
+			MDB_val data;
+			if(auto r=mdb_cursor_get(cursor, &key, &data, MDB_SET_KEY); r!=0) {
+				if(r==MDB_NOTFOUND && off==0)
+					return false;
+				gapr::report("error cursor_get: ", r);
+			}
+			auto ptr=static_cast<const char*>(data.mv_data);
+			assert(ptr[0]=='\x00' || ptr[0]=='\xff');
+			if(data.mv_size>1)
+				_chunks.emplace_back(ptr+1, data.mv_size-1);
+			if(!ptr[0])
+				return true;
+			off+=data.mv_size-1;
+		} while(true);
+	}
+};
+
+archive::view::view(const std::shared_ptr<PRIV>& apriv, std::string_view key): _p{}
+{
+	auto p=std::make_unique<PRIV::ViewImpl>(apriv);
+	if(p->map_chunks(key))
+		_p=std::move(p);
+}
+archive::view::~view() {
+	std::unique_ptr<PRIV::ViewImpl> p{static_cast<PRIV::ViewImpl*>(_p.release())};
+}
+
 #if 0
 // XXX reopen a reader
 void reopen() cno {
@@ -446,3 +502,54 @@ std::unique_ptr<std::streambuf> archive::reader_streambuf(std::string_view key)
 	return std::make_unique<gapr::Streambuf_Input<archive::PRIV::ArchiveIn>>(std::move(p));
 }
 
+
+namespace gapr_test { int chk_archive_view() {
+	auto path=std::filesystem::temp_directory_path()/"gapr-chk-archive-view";
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	int ret=0;
+	{
+		gapr::archive repo{path.string().c_str()};
+		// chunks hold 64K-16 bytes, minus the flag
+		constexpr std::size_t chunk=64*1024-17;
+		std::size_t sizes[]={0, 1, 1000, chunk-1, chunk, chunk+1, chunk*3+77};
+		for(auto siz: sizes) {
+			std::string str(siz, '\0');
+			for(std::size_t i=0; i<siz; i++)
+				str[i]=static_cast<char>(i*131+siz);
+			auto key=std::to_string(siz);
+			auto ofs=repo.get_writer(key);
+			for(std::size_t i=0; i<siz;) {
+				auto [buf, n]=ofs.buffer();
+				n=std::min(n, siz-i);
+				std::memcpy(buf, &str[i], n);
+				ofs.commit(n);
+				i+=n;
+			}
+			if(!ofs.flush())
+				gapr::report("failed to flush");
+
+			std::string a, b;
+			auto view=repo.get_view(key);
+			for(auto [buf, n]=view.buffer(); buf; std::tie(buf, n)=view.buffer()) {
+				// uneven steps across chunk ends
+				n=std::min(n, std::size_t{4099});
+				a.append(buf, n);
+				view.consume(n);
+			}
+			auto sbuf=repo.reader_streambuf(key);
+			char tmp[4096];
+			while(auto n=sbuf->sgetn(tmp, sizeof(tmp)))
+				b.append(tmp, n);
+			if(a!=str || b!=str) {
+				gapr::print("view mismatch: ", siz);
+				ret=-1;
+			}
+		}
+		if(repo.get_view("missing"))
+			ret=-1;
+	}
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	return ret;
+} }
@@ -22,13 +22,232 @@
 #include "gapr/mem-file.hh"
 #include "gapr/utility.hh"
 
+#include <algorithm>
 #include <new>
 #include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 
 using gapr::buffer_PRIV;
 using gapr::mem_file_PRIV;
 
+/*! fixed size blocks for mem_file are recycled through a per-thread
+ * cache in front of a shared free list, instead of new/delete each.
+ * with GAPR_HUGEPAGES=1 (linux), large blocks are carved from 2MB
+ * huge-page slabs, which are kept for the lifetime of the process.
+ */
+namespace {
+
+	constexpr std::size_t HUGE_SLAB=2*1024*1024;
+
+	class block_pool {
+		public:
+			block_pool(std::size_t blk_siz, std::size_t max_cached, bool huge) noexcept:
+				_blk_siz{blk_siz}, _max_cached{max_cached}, _huge{huge} { }
+			block_pool(const block_pool&) =delete;
+			block_pool& operator=(const block_pool&) =delete;
+
+			bool huge() const noexcept { return _huge; }
+
+			/*! move up to n blocks into out, return number of blocks */
+			std::size_t get(void** out, std::size_t n) {
+				std::size_t i=0;
+				{
+					std::lock_guard lck{_mtx};
+					while(i<n && _free) {
+						out[i++]=pop();
+					}
+					if(i>0)
+						return i;
+					if(_huge)
+						return refill_huge(out, n);
+				}
+				out[0]=::operator new(_blk_siz);
+				_sys_allocs.fetch_add(1, std::memory_order_relaxed);
+				return 1;
+			}
+			void put(void** blks, std::size_t n) noexcept {
+				std::size_t i=0;
+				{
+					std::lock_guard lck{_mtx};
+					// huge-page blocks are never returned to the system
+					for(; i<n && (_huge || _nfree<_max_cached); i++)
+						push(blks[i]);
+				}
+				for(; i<n; i++) {
+					::operator delete(blks[i]);
+					_sys_frees.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+			void count(uint64_t nalloc, uint64_t nfree) noexcept {
+				if(nalloc)
+					_allocs.fetch_add(nalloc, std::memory_order_relaxed);
+				if(nfree)
+					_frees.fetch_add(nfree, std::memory_order_relaxed);
+			}
+			gapr::mem_file_stats::tier stats() noexcept {
+				gapr::mem_file_stats::tier st;
+				st.block_size=_blk_siz;
+				st.allocs=_allocs.load(std::memory_order_relaxed);
+				st.frees=_frees.load(std::memory_order_relaxed);
+				st.sys_allocs=_sys_allocs.load(std::memory_order_relaxed);
+				st.sys_frees=_sys_frees.load(std::memory_order_relaxed);
+				std::lock_guard lck{_mtx};
+				st.cached=_nfree;
+				return st;
+			}
+
+		private:
+			const std::size_t _blk_siz;
+			const std::size_t _max_cached;
+			const bool _huge;
+			std::mutex _mtx;
+			// free blocks are linked through their first word
+			void* _free{nullptr};
+			std::size_t _nfree{0};
+			std::atomic<uint64_t> _allocs{0};
+			std::atomic<uint64_t> _frees{0};
+			std::atomic<uint64_t> _sys_allocs{0};
+			std::atomic<uint64_t> _sys_frees{0};
+
+			void push(void* p) noexcept {
+				*static_cast<void**>(p)=_free;
+				_free=p;
+				_nfree++;
+			}
+			void* pop() noexcept {
+				auto p=_free;
+				_free=*static_cast<void**>(p);
+				_nfree--;
+				return p;
+			}
+			std::size_t refill_huge(void** out, std::size_t n) {
+				auto slab=static_cast<char*>(std::aligned_alloc(HUGE_SLAB, HUGE_SLAB));
+				if(!slab)
+					throw std::bad_alloc{};
+#ifdef MADV_HUGEPAGE
+				::madvise(slab, HUGE_SLAB, MADV_HUGEPAGE);
+#endif
+				auto nblk=HUGE_SLAB/_blk_siz;
+				_sys_allocs.fetch_add(nblk, std::memory_order_relaxed);
+				std::size_t i=0;
+				for(; i<n && i<nblk; i++)
+					out[i]=slab+i*_blk_siz;
+				for(auto j=i; j<nblk; j++)
+					push(slab+j*_blk_siz);
+				return i;
+			}
+	};
+
+	bool use_huge_pages() noexcept {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		auto p=std::getenv("GAPR_HUGEPAGES");
+		return p && std::strcmp(p, "1")==0;
+#else
+		return false;
+#endif
+	}
+
+	/*! leaked, to stay valid for thread_local destructors run at exit */
+	block_pool& get_pool(unsigned int tier) noexcept {
+		static block_pool* pools[2]={
+			new block_pool{mem_file_PRIV::BLK_SIZ1, 4096, false},
+			new block_pool{mem_file_PRIV::BLK_SIZ2, 256, use_huge_pages()},
+		};
+		return *pools[tier];
+	}
+
+	// set once the cache of this thread is destroyed at thread exit
+	thread_local bool _thread_cache_gone{false};
+
+	class thread_cache {
+		public:
+			static constexpr std::size_t MAX_BLKS[2]={64, 8};
+			constexpr thread_cache() noexcept { }
+			~thread_cache() {
+				_thread_cache_gone=true;
+				for(unsigned int t=0; t<2; t++) {
+					get_pool(t).put(_blks[t], _n[t]);
+					flush_counts(t);
+				}
+			}
+			void* alloc(unsigned int t) {
+				if(_n[t]==0) {
+					flush_counts(t);
+					_n[t]=get_pool(t).get(_blks[t], MAX_BLKS[t]/2);
+				}
+				_nalloc[t]++;
+				return _blks[t][--_n[t]];
+			}
+			void free(unsigned int t, void* p) noexcept {
+				if(_n[t]>=MAX_BLKS[t]) {
+					auto n=MAX_BLKS[t]/2;
+					_n[t]-=n;
+					get_pool(t).put(&_blks[t][_n[t]], n);
+					flush_counts(t);
+				}
+				_nfree[t]++;
+				_blks[t][_n[t]++]=p;
+			}
+			void flush_counts(unsigned int t) noexcept {
+				get_pool(t).count(_nalloc[t], _nfree[t]);
+				_nalloc[t]=_nfree[t]=0;
+			}
+
+		private:
+			void* _blks[2][MAX_BLKS[0]]{};
+			std::size_t _n[2]{0, 0};
+			uint64_t _nalloc[2]{0, 0};
+			uint64_t _nfree[2]{0, 0};
+	};
+	thread_local thread_cache _thread_cache;
+
+	inline unsigned int tier_of(std::size_t siz) noexcept {
+		assert(siz==mem_file_PRIV::BLK_SIZ1 || siz==mem_file_PRIV::BLK_SIZ2);
+		return siz==mem_file_PRIV::BLK_SIZ1?0:1;
+	}
+	inline char* alloc_block(std::size_t siz) {
+		auto t=tier_of(siz);
+		if(_thread_cache_gone) {
+			void* p{nullptr};
+			get_pool(t).get(&p, 1);
+			get_pool(t).count(1, 0);
+			return static_cast<char*>(p);
+		}
+		return static_cast<char*>(_thread_cache.alloc(t));
+	}
+	inline void free_block(void* p, std::size_t siz) noexcept {
+		auto t=tier_of(siz);
+		if(_thread_cache_gone) {
+			get_pool(t).put(&p, 1);
+			get_pool(t).count(0, 1);
+			return;
+		}
+		_thread_cache.free(t, p);
+	}
+
+}
+
+gapr::mem_file_stats gapr::get_mem_file_stats() noexcept {
+	if(!_thread_cache_gone) {
+		for(unsigned int t=0; t<2; t++)
+			_thread_cache.flush_counts(t);
+	}
+	// counts cached by other threads are flushed lazily
+	mem_file_stats st;
+	for(unsigned int t=0; t<2; t++)
+		st.tiers[t]=get_pool(t).stats();
+	st.huge_pages=get_pool(1).huge();
+	return st;
+}
+
 buffer_PRIV::Head* buffer_PRIV::alloc(uint32_t len) {
 	auto buf=new char[sizeof(buffer_PRIV::Head)+len];
 	auto ptr=buf+sizeof(buffer_PRIV::Head);
@@ -41,21 +260,29 @@ void buffer_PRIV::destroy(Head* p) noexcept {
 
 mem_file_PRIV::Head* mem_file_PRIV::alloc(bool flat) {
 	static_assert(BLK_SIZ1>=sizeof(char*)+sizeof(Head));
-	auto buf=new char[BLK_SIZ1];
+	auto buf=alloc_block(BLK_SIZ1);
 	if(flat)
 		return new(buf+BLK_SIZ1-sizeof(Head)) Head{BLK_SIZ1-sizeof(Head), buf};
 	return new(buf) Head{buf+sizeof(Head), (BLK_SIZ1-sizeof(Head))/sizeof(char*)};
 }
+void mem_file_PRIV::free_index(Head* p) noexcept {
+	// the index array grows out of its first block
+	auto sz=sizeof(Head)+p->max_count*sizeof(char*);
+	p->~Head();
+	if(sz<=BLK_SIZ1)
+		free_block(p, BLK_SIZ1);
+	else
+		delete[] reinterpret_cast<char*>(p);
+}
 void mem_file_PRIV::destroy(Head* p) noexcept {
 	if(p->is_flat()) {
 		auto buf=p->_ptr;
 		p->~Head();
-		delete[] static_cast<char*>(buf);
+		free_block(buf, BLK_SIZ1);
 	} else {
 		for(std::size_t i=0; i<p->count; i++)
-			delete[] static_cast<char**>(p->_ptr)[i];
-		p->~Head();
-		delete[] reinterpret_cast<char*>(p);
+			free_block(static_cast<char**>(p->_ptr)[i], i<COUNT_OPT?BLK_SIZ1:BLK_SIZ2);
+		free_index(p);
 	}
 }
 
@@ -93,7 +320,7 @@ gapr::buffer_view gapr::mutable_mem_file::map_tail() {
 			return {static_cast<char*>(_p->_ptr)+len, mem_file_PRIV::BLK_SIZ1-sizeof(mem_file_PRIV::Head)-len};
 		}
 
-		auto buf=new char[mem_file_PRIV::BLK_SIZ1];
+		auto buf=alloc_block(mem_file_PRIV::BLK_SIZ1);
 		auto p=new(buf) mem_file_PRIV::Head{buf+sizeof(mem_file_PRIV::Head), (mem_file_PRIV::BLK_SIZ1-sizeof(mem_file_PRIV::Head))/sizeof(char*)};
 		p->count=1;
 		auto len=p->len=_p->len;
@@ -119,14 +346,68 @@ gapr::buffer_view gapr::mutable_mem_file::map_tail() {
 		p->len=_p->len;
 		for(std::size_t i=0; i<cnt; i++)
 			static_cast<char**>(p->_ptr)[i]=static_cast<char**>(_p->_ptr)[i];
-		_p->~Head();
-		delete[] reinterpret_cast<char*>(_p);
+		mem_file_PRIV::free_index(_p);
 		_p=p;
 	}
 	auto sz=cnt<mem_file_PRIV::COUNT_OPT?mem_file_PRIV::BLK_SIZ1:mem_file_PRIV::BLK_SIZ2;
-	auto buf=new char[sz];
+	auto buf=alloc_block(sz);
 	static_cast<char**>(_p->_ptr)[cnt]=buf;
 	_p->count++;
 	_p->ntail=sz;
 	return {buf, sz};
 }
+
+namespace gapr_test { int chk_mem_file_pool() {
+	auto fill=[](std::size_t len, unsigned int seed) {
+		gapr::mutable_mem_file file{true};
+		std::size_t i=0;
+		while(i<len) {
+			auto buf=file.map_tail();
+			auto n=std::min(buf.size(), len-i);
+			for(std::size_t j=0; j<n; j++)
+				buf.data()[j]=static_cast<char>((i+j)*seed);
+			file.add_tail(n);
+			i+=n;
+		}
+		return gapr::mem_file{std::move(file)};
+	};
+	auto check=[](const gapr::mem_file& file, std::size_t len, unsigned int seed) {
+		if(file.size()!=len)
+			return false;
+		std::size_t i=0;
+		while(i<len) {
+			auto buf=file.map(i);
+			for(std::size_t j=0; j<buf.size(); j++)
+				if(buf[j]!=static_cast<char>((i+j)*seed))
+					return false;
+			i+=buf.size();
+		}
+		return true;
+	};
+
+	auto st0=gapr::get_mem_file_stats();
+	std::vector<std::size_t> sizes{0, 1, 4000, 4096, 5000, 1024*1024, 5*1024*1024+7};
+	for(unsigned int k=0; k<3; k++) {
+		std::vector<gapr::mem_file> files;
+		for(std::size_t i=0; i<sizes.size(); i++)
+			files.push_back(fill(sizes[i], i+k+1));
+		for(std::size_t i=0; i<sizes.size(); i++) {
+			if(!check(files[i], sizes[i], i+k+1)) {
+				gapr::print("mem_file content mismatch: ", sizes[i]);
+				return -1;
+			}
+		}
+	}
+	auto st1=gapr::get_mem_file_stats();
+	for(unsigned int t=0; t<2; t++) {
+		auto& a=st0.tiers[t];
+		auto& b=st1.tiers[t];
+		gapr::print("tier ", b.block_size, ": ", b.allocs-a.allocs, " allocs, ", b.sys_allocs-a.sys_allocs, " from system, ", b.cached, " cached");
+		if(b.allocs-a.allocs!=b.frees-a.frees)
+			return -1;
+	}
+	// the later rounds should be served from the pool
+	if(st1.tiers[1].sys_allocs-st0.tiers[1].sys_allocs>=st1.tiers[1].allocs-st0.tiers[1].allocs)
+		return -1;
+	return 0;
+} }
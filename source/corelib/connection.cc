@@ -26,6 +26,7 @@
 
 //#include <random>
 #include <algorithm>
+#include <vector>
 
 #include <boost/asio/read.hpp>
 #include <boost/asio/ssl/error.hpp>
@@ -57,8 +58,34 @@ enum ChrCode: unsigned char {
 	CodeMsgEnd=0b0011'0000,
 
 	CodeIsEof=0b0001'0000,
+	CodeLongChk=0b0010'0000, // 32-bit chunk length (gapr/1.2)
 };
 
+// preferred first, gapr/1.2 takes chunks up to MAX_CHUNK_LARGE,
+// gapr/1.3 also puts stream ids in the seq bytes
+static constexpr unsigned char priv_protos[]={
+	8, 'g', 'a', 'p', 'r', '/', '1', '.', '3',
+	8, 'g', 'a', 'p', 'r', '/', '1', '.', '2',
+	8, 'g', 'a', 'p', 'r', '/', '1', '.', '1'
+};
+
+/*! minor version of gapr/1.x, 0 if no protocol of ours is selected */
+static unsigned int negotiated_proto(SSL* ssl) noexcept {
+	const unsigned char* alpn_ptr;
+	unsigned int alpn_len;
+	::SSL_get0_alpn_selected(ssl, &alpn_ptr, &alpn_len);
+	for(std::size_t i=0; i<sizeof(priv_protos); i+=1+priv_protos[i]) {
+		auto p=&priv_protos[i+1];
+		if(std::equal(alpn_ptr, alpn_ptr+alpn_len, p, p+priv_protos[i]))
+			return p[priv_protos[i]-1]-'0';
+	}
+	return 0;
+}
+static inline void apply_proto(impl& conn, unsigned int minor) noexcept {
+	conn._max_chunk=minor>=2?impl::MAX_CHUNK_LARGE:impl::MAX_CHUNK;
+	conn._mux=minor>=3;
+}
+
 impl::impl(socket&& sock, ssl_context& ssl_ctx):
 	_st0{ConnStPreHs}, _st1{ConnStPreHs}, _ops_valid{true},
 	_refc{(1<<BIT_COUNT)+(1<<BIT_OPEN)}, _ssl{new ssl_stream{std::move(sock), ssl_ctx}}, _ops{}
@@ -68,6 +95,9 @@ impl::impl(std::shared_ptr<ssl_stream> ssl, bool srv):
 	_refc{(1<<BIT_COUNT)+(1<<BIT_OPEN)}, _ssl{std::move(ssl)}, _ops{}
 {
 	_is_srv=srv;
+	// without ALPN (handshake done by the caller), assume an old peer
+	if(auto minor=negotiated_proto(_ssl->native_handle()))
+		apply_proto(*this, minor);
 	//op->wptr.end();
 	_recv_st=0;
 	//op->complete(ec);
@@ -143,10 +173,6 @@ static inline bool check_hdr_len(std::size_t len, bs::error_code& ec) noexcept {
 }
 	
 
-static constexpr unsigned char priv_protos[]={
-	8, 'g', 'a', 'p', 'r', '/', '1', '.', '1'
-};
-
 void impl::do_handshake_cli(std::unique_ptr<CliHsOp>&& op) {
 	Lock lck_{this};
 	bs::error_code ec;
@@ -176,16 +202,14 @@ void impl::do_handshake_cli(std::unique_ptr<CliHsOp>&& op) {
 							//ec=ba::error::operation_aborted;
 							//break;
 						//}
-						const unsigned char* alpn_ptr;
-						unsigned int alpn_len;
-						::SSL_get0_alpn_selected(_ssl->native_handle(), &alpn_ptr, &alpn_len);
-						std::cerr<<"alpn: "<<alpn_len<<'\n';
-						if(!std::equal(alpn_ptr, alpn_ptr+alpn_len, priv_protos+1, &priv_protos[sizeof(priv_protos)])) {
+						auto minor=negotiated_proto(_ssl->native_handle());
+						if(!minor) {
 							_st0=_st1=ConnStErr;
 							// XXX
 							ec=ba::error::no_protocol_option;
 							break;
 						}
+						apply_proto(*this, minor);
 						_recv_off=0;
 						_recv_buf[0]='*';
 						_recv_buf[1]='x';
@@ -237,24 +261,30 @@ enum ReqStates: unsigned char {
 
 static inline void fix_seq(impl::SendHdrOp& op) noexcept;
 
-inline void check_if_done(impl* ptr) {
-	auto& inst=ptr->_insts;
-	gapr::print("check : ", ": ", inst.st0+0, " ", inst.st1+0);
+inline void check_if_done(impl* ptr, uint16_t sid) {
+	auto& st=ptr->stream(sid);
+	auto& inst=st.insts;
+	gapr::print("check : ", sid, ": ", inst.st0+0, " ", inst.st1+0);
 	// XXX closing state is sufficient?
 	if(inst.st0==ReqStClose && inst.st1==ReqStClose) {
 		gapr::print("inst close terminal");
 		inst.st1=inst.st0=ReqStInit;
-		if(auto op=std::move(ptr->_ops.delayed_recv)) {
-			assert(!ptr->_ops.recv);
-			ptr->_ops.recv=std::move(op);
-		}
-		if(ptr->_ops.recv) {
-			inst.st0=ReqStOpening;
+		if(!ptr->_mux) {
+			if(auto op=std::move(ptr->_ops.delayed_recv)) {
+				assert(!ptr->_ops.recv);
+				ptr->_ops.recv=std::move(op);
+			}
+			if(ptr->_ops.recv) {
+				inst.st0=ReqStOpening;
+			}
 		}
 		if(gapr::connection::impl::WeakPtr<true, false, false> wptr{ptr})
 			ptr->gapr::connection::impl::do_recv_impl(std::move(wptr), true);
-		if(auto op=std::move(ptr->_ops.delayed_req)) {
-			ptr->_insts.st1=ReqStOpening;
+		if(!st.delayed_req.empty()) {
+			auto op=std::move(st.delayed_req.front());
+			st.delayed_req.pop_front();
+			inst.st1=ReqStOpening;
+			ptr->set_expect(st, true);
 			gapr::print("delayed chain");
 			fix_seq(*op);
 			ptr->_ops.send_que1.push_back(std::move(op));
@@ -301,6 +331,45 @@ static inline bool check_st_recv_reply(int st, bs::error_code& ec) noexcept {
 }
 
 
+uint16_t impl::do_fork() {
+	Lock lck_{this};
+	if(!_mux)
+		return 0;
+	if(_ops.streams.size()>=SWEEP_STREAMS)
+		sweep_streams();
+	do {
+		++_next_sid;
+	} while(_next_sid==0 || _ops.streams.count(_next_sid));
+	stream(_next_sid);
+	return _next_sid;
+}
+
+/*! a swept id in use by some handle is simply created again */
+void impl::sweep_streams() noexcept {
+	for(auto it=_ops.streams.begin(); it!=_ops.streams.end();) {
+		auto& st=it->second;
+		if(it->first!=0 && st.insts.st0==ReqStInit && st.insts.st1==ReqStInit
+				&& !st.recv_reply && !st.read && st.delayed_req.empty()
+				&& !st.expect && !st.has_hdr && st.body.empty() && !st.body_eof)
+			it=_ops.streams.erase(it);
+		else
+			++it;
+	}
+}
+
+/*! hands a message held for the stream to the op */
+void impl::do_recv_pending(std::unique_ptr<RecvHdrOp>&& op, uint16_t sid) {
+	auto& st=stream(sid);
+	op->set_info(sid, st.hdr_misc);
+	st.insts.st0=st.hdr_has_body?ReqStOpen:ReqStClose;
+	st.has_hdr=false;
+	ba::post(sock().get_executor(), [op=std::move(op),hdr=st.hdr_info,line=std::move(st.hdr_line)]() mutable {
+		hdr.ptr=line.c_str();
+		op->complete({}, reinterpret_cast<msg_hdr_in&>(hdr));
+	});
+	check_if_done(this, sid);
+}
+
 void impl::do_recv_req(std::unique_ptr<RecvHdrOp>&& op) {
 	gapr::print("do_recv_req");
 	Lock lck_{this};
@@ -312,15 +381,28 @@ void impl::do_recv_req(std::unique_ptr<RecvHdrOp>&& op) {
 			ec=ba::error::in_progress;
 			break;
 		}
-		if(_insts.st0!=ReqStInit || _insts.st1!=ReqStInit) {
+		if(_mux) {
+			if(!_ops.pending_reqs.empty()) {
+				auto sid=_ops.pending_reqs.front();
+				_ops.pending_reqs.pop_front();
+				do_recv_pending(std::move(op), sid);
+			} else {
+				_ops.recv=std::move(op);
+			}
+			if(WeakPtr<true, false, false> wptr{this})
+				do_recv_impl(std::move(wptr), true);
+			return;
+		}
+		auto& inst=stream(0).insts;
+		if(inst.st0!=ReqStInit || inst.st1!=ReqStInit) {
 			assert(!_ops.delayed_recv);
 			_ops.delayed_recv=std::move(op);
 			return;
 		}
-		assert(_insts.st0==ReqStInit && _insts.st1==ReqStInit);
+		assert(inst.st0==ReqStInit && inst.st1==ReqStInit);
 		_ops.recv=std::move(op);
-		if(_insts.st0==ReqStInit)
-			_insts.st0=ReqStOpening;
+		if(inst.st0==ReqStInit)
+			inst.st0=ReqStOpening;
 		if(WeakPtr<true, false, false> wptr{this})
 			do_recv_impl(std::move(wptr), true);
 		return;
@@ -331,22 +413,25 @@ void impl::do_recv_req(std::unique_ptr<RecvHdrOp>&& op) {
 	});
 }
 
-void impl::do_recv_reply(std::unique_ptr<RecvHdrOp>&& op) {
+void impl::do_recv_reply(std::unique_ptr<RecvHdrOp>&& op, uint16_t sid) {
 	Lock lck_{this};
 	bs::error_code ec;
 	do {
 		if(!check_st_recv_reply(_st0, ec))
 			break;
-		gapr::print("do_recv_reply: ");
-		if(_ops.recv_reply) {
+		gapr::print("do_recv_reply: ", sid);
+		auto& st=stream(sid);
+		if(st.recv_reply) {
 			ec=ba::error::in_progress;
 			break;
 		}
-		assert(_insts.st1>=ReqStOpen);
-		assert(_insts.st0==ReqStInit);
-		_ops.recv_reply=std::move(op);
+		assert(st.insts.st1>=ReqStOpen);
+		assert(st.insts.st0==ReqStInit);
+		if(st.has_hdr)
+			return do_recv_pending(std::move(op), sid);
+		st.recv_reply=std::move(op);
 		_recv_ops_reply_n++;
-		_insts.st0=ReqStOpening;
+		st.insts.st0=ReqStOpening;
 		if(WeakPtr<true, false, false> wptr{this})
 			do_recv_impl(std::move(wptr), true);
 		return;
@@ -376,7 +461,7 @@ static inline bool check_st_send(int st, bs::error_code& ec) noexcept {
 }
 
 static inline void fix_seq(impl::SendHdrOp& op) noexcept {
-	uint16_t seq=0;
+	uint16_t seq=op.sid;
 	auto p=&op.hdr.data()[op.hdr_len];
 	auto type=p[0];
 	auto seq0=static_cast<unsigned char>(seq>>8);
@@ -387,7 +472,7 @@ static inline void fix_seq(impl::SendHdrOp& op) noexcept {
 	p[2]=seq1;
 }
 
-void impl::do_send_req(std::unique_ptr<SendHdrOp>&& op) {
+void impl::do_send_req(std::unique_ptr<SendHdrOp>&& op, uint16_t sid) {
 	gapr::print("do_send_req");
 	Lock lck_{this};
 	bs::error_code ec;
@@ -396,14 +481,16 @@ void impl::do_send_req(std::unique_ptr<SendHdrOp>&& op) {
 			break;
 		if(!check_hdr_len(op->hdr_len, ec))
 			break;
-		if(_insts.st1!=ReqStInit || _insts.st0!=ReqStInit) {
-			assert(!_ops.delayed_req);
-			_ops.delayed_req=std::move(op);
+		auto& st=stream(sid);
+		op->sid=sid;
+		if(st.insts.st1!=ReqStInit || st.insts.st0!=ReqStInit) {
+			st.delayed_req.push_back(std::move(op));
 			return;
 		}
-		assert(_insts.st1==ReqStInit);
+		assert(st.insts.st1==ReqStInit);
 		//chainedN
-		_insts.st1=ReqStOpening;
+		st.insts.st1=ReqStOpening;
+		set_expect(st, true);
 
 		gapr::print("immed chain");
 		fix_seq(*op);
@@ -428,7 +515,7 @@ void impl::do_send_req(std::unique_ptr<SendHdrOp>&& op) {
 					//if(buf.size()>impl::MAX_CHUNK)
 						//throw;
 					//auto seq=_ptr->_insts[_idx-1].seq;
-void impl::do_send_res(std::unique_ptr<SendHdrOp>&& op) {
+void impl::do_send_res(std::unique_ptr<SendHdrOp>&& op, uint16_t sid) {
 	gapr::print("do_send_res");
 	Lock lck_{this};
 	bs::error_code ec;
@@ -437,12 +524,14 @@ void impl::do_send_res(std::unique_ptr<SendHdrOp>&& op) {
 			break;
 		if(!check_hdr_len(op->hdr_len, ec))
 			break;
-		assert(_insts.st0>=ReqStOpen);
-		assert(_insts.st1==ReqStInit);
+		auto& st=stream(sid);
+		assert(st.insts.st0>=ReqStOpen);
+		assert(st.insts.st1==ReqStInit);
+		op->sid=sid;
 		fix_seq(*op);
 		//fprintf(stderr, "DDD %p: ENQ4 %hd:%hd\n", this, op->seq(), op->idx);
 		_ops.send_que1.push_back(std::move(op));
-		_insts.st1=ReqStOpening;
+		st.insts.st1=ReqStOpening;
 		if(WeakPtr<false, true, false> wptr{this})
 			do_send_impl_que1(std::move(wptr));
 		return;
@@ -477,8 +566,8 @@ void impl::do_send_impl_que1(WeakPtr<false, true, false>&& wptr) {
 							assert(nbytes==op->hdr.size());
 							auto is_str=op->type==SendOp::StrmHdr;
 							gapr::print("cc");
-							_insts.st1=is_str?ReqStOpen:ReqStClose;
-							check_if_done(this);
+							stream(op->sid).insts.st1=is_str?ReqStOpen:ReqStClose;
+							check_if_done(this, op->sid);
 							gapr::print("dd");
 							//Ptr ptr{wptr};
 							//if(!ptr) {
@@ -511,8 +600,8 @@ void impl::do_send_impl_que1(WeakPtr<false, true, false>&& wptr) {
 							//assert(nbytes==op->hdr.size());
 
 							gapr::print("aa");
-							_insts.st1=ReqStClose;
-							check_if_done(this);
+							stream(op->sid).insts.st1=ReqStClose;
+							check_if_done(this, op->sid);
 							gapr::print("bb");
 							//Ptr ptr{wptr};
 							//if(!ptr) {
@@ -524,63 +613,103 @@ void impl::do_send_impl_que1(WeakPtr<false, true, false>&& wptr) {
 			}
 			break;
 		case SendOp::Chunk:
-			{
-				auto op=wptr->_ops.send_que1.take_front<SendChkOp>();
-				op->wptr.relay(std::move(wptr));
-				std::size_t towrite;
-				if(op->buf.size()<=MAX_CHUNK) {
-					if(op->eof)
-						op->hdr[0]|=CodeIsEof;
-					towrite=op->buf.size();
-				} else {
-					towrite=MAX_CHUNK;
-				}
-				op->hdr[3]=(towrite>>8);
-				op->hdr[4]=(towrite&0xFF);
-				std::array<ba::const_buffer, 2> bufs={
-					ba::const_buffer{&op->hdr[0], op->hdr.size()},
-					ba::const_buffer{op->buf.data(), towrite}
-				};
-				//if(op->hdr[0]&CodeIsEof)
-					//fprintf(stderr, "DDD %p: CHK %hd:%hd }\n", this, op->seq(), op->idx);
-				//else
-					//fprintf(stderr, "DDD %p: CHK %hd:%hd .\n", this, op->seq(), op->idx);
-				return ba::async_write(sock(), bufs,
-						[op=std::move(op),this,towrite](error_code ec, std::size_t nbytes) mutable {
-							if(ec) {
-								_st1=ConnStErr;
-								op->wptr.end();
-								return op->complete(ec);
-							}
-
-							assert(nbytes==op->hdr.size()+towrite);
-							op->nwrite+=towrite;
-							op->buf.remove_prefix(towrite);
-							if(op->buf.size()>0) {
-								auto wptr=std::move(op->wptr);
-								wptr->_ops.send_que1.push_back(std::move(op));
-								return do_send_impl_next(std::move(wptr));
-							}
-							if(op->eof) {
-								_insts.st1=ReqStClose;
-								check_if_done(this);
-							}
-							//
-							///////////////
-							//Ptr ptr{wptr};
-							//if(!ptr)
-							//return;// XXX
-							do_send_impl_next(std::move(op->wptr));
-							op->complete(ec);
-						});
-			}
-			break;
+			return do_send_impl_chk(std::move(wptr));
 		default:
 			gapr::print("type: ", _op.type);
 			assert(0);
 	}
 }
 
+/*! frames of queued chunks go out in one scatter write.  small ones are
+ * copied next to their headers in _send_stage, so they share TLS records
+ * instead of a 5-byte record per header (copying big ones costs more
+ * than it saves).  with several streams writing, each queued op gives
+ * one frame per write and goes to the back, so they share the link. */
+void impl::do_send_impl_chk(WeakPtr<false, true, false>&& wptr) {
+	if(!_send_stage)
+		_send_stage=std::make_unique<std::array<unsigned char, SEND_STAGE>>();
+	auto stage=_send_stage->data();
+	std::size_t staged{0}, seg{0}, nframes{0};
+	std::vector<ba::const_buffer> bufs;
+	auto flush=[&bufs,stage,&staged,&seg]() {
+		if(staged>seg)
+			bufs.emplace_back(stage+seg, staged-seg);
+		seg=staged;
+	};
+	std::vector<std::unique_ptr<SendChkOp>> ops;
+	while(!_ops.send_que1.empty() && _ops.send_que1.front().type==SendOp::Chunk) {
+		auto& op=static_cast<SendChkOp&>(_ops.send_que1.front());
+		auto nframes0=nframes;
+		op.nsend=0;
+		do {
+			auto left=op.buf.size()-op.nsend;
+			auto towrite=std::min(left, _max_chunk);
+			std::size_t hdrlen=towrite>0xFFFF?7:5;
+			bool copy=towrite<=SEND_COPY;
+			if(staged+hdrlen+(copy?towrite:0)>SEND_STAGE)
+				break;
+			auto hdr=stage+staged;
+			hdr[0]=op.hdr[0];
+			hdr[1]=op.hdr[1];
+			hdr[2]=op.hdr[2];
+			if(towrite==left && op.eof)
+				hdr[0]|=CodeIsEof;
+			if(hdrlen==7) {
+				hdr[0]|=CodeLongChk;
+				for(unsigned int i=0; i<4; i++)
+					hdr[3+i]=(towrite>>(8*(3-i)))&0xFF;
+			} else {
+				hdr[3]=(towrite>>8);
+				hdr[4]=(towrite&0xFF);
+			}
+			staged+=hdrlen;
+			auto ptr=op.buf.data()+op.nsend;
+			if(copy) {
+				std::copy(ptr, ptr+towrite, stage+staged);
+				staged+=towrite;
+			} else {
+				flush();
+				bufs.emplace_back(ptr, towrite);
+			}
+			op.nsend+=towrite;
+			++nframes;
+		} while(op.nsend<op.buf.size() && nframes<MAX_GATHER && (!_mux || !op.next));
+		if(nframes==nframes0)
+			break;
+		ops.push_back(_ops.send_que1.take_front<SendChkOp>());
+		if(nframes>=MAX_GATHER || (op.nsend<op.buf.size() && !_mux))
+			break;
+	}
+	assert(!ops.empty());
+	flush();
+	return ba::async_write(sock(), bufs,
+			[ops=std::move(ops),this,wptr=std::move(wptr)](error_code ec, std::size_t nbytes) mutable {
+				if(ec) {
+					_st1=ConnStErr;
+					wptr.end();
+					for(auto& op: ops)
+						op->complete(ec);
+					return;
+				}
+				for(auto& op: ops) {
+					op->nwrite+=op->nsend;
+					op->buf.remove_prefix(op->nsend);
+					if(op->buf.size()>0)
+						wptr->_ops.send_que1.push_back(std::move(op));
+				}
+				ops.erase(std::remove(ops.begin(), ops.end(), nullptr), ops.end());
+				for(auto& op: ops) {
+					if(op->eof) {
+						stream(op->sid).insts.st1=ReqStClose;
+						check_if_done(this, op->sid);
+					}
+				}
+				do_send_impl_next(std::move(wptr));
+				for(auto& op: ops)
+					op->complete(ec);
+			});
+}
+
 void gapr::connection::impl::do_send_impl_next(WeakPtr<false, true, false>&& wptr) {
 	assert(_st1==ConnStOk || _st1==ConnStSd);
 	if(!_ops.send_que1.empty()) {
@@ -667,16 +796,18 @@ static inline bool check_st_write(int st, bs::error_code& ec) noexcept {
 	return false;
 }
 
-void gapr::connection::impl::do_write_str(std::unique_ptr<SendChkOp>&& op) {
+void gapr::connection::impl::do_write_str(std::unique_ptr<SendChkOp>&& op, uint16_t sid) {
 	Lock lck_{this};
 	bs::error_code ec;
 	do {
 		if(!check_st_write(_st1, ec))
 			break;
-		assert(_insts.st1==ReqStOpen);
+		auto& st=stream(sid);
+		assert(st.insts.st1==ReqStOpen);
 		if(op->eof)
-			_insts.st1=ReqStClosing;
-		uint16_t seq=0;
+			st.insts.st1=ReqStClosing;
+		uint16_t seq=sid;
+		op->sid=sid;
 		op->hdr[0]=CodeSpec;
 		op->hdr[1]=seq>>8;
 		op->hdr[2]=seq&0xFF;
@@ -709,22 +840,56 @@ static inline bool check_st_read(int st, bs::error_code& ec) noexcept {
 	return false;
 }
 
-void gapr::connection::impl::do_read_str(std::unique_ptr<ReadStrOp>&& op) {
+/*! moves input held for the stream to its read op, which is returned
+ * when filled or at eof */
+auto impl::take_pending(uint16_t sid, Stream& st, bool& is_eof) -> std::unique_ptr<ReadStrOp> {
+	auto op=st.read.get();
+	auto n=std::min(st.body.size()-st.body_off, op->buf.size());
+	std::copy(&st.body[st.body_off], &st.body[st.body_off]+n, op->buf.data());
+	op->nread+=n;
+	op->buf.skip(n);
+	st.body_off+=n;
+	if(st.body_off>=st.body.size()) {
+		st.body.clear();
+		st.body_off=0;
+	}
+	is_eof=st.body.empty() && st.body_eof;
+	if(!is_eof && op->buf.size()>0)
+		return {};
+	if(is_eof) {
+		st.body_eof=false;
+		st.insts.st0=ReqStClose;
+		check_if_done(this, sid);
+	}
+	_read_ops_n--;
+	return std::move(st.read);
+}
+
+void gapr::connection::impl::do_read_str(std::unique_ptr<ReadStrOp>&& op, uint16_t sid) {
 	Lock lck_{this};
 	bs::error_code ec;
 	do {
 		if(!check_st_read(_st0, ec))
 			break;
-		if(_ops.read) {
+		auto& st=stream(sid);
+		if(st.read) {
 			assert(0);
 			//seq
 			ec=ba::error::in_progress;
 			break;
 		}
-		assert(_insts.st0==ReqStOpen);
-		_ops.read=std::move(op);
-		gapr::print("begin read: ");
+		assert(st.insts.st0==ReqStOpen);
+		st.read=std::move(op);
+		gapr::print("begin read: ", sid);
 		_read_ops_n++;
+		if(!st.body.empty() || st.body_eof) {
+			bool is_eof;
+			if(auto op=take_pending(sid, st, is_eof)) {
+				ba::post(sock().get_executor(), [op=std::move(op),is_eof]() mutable {
+					op->complete(is_eof?ba::error::eof:bs::error_code{});
+				});
+			}
+		}
 		if(WeakPtr<true, false, false> wptr{this})
 			do_recv_impl(std::move(wptr), true);
 		return;
@@ -736,6 +901,17 @@ void gapr::connection::impl::do_read_str(std::unique_ptr<ReadStrOp>&& op) {
 }
 
 
+/*! for bench_connection_recv, only with -DGAPR_RECV_STATS */
+#ifdef GAPR_RECV_STATS
+static struct {
+	std::atomic<uint64_t> reads{0}; // reads on the TLS stream
+	std::atomic<uint64_t> staged{0}; // body bytes copied out of _recv_buf
+} recv_stats;
+#define RECV_STAT(f, n) recv_stats.f.fetch_add(n, std::memory_order_relaxed)
+#else
+#define RECV_STAT(f, n) do { } while(false)
+#endif
+
 enum RecvStates {
 	RECV_INIT=0,
 	RECV_GET_LINE0,
@@ -770,41 +946,104 @@ enum RecvStates {
 
 };
 
-inline std::unique_ptr<impl::RecvHdrOp> impl::do_recv_impl_get_op() noexcept {
+static inline uint16_t get_sid(const unsigned char* p) noexcept {
+	return (p[0]<<8)|p[1];
+}
+static inline void keep_hdr(impl::Stream& st, const impl::hdr_info_base& hdr, const impl::InstMisc& misc, bool has_body) {
+	st.hdr_line.assign(hdr.ptr, hdr.len);
+	st.hdr_info=hdr;
+	st.hdr_misc=misc;
+	st.hdr_has_body=has_body;
+	st.has_hdr=true;
+}
+
+/*! kept is set if the message is held for a later op */
+inline std::unique_ptr<impl::RecvHdrOp> impl::do_recv_impl_get_op(bool& kept) noexcept {
 	if(!_recv_is_notif) { // notifs, reqs
 		if(_is_srv) {
+			if(_mux) {
+				if(_ops.streams.size()>=SWEEP_STREAMS)
+					sweep_streams();
+				auto& st=stream(_recv_sid);
+				if(st.insts.st0!=ReqStInit || st.insts.st1!=ReqStInit || st.has_hdr)
+					return nullptr;
+				if(!_ops.recv && _ops.pending_reqs.size()>=MAX_PENDING_REQS)
+					return nullptr;
+				if(_recv_has_body)
+					set_expect(st, true);
+				if(!_ops.recv) {
+					keep_hdr(st, _recv_hdr, _recv_misc, _recv_has_body);
+					_ops.pending_reqs.push_back(_recv_sid);
+					kept=true;
+					return nullptr;
+				}
+				_ops.recv->set_info(_recv_sid, _recv_misc);
+				st.insts.st0=(_recv_has_body?ReqStOpen:ReqStClose);
+				return std::move(_ops.recv);
+			}
 			if(!_ops.recv) {
 				gapr::print("delayed");
 				//_recv_msgs_que.emplace_back(std::move(_recv_msg));
 				return nullptr;
 			}
-			_insts.misc=_recv_misc;
-			_insts.st0=(_recv_has_body?ReqStOpen:ReqStClose);
-			check_if_done(this);
+			auto& st=stream(0);
+			_ops.recv->set_info(0, _recv_misc);
+			st.insts.st0=(_recv_has_body?ReqStOpen:ReqStClose);
+			check_if_done(this, 0);
 			// XXX maybe no post?
 			//post(sock().get_executor(), [this,op=std::move(_ops.recv)]() mutable {
-			assert(!_ops.read);
+			assert(!st.read);
 			return std::move(_ops.recv);
 			//gapr::print("dispatch req/notif: ");
 			//});
 		} else {
-			if(!_ops.recv_reply) {
-				gapr::print("delayed response: ");
+			auto& st=stream(_recv_sid);
+			if(!st.recv_reply) {
+				gapr::print("delayed response: ", _recv_sid);
+				if(_mux && st.expect && !st.has_hdr) {
+					keep_hdr(st, _recv_hdr, _recv_misc, _recv_has_body);
+					if(!_recv_has_body)
+						set_expect(st, false);
+					kept=true;
+				}
 				return nullptr;
 			}
-			gapr::print("imm response: ", ' ');
-			_insts.misc=_recv_misc;
-			_insts.st0=(_recv_has_body?ReqStOpen:ReqStClose);
-			check_if_done(this);
+			gapr::print("imm response: ", _recv_sid);
+			st.recv_reply->set_info(_recv_sid, _recv_misc);
+			st.insts.st0=(_recv_has_body?ReqStOpen:ReqStClose);
+			if(!_recv_has_body)
+				set_expect(st, false);
+			check_if_done(this, _recv_sid);
 			_recv_ops_reply_n--;
 			// XXX maybe no post?
-			assert(!_ops.read);
-			return std::move(_ops.recv_reply);
+			assert(!st.read);
+			return std::move(st.recv_reply);
 		}
 	}
 	return {};
 }
 
+void impl::do_recv_impl_abort(const error_code& ec, const error_code& ec_reply, const error_code& ec_read) {
+	auto recv=std::move(_ops.recv);
+	auto delayed_recv=std::move(_ops.delayed_recv);
+	std::vector<std::unique_ptr<ReadStrOp>> reads;
+	std::vector<std::unique_ptr<RecvHdrOp>> replies;
+	for(auto& [sid, st]: _ops.streams) {
+		if(st.read)
+			reads.push_back(std::move(st.read));
+		if(st.recv_reply)
+			replies.push_back(std::move(st.recv_reply));
+	}
+	if(recv)
+		recv->complete(ec);
+	if(delayed_recv)
+		delayed_recv->complete(ec);
+	for(auto& op: reads)
+		op->complete(ec_read);
+	for(auto& op: replies)
+		op->complete(ec_reply);
+}
+
 void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, bool in_api) {
 	auto wptr=std::move(_wptr); // so that wptr.~dtor() call here
 	//assert(!_recv_map.empty() || !_recv_wq.empty() || !_recv_strs.empty());
@@ -820,29 +1059,19 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 		case RECV_GET_LINE0: // read to probe
 			assert(_recv_buf.size()>=2*MAX_HEADER+_recv_start);
 			assert(_recv_off==_recv_start);
-			return sock().async_read_some(ba::mutable_buffer{_recv_buf.data()+_recv_start, MAX_HEADER}, [this,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
+			// inside a body, probe for just a chunk header, so the payload
+			// goes straight to the reader's buffer.  (ssl::stream fills only
+			// the first buffer, one vectored read cannot take both.)
+			RECV_STAT(reads, 1);
+			return sock().async_read_some(ba::mutable_buffer{_recv_buf.data()+_recv_start, (_mux?_read_ops_n>0:stream(0).insts.st0==ReqStOpen)?std::size_t{5}:MAX_HEADER}, [this,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 				if(ec) {
 					gapr::print("read err0: ", ec.message());
 					_st0=ConnStErr;
 					if(ec==ba::error::eof || ec==ba::ssl::error::stream_truncated) {
-						if(auto op=std::move(_ops.recv)) {
-							_insts.st0=ReqStInit;
-							op->complete(ba::error::eof);
-							//wptr.end();
-							//return;
-						}
-						if(auto op=std::move(_ops.delayed_recv)) {
-							op->complete(ba::error::eof);
-						}
-						if(auto op=std::move(_ops.read)) {
-							op->complete(ba::ssl::error::stream_truncated);
-						}
-
+						if(_ops.recv && !_mux)
+							stream(0).insts.st0=ReqStInit;
 						//XXX
-						if(auto op=std::move(_ops.recv_reply)) {
-							//_insts[_recv_idx-1].st0=ReqStInit;
-							op->complete(ec);
-						}
+						do_recv_impl_abort(ba::error::eof, ec, ba::ssl::error::stream_truncated);
 						wptr.end();
 						return;
 					}
@@ -870,15 +1099,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 						op->complete(ec);
 					}
 #endif
-					if(auto op=std::move(_ops.recv)) {
-						op->complete(ec);
-						//wptr.end();
-						//return;
-					}
-					if(auto op=std::move(_ops.recv_reply)) {
-						//_insts[_recv_idx-1].st0=ReqStInit;
-						op->complete(ec);
-					}
+					do_recv_impl_abort(ec, ec, ec);
 					wptr.end();
 					return;
 
@@ -919,8 +1140,10 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			}
 			_recv_msg_code=_recv_buf.data()[_recv_start];
 			if(!(_recv_msg_code&CodeIsCtrl)) {
-				if(_recv_off<_recv_start+5) {
-					std::size_t toread=_recv_start+5-_recv_off;
+				std::size_t hdrlen=(_recv_msg_code&CodeLongChk)?7:5;
+				if(_recv_off<_recv_start+hdrlen) {
+					std::size_t toread=_recv_start+hdrlen-_recv_off;
+					RECV_STAT(reads, 1);
 					return ba::async_read(sock(), ba::mutable_buffer{&_recv_buf[_recv_off], toread}, [this,toread,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 						if(ec)
 							throw;
@@ -928,11 +1151,9 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 							throw;
 						_recv_off+=nbytes;
 						_recv_st=RECV_GOT_CHUNK;
-			assert(_recv_start+3+2<=_recv_off);
 						do_recv_impl(std::move(wptr), false);
 					});
 				}
-			assert(_recv_start+3+2<=_recv_off);
 				_recv_st=RECV_GOT_CHUNK;
 				continue;
 			}
@@ -940,6 +1161,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 				case CodeAbrt:
 					if(_recv_off<_recv_start+3) {
 						std::size_t toread=_recv_start+3-_recv_off;
+						RECV_STAT(reads, 1);
 						return ba::async_read(sock(), ba::mutable_buffer{&_recv_buf[_recv_off], toread}, [this,toread,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 							if(ec)
 								throw;
@@ -954,6 +1176,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 				case CodeTryAbrt:
 					if(_recv_off<_recv_start+3) {
 						std::size_t toread=_recv_start+3-_recv_off;
+						RECV_STAT(reads, 1);
 						return ba::async_read(sock(), ba::mutable_buffer{&_recv_buf[_recv_off], toread}, [this,toread,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 							if(ec)
 								throw;
@@ -970,15 +1193,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 					_recv_st=RECV_GOT_END;
 					break;
 				default:
-					if(auto op=std::move(_ops.recv)) {
-						op->complete(ba::error::bad_descriptor);
-						//wptr.end();
-						//return;
-					}
-					if(auto op=std::move(_ops.recv_reply)) {
-						//_insts[_recv_idx-1].st0=ReqStInit;
-						op->complete(ba::error::bad_descriptor);
-					}
+					do_recv_impl_abort(ba::error::bad_descriptor, ba::error::bad_descriptor, ba::error::bad_descriptor);
 					wptr.end();
 					return;
 					
@@ -990,6 +1205,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			assert(_recv_off>_recv_start);
 			assert(_recv_off<_recv_start+MAX_HEADER);
 			// [0, _recv_off) no '\n'
+			RECV_STAT(reads, 1);
 			return sock().async_read_some(ba::mutable_buffer{_recv_buf.data()+_recv_off, _recv_start+MAX_HEADER-_recv_off}, [this,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 				if(ec)
 					throw ec; // XXX
@@ -1032,6 +1248,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 		case RECV_GET_MISC0:
 			assert(_recv_buf.size()>=MAX_HEADER+_recv_start);
 			assert(_recv_off==_recv_start);
+			RECV_STAT(reads, 1);
 			return sock().async_read_some(ba::mutable_buffer{_recv_buf.data()+_recv_start, MAX_HEADER}, [this,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 				if(ec) {
 					_st0=ConnStErr;
@@ -1054,12 +1271,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			assert(_recv_off<=_recv_start+MAX_HEADER);
 			if(!(_recv_buf.data()[_recv_start]&CodeSpec)) {
 				fprintf(stderr, "unknown char %02x\n", _recv_buf.data()[_recv_start]);
-				if(auto op=std::move(_ops.recv)) {
-					op->complete(ba::error::eof);
-				}
-				if(auto op=std::move(_ops.recv_reply)) {
-					op->complete(ba::error::eof);
-				}
+				do_recv_impl_abort(ba::error::eof, ba::error::eof, ba::ssl::error::stream_truncated);
 				wptr.end();
 				return;
 				throw std::runtime_error{"unknown char"};
@@ -1069,6 +1281,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 				case CodeHdrOnly:
 					if(_recv_off<_recv_start+3) {
 						std::size_t toread=_recv_start+3-_recv_off;
+						RECV_STAT(reads, 1);
 						return ba::async_read(sock(), ba::mutable_buffer{&_recv_buf[_recv_off], toread}, [this,toread,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 							if(ec)
 								throw;
@@ -1084,6 +1297,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 				case CodeHasBody:
 					if(_recv_off<_recv_start+7) {
 						std::size_t toread=_recv_start+7-_recv_off;
+						RECV_STAT(reads, 1);
 						return ba::async_read(sock(), ba::mutable_buffer{&_recv_buf[_recv_off], toread}, [this,toread,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 							if(ec)
 								throw;
@@ -1100,6 +1314,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 					gapr::print("has strm");
 					if(_recv_off<_recv_start+13) {
 						std::size_t toread=_recv_start+13-_recv_off;
+						RECV_STAT(reads, 1);
 						return ba::async_read(sock(), ba::mutable_buffer{&_recv_buf[_recv_off], toread}, [this,toread,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
 							if(ec)
 								throw;
@@ -1120,6 +1335,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			}
 
 		case RECV_GOT_CODE_0:
+			_recv_sid=_mux?get_sid(&_recv_buf[_recv_start+1]):0;
 			_recv_has_body=false;
 			_recv_misc.var=0;
 			_recv_misc.siz=0;
@@ -1131,6 +1347,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			continue;
 
 		case RECV_GOT_CODE_B:
+			_recv_sid=_mux?get_sid(&_recv_buf[_recv_start+1]):0;
 			_recv_misc.var=be2host(*reinterpret_cast<uint16_t*>(&_recv_buf[_recv_start+3]));
 			_recv_misc.sizhint=_recv_misc.siz=_recv_chk_left=be2host(*reinterpret_cast<uint16_t*>(&_recv_buf[_recv_start+5]));
 			_recv_misc.typ=gapr::server_end::msg_type::stream;
@@ -1144,6 +1361,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 
 		case RECV_GOT_CODE_S:
 			assert(_recv_start+5+8<=_recv_off);
+			_recv_sid=_mux?get_sid(&_recv_buf[_recv_start+1]):0;
 			_recv_misc.var=be2host(*reinterpret_cast<uint16_t*>(&_recv_buf[_recv_start+3]));
 			_recv_misc.sizhint=be2host(*reinterpret_cast<uint64_t*>(&_recv_buf[_recv_start+5]));
 			_recv_misc.typ=gapr::server_end::msg_type::stream;
@@ -1162,7 +1380,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			// _recv_buf()[0, _recv_off): remaining
 			assert(_recv_off<_recv_start+MAX_HEADER);
 
-			if(auto op=do_recv_impl_get_op()) {
+			if(bool kept{false}; auto op=do_recv_impl_get_op(kept)) {
 				if(in_api) {
 					gapr::print("post msg");
 			//
@@ -1178,6 +1396,9 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 					gapr::print("got msg } ");
 					_recv_st=_recv_st_next;
 				}
+			} else if(kept) {
+				gapr::print("kept msg");
+				_recv_st=_recv_st_next;
 			} else {
 				gapr::print("pending msg");
 				wptr.end();
@@ -1188,10 +1409,17 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 			break;
 
 		case RECV_GOT_CHUNK:
-			assert(_recv_start+3+2<=_recv_off);
-			_recv_chk_left=be2host(*reinterpret_cast<uint16_t*>(&_recv_buf[_recv_start+3]));
+			_recv_sid=_mux?get_sid(&_recv_buf[_recv_start+1]):0;
+			if(_recv_msg_code&CodeLongChk) {
+				assert(_recv_start+3+4<=_recv_off);
+				_recv_chk_left=be2host(*reinterpret_cast<uint32_t*>(&_recv_buf[_recv_start+3]));
+				_recv_start+=7;
+			} else {
+				assert(_recv_start+3+2<=_recv_off);
+				_recv_chk_left=be2host(*reinterpret_cast<uint16_t*>(&_recv_buf[_recv_start+3]));
+				_recv_start+=5;
+			}
 			_recv_chk_is_eof=(_recv_msg_code&CodeIsEof);
-			_recv_start+=5;
 			assert(_recv_off>=_recv_start);
 			_recv_st=_recv_chk_left>0?RECV_GET_BODY:RECV_GET_BODY;
 			continue;
@@ -1199,29 +1427,25 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 		case RECV_GET_BODY:
 			assert(_recv_chk_left>=0);
 			assert(_recv_off>=_recv_start);
-			if(auto op=_ops.read.get()) {
+			if(auto op=stream(_recv_sid).read.get()) {
 				auto toread=_recv_chk_left;
 				if(toread>op->buf.size())
 					toread=op->buf.size();
 				if(_recv_off<_recv_start+toread) {
 					_recv_chk_left-=toread;
+					RECV_STAT(staged, _recv_off-_recv_start);
 					std::copy(&_recv_buf[_recv_start], &_recv_buf[_recv_off], op->buf.data());
 					op->nread+=_recv_off-_recv_start;
 					op->buf.skip(_recv_off-_recv_start);
 					toread-=_recv_off-_recv_start;
 					_recv_start=_recv_off;
 					//gapr::print("recv toread: ", toread);
+					RECV_STAT(reads, 1);
 					return ba::async_read(sock(), ba::mutable_buffer{op->buf.data(), toread}, [this,wptr=std::move(wptr),toread,op](bs::error_code ec, std::size_t nbytes) mutable {
 						if(ec) {
 							gapr::print("err read body");
 							//throw std::runtime_error{"err read body"};
-							if(auto op=std::move(_ops.delayed_recv)) {
-								op->complete(ba::error::eof);
-							}
-							if(auto op=std::move(_ops.read)) {
-								op->complete(ba::ssl::error::stream_truncated);
-							}
-
+							do_recv_impl_abort(ba::error::eof, ba::error::eof, ba::ssl::error::stream_truncated);
 							wptr.end();
 							return;
 						}
@@ -1233,6 +1457,7 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 						do_recv_impl(std::move(wptr), false);
 					});
 				} else {
+					RECV_STAT(staged, toread);
 					std::copy(&_recv_buf[_recv_start], &_recv_buf[_recv_start+toread], op->buf.data());
 					_recv_start+=toread;
 					op->nread+=toread;
@@ -1242,26 +1467,70 @@ void gapr::connection::impl::do_recv_impl(WeakPtr<true, false, false>&& _wptr, b
 					continue;
 				}
 			}
+			if(auto& st=stream(_recv_sid); _mux && st.expect) {
+				// nobody reading yet, hold it up to MAX_STREAM_BUF
+				if(st.body_off>0) {
+					st.body.erase(0, st.body_off);
+					st.body_off=0;
+				}
+				auto toread=std::min<std::size_t>(_recv_chk_left, MAX_STREAM_BUF-std::min(st.body.size(), MAX_STREAM_BUF));
+				if(toread<_recv_chk_left && toread==0) {
+					gapr::print("stream full: ", _recv_sid);
+					wptr.end();
+					return;
+				}
+				if(_recv_off>_recv_start || toread==0) {
+					auto n=std::min(toread, _recv_off-_recv_start);
+					RECV_STAT(staged, n);
+					st.body.append(reinterpret_cast<char*>(&_recv_buf[_recv_start]), n);
+					_recv_start+=n;
+					_recv_chk_left-=n;
+					_recv_st=RECV_GOT_BODY;
+					continue;
+				}
+				_recv_start=_recv_off=0;
+				RECV_STAT(reads, 1);
+				return sock().async_read_some(ba::mutable_buffer{_recv_buf.data(), std::min(toread, _recv_buf.size())}, [this,wptr=std::move(wptr)](bs::error_code ec, std::size_t nbytes) mutable {
+					if(ec) {
+						gapr::print("err read body");
+						do_recv_impl_abort(ba::error::eof, ba::error::eof, ba::ssl::error::stream_truncated);
+						wptr.end();
+						return;
+					}
+					_recv_off+=nbytes;
+					do_recv_impl(std::move(wptr), false);
+				});
+			}
 			gapr::print("delayed body");
 			wptr.end();
 			return;
 
 		case RECV_GOT_BODY:
 			assert(_recv_start<=_recv_off);
-			assert(_ops.read.get());
+			if(auto& st=stream(_recv_sid); !st.read) {
+				assert(_mux);
+				if(_recv_chk_left<=0 && _recv_chk_is_eof) {
+					st.body_eof=true;
+					set_expect(st, false);
+				}
+				_recv_st=_recv_chk_left>0?RECV_GET_BODY:RECV_MAYBE_NEXT;
+				continue;
+			}
 
 			gapr::print("got body: ");
-			if(_recv_chk_left<=0 && _ops.read->buf.size()>0 && !_recv_chk_is_eof) {
+			if(auto& st=stream(_recv_sid); _recv_chk_left<=0 && st.read->buf.size()>0 && !_recv_chk_is_eof) {
 				assert(_recv_start<=_recv_off);
 				_recv_st=RECV_NEXT;
 				continue;
 			}
 			{
-				auto op=std::move(_ops.read);
+				auto& st=stream(_recv_sid);
+				auto op=std::move(st.read);
 				bool is_eof=_recv_chk_left<=0&&_recv_chk_is_eof;
 				if(is_eof) {
-					_insts.st0=ReqStClose;
-					check_if_done(this);
+					st.insts.st0=ReqStClose;
+					set_expect(st, false);
+					check_if_done(this, _recv_sid);
 				}
 				_read_ops_n--;
 				// XXX maybe no post?
@@ -1441,7 +1710,7 @@ void gapr::Connection::do_recv_impl() {
 			break;
 #endif
 		case RECV_MAYBE_NEXT: // next round, maybe with dirty buffer
-			if(!_ops.recv && _recv_ops_reply_n<=0 && _read_ops_n<=0 ) {
+			if(_mux?(!_ops.recv && _mux_expect==0):(!_ops.recv && _recv_ops_reply_n<=0 && _read_ops_n<=0)) {
 				wptr.end();
 				//gapr::print("!receiving");
 				return;
@@ -14,6 +14,8 @@
 #include <condition_variable>
 #include <memory>
 #include <deque>
+#include <algorithm>
+#include <cmath>
 
 #include <boost/asio/post.hpp>
 
@@ -153,6 +155,8 @@ struct LoadPosition {
 	std::array<uint32_t, 3> offset;
 	std::array<uint32_t, 3> cube_sizes;
 	unsigned int xn, yn, zn;
+	// tiles ahead of the motion, most likely first
+	std::vector<std::string> prefetch{};
 	bool operator==(const LoadPosition& p) const {
 		if(uri!=p.uri) return false;
 		if(offset!=p.offset) return false;
@@ -263,6 +267,13 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 
 	int nFilesToLoad;
 	int nFilesLoaded;
+	// cubes are loaded one at a time, let the codec use all cores
+	unsigned int decode_threads{std::thread::hardware_concurrency()};
+
+	// motion of the closeup position, only used in the caller thread
+	std::array<double, 3> prev_off{0.0, 0.0, 0.0};
+	std::array<double, 3> motion{0.0, 0.0, 0.0};
+	std::string prev_uri{};
 
 	// XXX
 	~cube_builder_PRIV() {
@@ -272,8 +283,11 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 			std::lock_guard lck{loaderShared_mtx};
 			refc=--loaderShared_refc;
 		}
-		if(refc==0)
+		if(refc==0) {
 			delete loaderShared;
+			// no more closeup views to recycle buffers for
+			gapr::cube_pool_trim();
+		}
 	}
 
 	void setPositionSmall(std::size_t ch, const gapr::cube_info& info) {
@@ -309,6 +323,7 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 		std::array<unsigned int, 3> cnt;
 		for(unsigned int i=0; i<3; ++i)
 			cnt[i]=big?3u:2u;
+		update_motion(info, off, cnt);
 		if(offset) {
 			unsigned int hits=0;
 			for(unsigned int i=0; i<3; ++i) {
@@ -351,19 +366,83 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 			return false;
 
 		gapr::print("load: ", offi[0], '+', cnt[0], '/', offi[1], '+', cnt[1], '/', offi[2], '+', cnt[2]);
+		auto prefetch=prefetch_tiles(info, off, offi, cnt);
 		std::unique_lock<std::mutex> lck_in{mtx_in};
 		auto it=toload.find(1);
 		if(it==toload.end()) {
-			toload[1]={ch, true, info.location(), offi, info.cube_sizes, cnt[0], cnt[1], cnt[2]};
+			toload[1]={ch, true, info.location(), offi, info.cube_sizes, cnt[0], cnt[1], cnt[2], std::move(prefetch)};
 			nFilesToLoad+=toload[1].nFiles();
 		} else {
 			nFilesToLoad-=it->second.nFiles();
-			it->second={ch, true, info.location(), offi, info.cube_sizes, cnt[0], cnt[1], cnt[2]};
+			it->second={ch, true, info.location(), offi, info.cube_sizes, cnt[0], cnt[1], cnt[2], std::move(prefetch)};
 			nFilesToLoad+=it->second.nFiles();
 		}
 		cv_in.notify_one();
 		return true;
 	}
+	void update_motion(const gapr::cube_info& info, const std::array<double, 3>& off, const std::array<unsigned int, 3>& cnt) {
+		bool jump=info.location()!=prev_uri;
+		std::array<double, 3> delta;
+		for(unsigned int i=0; i<3; ++i) {
+			delta[i]=off[i]-prev_off[i];
+			if(std::abs(delta[i])>cnt[i]*info.cube_sizes[i])
+				jump=true;
+		}
+		prev_off=off;
+		if(jump) {
+			prev_uri=info.location();
+			motion={0.0, 0.0, 0.0};
+			gapr::downloader::cancel_idle();
+			return;
+		}
+		for(unsigned int i=0; i<3; ++i)
+			motion[i]=motion[i]/2+delta[i];
+	}
+	/*! tiles next to the block, on the faces the position moves towards */
+	std::vector<std::string> prefetch_tiles(const gapr::cube_info& info, const std::array<double, 3>& off, const std::array<unsigned int, 3>& offi, const std::array<unsigned int, 3>& cnt) const {
+		std::vector<std::string> tiles;
+		double vmax{0.0};
+		for(unsigned int i=0; i<3; ++i) {
+			auto v=std::abs(motion[i])/info.cube_sizes[i];
+			if(v>vmax)
+				vmax=v;
+		}
+		if(vmax<=0.0)
+			return tiles;
+		std::vector<std::pair<double, std::array<unsigned int, 3>>> cands;
+		for(unsigned int i=0; i<3; ++i) {
+			// only the dominant directions
+			if(std::abs(motion[i])/info.cube_sizes[i]<vmax/2)
+				continue;
+			int64_t t;
+			if(motion[i]>0)
+				t=offi[i]+int64_t{cnt[i]}*info.cube_sizes[i];
+			else
+				t=int64_t{offi[i]}-info.cube_sizes[i];
+			if(t<0 || t>=info.sizes[i])
+				continue;
+			auto j=(i+1)%3;
+			auto k=(i+2)%3;
+			for(unsigned int a=0; a<cnt[j]; ++a) {
+				for(unsigned int b=0; b<cnt[k]; ++b) {
+					std::array<unsigned int, 3> o;
+					o[i]=t;
+					o[j]=offi[j]+a*info.cube_sizes[j];
+					o[k]=offi[k]+b*info.cube_sizes[k];
+					double d{0.0};
+					for(unsigned int l=0; l<3; ++l) {
+						auto dd=(o[l]+info.cube_sizes[l]/2.0-off[l])/info.cube_sizes[l];
+						d+=dd*dd;
+					}
+					cands.emplace_back(d, o);
+				}
+			}
+		}
+		std::sort(cands.begin(), cands.end(), [](auto& a, auto& b) { return a.first<b.first; });
+		for(auto& [d, o]: cands)
+			tiles.push_back(gapr::pattern_subst(info.location(), o));
+		return tiles;
+	}
 
 	void setPositionBigOffset(std::size_t ch, const gapr::cube_info& info, const std::array<unsigned int, 3>& offset, bool big) {
 		unsigned int xn=big?3:2;
@@ -432,6 +511,10 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 			}
 		}
 		data->cache=gapr::downloader{builder_ex, data->files};
+		// after the waited tiles are queued
+		gapr::downloader::cancel_idle();
+		for(auto it=pos.prefetch.rbegin(); it!=pos.prefetch.rend(); ++it)
+			gapr::downloader::when_idle(std::string{*it});
 		return data;
 	}
 	void loadImageSmall(gapr::cube_loader* imageReader, const std::string& file, CubeData* cube) {
@@ -506,7 +589,7 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 					//gapr::report("Failed to download file");
 				auto uri=curJob->files[r];
 				auto sb=std::move(cacheFile);
-				auto imageReader=gapr::make_cube_loader(uri, static_cast<gapr::Streambuf&>(*sb));
+				auto imageReader=gapr::make_cube_loader(uri, static_cast<gapr::Streambuf&>(*sb), decode_threads);
 				loadImageSmall(imageReader.get(), curJob->files[0], curJob->cube.get());
 				loaderShared->changeState(curJob->cube.get(), 0, CubeData::State::Reading, CubeData::State::Ready);
 				curJob->cube->nFinished++;
@@ -553,7 +636,7 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 					//gapr::report("Failed to download file");
 				auto uri=curJob->files[r];
 				auto sb=std::move(cacheFile);//std::move(f));
-				auto imageReader=gapr::make_cube_loader(uri, static_cast<gapr::Streambuf&>(*sb));
+				auto imageReader=gapr::make_cube_loader(uri, static_cast<gapr::Streambuf&>(*sb), decode_threads);
 				loadImageBig(imageReader.get(), curJob->files[0], curJob->cube.get(), curJob->ptrs[r].xi, curJob->ptrs[r].yi, curJob->ptrs[r].zi, curJob->pos.cube_sizes[0], curJob->pos.cube_sizes[1], curJob->pos.cube_sizes[2], curJob->pos.xn, curJob->pos.yn, curJob->pos.zn);
 				loaderShared->changeState(curJob->cube.get(), cpi, CubeData::State::Reading, CubeData::State::Ready);
 				curJob->cube->nFinished++;
@@ -761,6 +844,7 @@ struct gapr::cube_builder_PRIV: gapr::cube_builder::DATA {
 			//}
 		}
 		toload.clear();
+		gapr::downloader::cancel_idle();
 	}
 	cube_builder::Output do_get() {
 		{
@@ -25,12 +25,12 @@
 namespace gapr {
 	std::unique_ptr<cube_loader> make_cube_loader_nrrd(Streambuf& file);
 	std::unique_ptr<cube_loader> make_cube_loader_tiff(Streambuf& file);
-	std::unique_ptr<cube_loader> make_cube_loader_webm(Streambuf& file);
+	std::unique_ptr<cube_loader> make_cube_loader_webm(Streambuf& file, unsigned int nthreads);
 	std::unique_ptr<cube_loader> make_cube_loader_hevc(Streambuf& file);
 	std::unique_ptr<cube_loader> make_cube_loader_v3d(Streambuf& file, bool compressed);
 }
 
-std::unique_ptr<gapr::cube_loader> gapr::make_cube_loader(std::string_view type_hint, Streambuf& file) {
+std::unique_ptr<gapr::cube_loader> gapr::make_cube_loader(std::string_view type_hint, Streambuf& file, unsigned int nthreads) {
 	const char* url=type_hint.data();
 	auto l=type_hint.size();
 #ifdef _MSC_VER
@@ -48,7 +48,7 @@ std::unique_ptr<gapr::cube_loader> gapr::make_cube_loader(std::string_view type_
 		return make_cube_loader_v3d(file, true);
 #ifdef WITH_VP9
 	} else if(l>5 && strncasecmp(url+l-5, ".webm", 5)==0) {
-		return make_cube_loader_webm(file);
+		return make_cube_loader_webm(file, nthreads);
 #endif
 #ifdef WITH_HEVC
 	} else if(l>5 && strncasecmp(url+l-5, ".hevc", 5)==0) {
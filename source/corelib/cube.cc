@@ -7,6 +7,8 @@
 #include <algorithm>
 #include <charconv>
 #include <fstream>
+#include <cstring>
+#include <mutex>
 
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
@@ -15,19 +17,210 @@
 
 #include "config.hh"
 
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 //////////
 using gapr::cube_PRIV;
 
+namespace {
+
+	/*! buffers smaller than this go through new/delete */
+	constexpr std::size_t POOL_MIN=1024*1024;
+	constexpr std::size_t PAGE_SIZ=4096;
+	constexpr std::size_t HUGE_PAGE_SIZ=2*1024*1024;
+
+	class cube_pool {
+		public:
+			cube_pool() {
+				std::size_t budget_mb=1024;
+				if(auto p=std::getenv("GAPR_CUBE_POOL_MB"); p) {
+					auto r=std::from_chars(p, p+std::strlen(p), budget_mb);
+					if(r.ec!=std::errc{})
+						budget_mb=1024;
+				}
+				_budget=budget_mb*1024*1024;
+			}
+
+			std::size_t round_size(std::size_t siz) const noexcept {
+				auto align=_huge.load()?HUGE_PAGE_SIZ:PAGE_SIZ;
+				return (siz+align-1)/align*align;
+			}
+			/*! returns a zero-filled buffer of siz bytes */
+			void* get(std::size_t siz) {
+				void* ptr{nullptr};
+				{
+					std::lock_guard lck{_mtx};
+					for(auto e=_newest; e; e=e->prev) {
+						if(e->size==siz) {
+							unlink(e);
+							ptr=e;
+							break;
+						}
+					}
+					if(ptr)
+						_hits++;
+					else
+						_misses++;
+				}
+				if(ptr) {
+					// pages are resident, much cheaper than faulting them in
+					std::memset(ptr, 0, siz);
+					return ptr;
+				}
+				return map(siz);
+			}
+			/*! reached from cube destruction, must not allocate */
+			void put(void* ptr, std::size_t siz) noexcept {
+				std::size_t budget;
+				{
+					std::lock_guard lck{_mtx};
+					budget=_budget;
+					if(siz<=budget) {
+						push(new(ptr) entry{siz, nullptr, nullptr});
+						ptr=nullptr;
+					}
+				}
+				if(ptr)
+					return unmap(ptr, siz);
+				trim(budget);
+			}
+			void trim(std::size_t keep) noexcept {
+				while(true) {
+					entry* e;
+					{
+						std::lock_guard lck{_mtx};
+						if(_cached<=keep)
+							return;
+						e=_oldest;
+						unlink(e);
+					}
+					auto siz=e->size;
+					unmap(e, siz);
+				}
+			}
+			void config(std::size_t budget, bool populate, bool huge) {
+				{
+					std::lock_guard lck{_mtx};
+					_budget=budget;
+				}
+				_populate=populate;
+				_huge=huge;
+				trim(budget);
+			}
+			gapr::cube_pool_stats stats() noexcept {
+				std::lock_guard lck{_mtx};
+				return {_hits, _misses, _cached, _budget};
+			}
+
+		private:
+			// free buffers are linked through their first words
+			struct entry {
+				std::size_t size;
+				entry* prev; // older
+				entry* next; // newer
+			};
+			std::mutex _mtx;
+			entry* _oldest{nullptr};
+			entry* _newest{nullptr};
+			std::size_t _cached{0};
+			std::size_t _budget;
+			std::atomic<bool> _populate{false};
+			std::atomic<bool> _huge{false};
+			uint64_t _hits{0};
+			uint64_t _misses{0};
+
+			void push(entry* e) noexcept {
+				e->prev=_newest;
+				e->next=nullptr;
+				(_newest?_newest->next:_oldest)=e;
+				_newest=e;
+				_cached+=e->size;
+			}
+			void unlink(entry* e) noexcept {
+				(e->prev?e->prev->next:_oldest)=e->next;
+				(e->next?e->next->prev:_newest)=e->prev;
+				_cached-=e->size;
+			}
+			void* map(std::size_t siz) {
+#ifdef __linux__
+				bool populate=_populate;
+				bool huge=_huge;
+				int flags=MAP_PRIVATE|MAP_ANONYMOUS;
+				if(populate && !huge)
+					flags|=MAP_POPULATE;
+				auto ptr=::mmap(nullptr, siz, PROT_READ|PROT_WRITE, flags, -1, 0);
+				if(ptr==MAP_FAILED)
+					throw std::bad_alloc{};
+				if(huge) {
+#ifdef MADV_HUGEPAGE
+					::madvise(ptr, siz, MADV_HUGEPAGE);
+#endif
+#ifdef MADV_POPULATE_WRITE
+					if(populate)
+						::madvise(ptr, siz, MADV_POPULATE_WRITE);
+#endif
+				}
+				return ptr;
+#else
+				auto ptr=::operator new(siz);
+				std::memset(ptr, 0, siz);
+				return ptr;
+#endif
+			}
+			static void unmap(void* ptr, std::size_t siz) noexcept {
+#ifdef __linux__
+				::munmap(ptr, siz);
+#else
+				(void)siz;
+				::operator delete(ptr);
+#endif
+			}
+	};
+
+	/*! leaked, cubes may outlive static destruction */
+	cube_pool& get_cube_pool() {
+		static auto pool=new cube_pool{};
+		return *pool;
+	}
+
+}
+
+void gapr::cube_pool_config(std::size_t budget, bool populate, bool huge_pages) {
+	get_cube_pool().config(budget, populate, huge_pages);
+}
+void gapr::cube_pool_trim(std::size_t keep) noexcept {
+	get_cube_pool().trim(keep);
+}
+gapr::cube_pool_stats gapr::get_cube_pool_stats() noexcept {
+	return get_cube_pool().stats();
+}
+
 cube_PRIV::Head* cube_PRIV::alloc(cube_type type, std::array<uint32_t, 3> sizes) {
 	assert(type!=cube_type::unknown);
 
 	std::size_t ystride=(voxel_size(type)*sizes[0]+7)/8*8;
 	// XXX alignment???
-	auto buf=new char[sizeof(cube_PRIV::Head)+ystride*sizes[1]*sizes[2]];
-	return new(buf) cube_PRIV::Head{type, sizes, ystride};
+	auto siz=sizeof(cube_PRIV::Head)+ystride*sizes[1]*sizes[2];
+	if(siz<POOL_MIN) {
+		auto buf=new char[siz];
+		return new(buf) cube_PRIV::Head{type, sizes, ystride};
+	}
+	auto& pool=get_cube_pool();
+	siz=pool.round_size(siz);
+	auto buf=pool.get(siz);
+	auto p=new(buf) cube_PRIV::Head{type, sizes, ystride};
+	p->_pool_size=siz;
+	return p;
 }
 void cube_PRIV::destroy(Head* p) noexcept {
+	auto pool_size=p->_pool_size;
 	p->~Head();
+	if(pool_size) {
+		get_cube_pool().put(p, pool_size);
+		return;
+	}
 	auto buf=reinterpret_cast<char*>(p);
 	delete[] buf;
 }
@@ -513,6 +706,43 @@ namespace gapr_test { int chk_pattern_subst() {
 	return 0;
 } }
 
+namespace gapr_test { int chk_cube_pool() {
+	auto fill=[](gapr::mutable_cube& cube, char v) {
+		auto view=cube.view<char>();
+		for(unsigned int z=0; z<view.sizes(2); z++)
+			for(unsigned int y=0; y<view.sizes(1); y++)
+				std::memset(view.row(y, z), v, view.ystride());
+	};
+	auto is_zero=[](const gapr::cube& cube) {
+		auto view=cube.view<char>();
+		for(unsigned int z=0; z<view.sizes(2); z++)
+			for(unsigned int y=0; y<view.sizes(1); y++)
+				for(std::size_t x=0; x<view.ystride(); x++)
+					if(view.row(y, z)[x]!=0)
+						return false;
+		return true;
+	};
+	gapr::cube_pool_trim(0);
+	auto st0=gapr::get_cube_pool_stats();
+	for(unsigned int i=0; i<4; i++) {
+		gapr::mutable_cube cube{gapr::cube_type::u16, {601, 300, 7}};
+		gapr::cube cube2{std::move(cube)};
+		if(!is_zero(cube2))
+			return -1;
+		gapr::mutable_cube cube3{gapr::cube_type::u8, {1202, 300, 7}};
+		fill(cube3, 'x');
+	}
+	auto st1=gapr::get_cube_pool_stats();
+	gapr::print("cube pool: ", st1.hits-st0.hits, " hits, ", st1.misses-st0.misses, " misses, ", st1.cached, " cached");
+	// same byte size, different type, still reused
+	if(st1.misses-st0.misses!=2 || st1.hits-st0.hits!=6)
+		return -1;
+	gapr::cube_pool_trim(0);
+	if(gapr::get_cube_pool_stats().cached!=0)
+		return -1;
+	return 0;
+} }
+
 static std::array<double, 9> def_direction{
 	1.0, 0.0, 0.0,
 	0.0, 1.0, 0.0,
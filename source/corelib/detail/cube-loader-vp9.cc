@@ -14,14 +14,11 @@
 #endif
 #include "mkvparser.hpp"
 #include <string.h>
-#ifdef HAVE_OPENMP
-#include <omp.h>
-#else
-inline int omp_get_num_threads() { return 1; }
-inline int omp_get_thread_num() { return 0; }
-#endif
 #include <memory>
 #include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 template<typename CTX>
 struct codec_adapter;
@@ -32,6 +29,7 @@ struct codec_adapter<vpx_codec_ctx_t> {
 	using codec_ctx_t=vpx_codec_ctx_t;
 	using codec_dec_cfg_t=vpx_codec_dec_cfg_t;
 	using codec_iter_t=vpx_codec_iter_t;
+	using codec_err_t=vpx_codec_err_t;
 	static constexpr vpx_codec_err_t codec_ok=VPX_CODEC_OK;
 	static const char* codec_err_to_string(vpx_codec_err_t err) {
 		return vpx_codec_err_to_string(err);
@@ -47,6 +45,13 @@ struct codec_adapter<vpx_codec_ctx_t> {
 	static vpx_codec_err_t codec_dec_init(vpx_codec_ctx_t* ctx, vpx_codec_dec_cfg_t* cfg) {
 		return vpx_codec_dec_init(ctx, vpx_codec_vp9_dx(), cfg, 0/*VPX_CODEC_USE_HIGHBITDEPTH*/);
 	}
+	static vpx_codec_err_t codec_set_row_mt(vpx_codec_ctx_t* ctx) {
+#ifdef VPX_CTRL_VP9D_SET_ROW_MT
+		return vpx_codec_control(ctx, VP9D_SET_ROW_MT, 1);
+#else
+		return VPX_CODEC_OK;
+#endif
+	}
 	static vpx_codec_err_t codec_destroy(vpx_codec_ctx_t* ctx) {
 		return vpx_codec_destroy(ctx);
 	}
@@ -65,6 +70,7 @@ struct codec_adapter<aom_codec_ctx_t> {
 	using codec_ctx_t=aom_codec_ctx_t;
 	using codec_dec_cfg_t=aom_codec_dec_cfg_t;
 	using codec_iter_t=aom_codec_iter_t;
+	using codec_err_t=aom_codec_err_t;
 	static constexpr aom_codec_err_t codec_ok=AOM_CODEC_OK;
 	static const char* codec_err_to_string(aom_codec_err_t err) {
 		return aom_codec_err_to_string(err);
@@ -80,6 +86,13 @@ struct codec_adapter<aom_codec_ctx_t> {
 	static aom_codec_err_t codec_dec_init(aom_codec_ctx_t* ctx, aom_codec_dec_cfg_t* cfg) {
 		return aom_codec_dec_init(ctx, aom_codec_av1_dx(), cfg, 0);
 	}
+	static aom_codec_err_t codec_set_row_mt(aom_codec_ctx_t* ctx) {
+#ifdef AOM_CTRL_AV1D_SET_ROW_MT
+		return aom_codec_control(ctx, AV1D_SET_ROW_MT, 1);
+#else
+		return AOM_CODEC_OK;
+#endif
+	}
 	static aom_codec_err_t codec_destroy(aom_codec_ctx_t* ctx) {
 		return aom_codec_destroy(ctx);
 	}
@@ -97,11 +110,72 @@ static uint16_t dec16(uint16_t x) {
 	unsigned int i=x>>9;
 	if(i<2)
 		return x;
+	if(i>=18)
+		return 0;
 	// add 0.5 to compensate truncated bits
 	x=((x&0x1ff)<<1)|0x401;
 	return x<<(i-2);
 }
 
+static void dec16_row(uint16_t* optr, const uint16_t* iptr, std::size_t n) {
+	std::size_t x=0;
+#ifdef __SSE2__
+	// per-lane shift composed from its bits, no variable 16-bit shifts in SSE2
+	auto c_mask=_mm_set1_epi16(0x1ff);
+	auto c_half=_mm_set1_epi16(0x401);
+	auto c_2=_mm_set1_epi16(2);
+	auto c_15=_mm_set1_epi16(15);
+	for(; x+8<=n; x+=8) {
+		auto v=_mm_loadu_si128(reinterpret_cast<const __m128i*>(iptr+x));
+		auto i=_mm_srli_epi16(v, 9);
+		auto m=_mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, c_mask), 1), c_half);
+		auto s=_mm_sub_epi16(i, c_2);
+		auto sel=[&s](__m128i a, __m128i t, int b) {
+			auto k=_mm_set1_epi16(b);
+			auto mk=_mm_cmpeq_epi16(_mm_and_si128(s, k), k);
+			return _mm_or_si128(_mm_and_si128(mk, t), _mm_andnot_si128(mk, a));
+		};
+		m=sel(m, _mm_slli_epi16(m, 1), 1);
+		m=sel(m, _mm_slli_epi16(m, 2), 2);
+		m=sel(m, _mm_slli_epi16(m, 4), 4);
+		m=sel(m, _mm_slli_epi16(m, 8), 8);
+		m=_mm_andnot_si128(_mm_cmpgt_epi16(s, c_15), m);
+		auto lt2=_mm_cmplt_epi16(i, c_2);
+		auto r=_mm_or_si128(_mm_and_si128(lt2, v), _mm_andnot_si128(lt2, m));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(optr+x), r);
+	}
+#endif
+	for(; x<n; ++x)
+		optr[x]=dec16(iptr[x]);
+}
+
+struct decoder_base {
+	virtual ~decoder_base() { }
+};
+template<typename CTX>
+struct decoder_holder: decoder_base {
+	using Adapter=codec_adapter<CTX>;
+	typename Adapter::codec_ctx_t ctx;
+	decoder_holder(unsigned int w, unsigned int h, unsigned int nthreads) {
+		typename Adapter::codec_dec_cfg_t cfg{};
+		cfg.w=w;
+		cfg.h=h;
+		cfg.threads=nthreads;
+		auto err=Adapter::codec_dec_init(&ctx, &cfg);
+		if(err!=Adapter::codec_ok)
+			gapr::report("Failed to init decoder: ", Adapter::codec_err_to_string(err));
+		if(nthreads>1)
+			Adapter::codec_set_row_mt(&ctx);
+	}
+	~decoder_holder() override {
+		auto err=Adapter::codec_destroy(&ctx);
+		if(err!=Adapter::codec_ok)
+			gapr::print("Failed to destroy decoder: ", Adapter::codec_err_to_string(err));
+	}
+	decoder_holder(const decoder_holder&) =delete;
+	decoder_holder& operator=(const decoder_holder&) =delete;
+};
+
 class MyMkvReader: public mkvparser::IMkvReader {
 	gapr::Streambuf& strm;
 	long long size;
@@ -140,8 +214,8 @@ class MyMkvReader: public mkvparser::IMkvReader {
 
 class WebmLoader: public gapr::cube_loader {
 	public:
-		explicit WebmLoader(gapr::Streambuf& file): gapr::cube_loader{file},
-					reader{file} {
+		explicit WebmLoader(gapr::Streambuf& file, unsigned int nthreads):
+			gapr::cube_loader{file}, reader{file}, nthreads{nthreads>0?nthreads:1} {
 			supported=probe();
 #if 0
 						file.pubseekpos(0);
@@ -161,6 +235,9 @@ class WebmLoader: public gapr::cube_loader {
 		MyMkvReader reader;
 	std::vector<unsigned char> firstFrame;
 	std::vector<std::vector<uint8_t>> buffs{};
+		// kept from probing, to continue after the first frame
+		std::unique_ptr<decoder_base> decoder;
+		unsigned int nthreads;
 		bool supported;
 		bool is_vp9{false};
 		bool is_av1{false};
@@ -288,24 +365,15 @@ class WebmLoader: public gapr::cube_loader {
 			using Adapter=codec_adapter<CTX>;
 			gapr::cube_type type;
 			std::array<int32_t, 3> sizes;
-			typename Adapter::codec_ctx_t ctx;
-			typename Adapter::codec_dec_cfg_t cfg;
-			cfg.w=sizes[0]=video_track->GetWidth();
-			cfg.h=sizes[1]=video_track->GetHeight();
-			cfg.threads=1;
-			auto err=Adapter::codec_dec_init(&ctx, &cfg);
+			sizes[0]=video_track->GetWidth();
+			sizes[1]=video_track->GetHeight();
+			auto dec=std::make_unique<decoder_holder<CTX>>(sizes[0], sizes[1], nthreads);
+			auto ctx=&dec->ctx;
+			auto err=Adapter::codec_decode(ctx, buffs[0].data(), buffs[0].size());
 			if(err!=Adapter::codec_ok)
-				gapr::report("Failed to init decoder: ", Adapter::codec_err_to_string(err));
-			for(int i=0; i<1; ++i) {
-				err=Adapter::codec_decode(&ctx, buffs[0].data(), buffs[0].size());
-				if(err!=Adapter::codec_ok)
-					gapr::report("Failed to decode frame: ", Adapter::codec_err_to_string(err));
-			}
-			//err=Adapter::codec_decode(&ctx, nullptr, 0);
-			//if(err!=Adapter::codec_ok)
-			//gapr::report("Failed to flush frame: ", Adapter::codec_err_to_string(err));
+				gapr::report("Failed to decode frame: ", Adapter::codec_err_to_string(err));
 			typename Adapter::codec_iter_t iter=nullptr;
-			if(auto img=Adapter::codec_get_frame(&ctx, &iter)) {
+			if(auto img=Adapter::codec_get_frame(ctx, &iter)) {
 				switch(img->fmt) {
 				case Adapter::img_fmt(uint8_t{}):
 					//case VPX_IMG_FMT_YV12:
@@ -325,9 +393,7 @@ class WebmLoader: public gapr::cube_loader {
 			} else {
 				return false;
 			}
-			err=Adapter::codec_destroy(&ctx);
-			if(err!=Adapter::codec_ok)
-				gapr::report("Failed to destroy decoder: ", Adapter::codec_err_to_string(err));
+			decoder=std::move(dec);
 			sizes[2]=buffs.size();
 			set_info(type, sizes);
 			return true;
@@ -337,11 +403,9 @@ class WebmLoader: public gapr::cube_loader {
 	void copyImageImp(unsigned char* plane, int stride, char* ptr, int64_t ystride) {
 		for(int32_t y=0; y<sizes()[1]; y++) {
 		if constexpr(Dec16) {
-			for(unsigned int x=0; x<sizes()[0]; ++x) {
-				auto optr=reinterpret_cast<T*>(ptr+y*ystride);
-				auto iptr=reinterpret_cast<T*>(plane+y*stride);
-				optr[x]=dec16(iptr[x]);
-			}
+			auto optr=reinterpret_cast<T*>(ptr+y*ystride);
+			auto iptr=reinterpret_cast<const T*>(plane+y*stride);
+			dec16_row(optr, iptr, sizes()[0]);
 		} else {
 			memcpy(ptr+y*ystride, plane+y*stride, sizes()[0]*sizeof(T));
 		}
@@ -367,41 +431,29 @@ class WebmLoader: public gapr::cube_loader {
 	void load_impl(size_t ileft, size_t iright, char* ptr, int64_t ystride, int64_t zstride) {
 		gapr::print("i ", ileft, ", ", iright);
 		using Adapter=codec_adapter<CTX>;
-		auto width=sizes()[0];
-		auto height=sizes()[1];
-
-		typename Adapter::codec_ctx_t ctx;
-		typename Adapter::codec_dec_cfg_t cfg;
-		cfg.w=width;
-		cfg.h=height;
-		cfg.threads=1;
-		auto err=Adapter::codec_dec_init(&ctx, &cfg);
-		if(err!=Adapter::codec_ok)
-			gapr::report("Failed to init decoder: ", Adapter::codec_err_to_string(err));
+		auto ctx=&static_cast<decoder_holder<CTX>*>(decoder.get())->ctx;
 		bool got_img=false;
 		size_t imgi=ileft;
 		for(size_t i=ileft; i<iright || got_img; i++) {
+			typename Adapter::codec_err_t err;
 			if(i<iright) {
-				err=Adapter::codec_decode(&ctx, buffs[i].data(), buffs[i].size());
+				err=Adapter::codec_decode(ctx, buffs[i].data(), buffs[i].size());
 				if(err!=Adapter::codec_ok)
 					gapr::report("Failed to decode frame: ", Adapter::codec_err_to_string(err));
 			} else {
-				err=Adapter::codec_decode(&ctx, nullptr, 0);
+				err=Adapter::codec_decode(ctx, nullptr, 0);
 				if(err!=Adapter::codec_ok)
 					gapr::report("Failed to flush frame: ", Adapter::codec_err_to_string(err));
 			}
 
 			got_img=false;
 			typename Adapter::codec_iter_t iter=nullptr;
-			while(auto img=Adapter::codec_get_frame(&ctx, &iter)) {
+			while(auto img=Adapter::codec_get_frame(ctx, &iter)) {
 				got_img=true;
 				copyImage(Adapter::get_img(img, 0), Adapter::get_img_stride(img), ptr+imgi*zstride, ystride);
 				imgi++;
 			}
 		}
-		err=Adapter::codec_destroy(&ctx);
-		if(err!=Adapter::codec_ok)
-			gapr::report("Failed to destroy decoder: ", Adapter::codec_err_to_string(err));
 	}
 	void do_load(char* ptr, int64_t ystride, int64_t zstride) override {
 		if(!supported)
@@ -410,40 +462,25 @@ class WebmLoader: public gapr::cube_loader {
 		auto width=sizes()[0];
 		copyImage(&firstFrame[0], width*voxel_size(imgType), ptr, ystride);
 
-//#pragma omp parallel
-		{
-#ifdef _WIN64
-			auto id=0u;
-			auto num=1u;
-#else
-			auto id=omp_get_thread_num();
-			auto num=omp_get_num_threads();
-#endif
-			//size_t ileft=1;
-			size_t ileft=0;
-			if(id>0)
-				ileft=1+((buffs.size()-1)*id+num-1)/num;
-			size_t iright=buffs.size();
-			if(id<num-1)
-				iright=1+((buffs.size()-1)*(id+1)+num-1)/num;
-			if(ileft<iright) {
+		// frame 0 was decoded when probing
+		if(buffs.size()>1) {
 #ifdef WITH_VP9
-				if(is_vp9)
-					load_impl<vpx_codec_ctx_t>(ileft, iright, ptr, ystride, zstride);
+			if(is_vp9)
+				load_impl<vpx_codec_ctx_t>(1, buffs.size(), ptr, ystride, zstride);
 #endif
 #ifdef WITH_AV1
-				if(is_av1)
-					load_impl<aom_codec_ctx_t>(ileft, iright, ptr, ystride, zstride);
+			if(is_av1)
+				load_impl<aom_codec_ctx_t>(1, buffs.size(), ptr, ystride, zstride);
 #endif
-			}
 		}
+		decoder.reset();
 	}
 };
 
 
 namespace gapr {
-	std::unique_ptr<cube_loader> make_cube_loader_webm(Streambuf& file) {
-		return std::make_unique<WebmLoader>(file);
+	std::unique_ptr<cube_loader> make_cube_loader_webm(Streambuf& file, unsigned int nthreads) {
+		return std::make_unique<WebmLoader>(file, nthreads);
 	}
 }
 
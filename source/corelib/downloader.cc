@@ -433,6 +433,11 @@ struct CurlThread {
 		}
 	}
 
+	void cancelIdle() {
+		std::unique_lock<std::mutex> lck{mtx_input};
+		queue_nowait.clear();
+	}
+
 	void stop() {
 		std::unique_lock<std::mutex> lck{mtx_input};
 		stopRequested=true;
@@ -442,7 +447,7 @@ struct CurlThread {
 	CurlThread():
 		thread{std::thread{}},
 		stopRequested{false},
-		tot_size{0}, max_size{1024*1024*1024}, job_size_wait{2}, job_size_nowait{0}
+		tot_size{0}, max_size{1024*1024*1024}, job_size_wait{2}, job_size_nowait{2}
 	{
 		auto r=curl_global_init(CURL_GLOBAL_DEFAULT);
 		if(r!=0)
@@ -1175,8 +1180,17 @@ void gapr::downloader::when_idle(std::string&& url) {
 	if(!url.isValid())
 		gapr::report("URL is not valid.");
 #endif
+	std::lock_guard lck{_curl_thread_mtx};
+	if(!_curl_thread)
+		return;
 	return _curl_thread->downloadIfIdle(url);
 }
+void gapr::downloader::cancel_idle() {
+	std::lock_guard lck{_curl_thread_mtx};
+	if(!_curl_thread)
+		return;
+	return _curl_thread->cancelIdle();
+}
 
 void DownloadItem::requestLogin(const std::string& url, const std::string& oldusr, const std::string& oldpwd) {
 	// TODO return error_code and expect password
@@ -39,5 +39,16 @@ namespace {
 			// XXX
 			return !static_cast<bool>(deser);
 		}
+	template<typename T>
+		static bool load_impl(T& d, gapr::archive::view& view) {
+			gapr::Deserializer<T> deser{};
+			do {
+				auto [buf, n]=view.buffer();
+				if(!buf)
+					break;
+				view.consume(deser.load(d, buf, n));
+			} while(deser);
+			return !static_cast<bool>(deser);
+		}
 
 }
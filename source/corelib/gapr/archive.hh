@@ -24,6 +24,7 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 #include <cassert>
 #include <string_view>
 
@@ -45,6 +46,13 @@
  *   end;
  * }
  *
+ * to map file without copying:
+ * (in any thread) {
+ *   get_view; (block by io)
+ *   buffer/consume;
+ *   end; (the read txn, and the memory, kept till here)
+ * }
+ *
  * the archive is more compact if files are added in lexical order.
  *
  */
@@ -60,6 +68,8 @@ namespace gapr {
 			writer get_writer(std::string_view key);
 			class reader;
 			reader get_reader(std::string_view key) const;
+			class view;
+			view get_view(std::string_view key) const;
 
 			std::unique_ptr<std::streambuf> reader_streambuf(std::string_view key) const;
 
@@ -79,6 +89,11 @@ namespace gapr {
 				std::size_t _idx;
 				std::size_t _siz;
 			};
+			struct view_DATA {
+				std::vector<std::pair<const char*, std::size_t>> _chunks;
+				std::size_t _idx;
+				std::size_t _off;
+			};
 			std::shared_ptr<PRIV> _p;
 	};
 
@@ -146,12 +161,51 @@ namespace gapr {
 			friend class archive;
 	};
 
+	/*! all chunks of a file, in the lmdb map */
+	class GAPR_CORE_DECL archive::view {
+		public:
+			constexpr view() noexcept: _p{} { }
+			~view();
+			view(view&& r) noexcept =default;
+			view& operator=(view&& r) noexcept {
+				std::swap(_p, r._p);
+				return *this;
+			}
+
+			explicit operator bool() const noexcept { return _p.get(); }
+
+			/*! rest of the current chunk, {nullptr, 0} at the end */
+			std::pair<const char*, std::size_t> buffer() const noexcept {
+				auto idx=_p->_idx;
+				if(idx>=_p->_chunks.size())
+					return {nullptr, 0};
+				auto [buf, siz]=_p->_chunks[idx];
+				return {buf+_p->_off, siz-_p->_off};
+			}
+			void consume(std::size_t n) noexcept {
+				auto off=(_p->_off+=n);
+				assert(off<=_p->_chunks[_p->_idx].second);
+				if(off>=_p->_chunks[_p->_idx].second) {
+					_p->_idx++;
+					_p->_off=0;
+				}
+			}
+
+		private:
+			std::unique_ptr<view_DATA> _p;
+			explicit view(const std::shared_ptr<PRIV>& apriv, std::string_view key);
+			friend class archive;
+	};
+
 	inline archive::writer archive::get_writer(std::string_view key) {
 		return writer{_p, key};
 	}
 	inline archive::reader archive::get_reader(std::string_view key) const {
 		return reader{_p, key};
 	}
+	inline archive::view archive::get_view(std::string_view key) const {
+		return view{_p, key};
+	}
 
 }
 
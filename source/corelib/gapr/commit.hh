@@ -23,6 +23,7 @@
 #include "gapr/config.hh"
 
 #include "gapr/model.hh"
+#include "gapr/archive.hh"
 
 #include <ctime>
 #include <deque>
@@ -147,6 +148,8 @@ namespace gapr {
 
 		GAPR_CORE_DECL bool save(std::streambuf& str) const;
 		GAPR_CORE_DECL bool load(std::streambuf& str);
+		/*! the delta follows in view */
+		GAPR_CORE_DECL bool load(gapr::archive::view& view);
 	};
 
 	GAPR_CORE_DECL uint64_t to_timestamp(const std::chrono::system_clock::time_point& t);
@@ -248,6 +251,7 @@ namespace gapr {
 			//bool save(gapr::mem_file&& file) noexcept;
 			static bool save(const delta<Typ>& delta, std::streambuf& str);
 			static bool load(delta<Typ>& delta, std::streambuf& str);
+			static bool load(delta<Typ>& delta, gapr::archive::view& view);
 			/*! <0, fail; 0: already ok; >0, fixed */
 			static int cannolize(delta<Typ>& delta) noexcept;
 			static std::ostream& dump(const delta<Typ>& delta, std::ostream& str, unsigned int level, node_id nid0);
@@ -264,6 +268,10 @@ namespace gapr {
 		inline bool load(delta<Typ>& delta, std::streambuf& str) {
 			return delta_traits<void, Typ>::load(delta, str);
 		}
+	template<delta_type Typ>
+		inline bool load(delta<Typ>& delta, gapr::archive::view& view) {
+			return delta_traits<void, Typ>::load(delta, view);
+		}
 	template<delta_type Typ>
 		inline int cannolize(delta<Typ>& delta) noexcept {
 			return delta_traits<void, Typ>::cannolize(delta);
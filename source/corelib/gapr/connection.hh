@@ -89,9 +89,11 @@ namespace gapr {
 		public:
 			explicit server_end() noexcept: _ptr{nullptr} { }
 			server_end(socket&& sock, ssl_context& ssl_ctx):
-				_ptr{new impl{std::move(sock), ssl_ctx}} { }
+				_ptr{new impl{std::move(sock), ssl_ctx}},
+				_info{std::make_shared<impl::RecvInfo>()} { }
 			server_end(std::shared_ptr<boost::asio::ssl::stream<socket>> ssl):
-				_ptr{new impl{std::move(ssl)}} { }
+				_ptr{new impl{std::move(ssl)}},
+				_info{std::make_shared<impl::RecvInfo>()} { }
 
 			explicit operator bool() const noexcept { return _ptr.ptr; }
 
@@ -105,9 +107,16 @@ namespace gapr {
 
 			//void async_alert(hdr) XXX use cases?
 
-			msg_type type_in() const noexcept { return _ptr.typ(); }
-			uint16_t size_in() const noexcept { return _ptr.siz(); }
-			uint64_t size_hint_in() const noexcept { return _ptr.sizhint(); }
+			msg_type type_in() const noexcept { return _info->misc.typ; }
+			uint16_t size_in() const noexcept { return _info->misc.siz; }
+			uint64_t size_hint_in() const noexcept { return _info->misc.sizhint; }
+
+			/*! in the callback of async_recv, a handle bound to the
+			 * request just received.  answer through it, so that
+			 * requests can be served at once with gapr/1.3 peers. */
+			server_end fork() const {
+				return server_end{_ptr, *_info};
+			}
 
 			// _idx**?
 			//server::end::msg msg;
@@ -135,18 +144,27 @@ namespace gapr {
 
 		private:
 			impl::Ptr _ptr;
-			explicit server_end(impl* ptr) noexcept: _ptr{ptr} { }
+			uint16_t _sid{0};
+			std::shared_ptr<impl::RecvInfo> _info;
+			explicit server_end(impl* ptr): _ptr{ptr},
+				_info{std::make_shared<impl::RecvInfo>()} { }
+			server_end(const impl::Ptr& ptr, const impl::RecvInfo& info):
+				_ptr{ptr}, _sid{info.sid},
+				_info{std::make_shared<impl::RecvInfo>(info)} { }
 	};
 
 	class client_end: public connection {
 		public:
 			explicit client_end() noexcept: _ptr{nullptr} { }
 			client_end(const boost::asio::any_io_executor& ex, ssl_context& ssl_ctx):
-				_ptr{new impl{std::move(ex), ssl_ctx}} { }
+				_ptr{new impl{std::move(ex), ssl_ctx}},
+				_info{std::make_shared<impl::RecvInfo>()} { }
 			client_end(socket&& sock, ssl_context& ssl_ctx):
-				_ptr{new impl{std::move(sock), ssl_ctx}} { }
+				_ptr{new impl{std::move(sock), ssl_ctx}},
+				_info{std::make_shared<impl::RecvInfo>()} { }
 			client_end(std::unique_ptr<boost::asio::ssl::stream<socket>> ssl):
-				_ptr{new impl{std::move(ssl), false}} { }
+				_ptr{new impl{std::move(ssl), false}},
+				_info{std::make_shared<impl::RecvInfo>()} { }
 
 			explicit operator bool() const noexcept { return _ptr.ptr; }
 
@@ -159,13 +177,20 @@ namespace gapr {
 			void close() noexcept { _ptr->do_close(); }
 
 
-			msg_type type_in() const noexcept { return _ptr.typ(); }
-			uint16_t size_in() const noexcept { return _ptr.siz(); }
-			uint64_t size_hint_in() const noexcept { return _ptr.sizhint(); }
+			msg_type type_in() const noexcept { return _info->misc.typ; }
+			uint16_t size_in() const noexcept { return _info->misc.siz; }
+			uint64_t size_hint_in() const noexcept { return _info->misc.sizhint; }
 
 			auto get_executor() const {
 				return _ptr->sock().get_executor();
 			}
+			/*! a handle for a new exchange.  with gapr/1.3 peers, it
+			 * runs concurrently with those of other handles, otherwise
+			 * exchanges are queued and done one at a time. */
+			client_end fork() const {
+				return client_end{_ptr, _ptr->do_fork()};
+			}
+
 			//cancel //close //is_open
 			//*shutdown
 			//void discard_write();
@@ -187,7 +212,12 @@ namespace gapr {
 				void async_write(std::string_view buf, bool eof, Cb&& cb) const;
 		private:
 			impl::Ptr _ptr;
-			explicit client_end(impl* ptr) noexcept: _ptr{ptr} { }
+			uint16_t _sid{0};
+			std::shared_ptr<impl::RecvInfo> _info;
+			explicit client_end(impl* ptr): _ptr{ptr},
+				_info{std::make_shared<impl::RecvInfo>()} { }
+			client_end(const impl::Ptr& ptr, uint16_t sid): _ptr{ptr}, _sid{sid},
+				_info{std::make_shared<impl::RecvInfo>()} { }
 	};
 
 #if 0
@@ -205,27 +235,27 @@ namespace gapr {
 
 	template<typename Cb>
 		inline void server_end::async_recv(Cb&& cb) const {
-			_ptr->do_recv_req(cb_wrapper::make_unique<impl::RecvHdrOp>(std::move(cb)));
+			_ptr->do_recv_req(cb_wrapper::make_unique<impl::RecvHdrOp>(std::move(cb), _info));
 		}
 	template<typename Cb>
 		inline void server_end::async_send(msg_hdr&& hdr, Cb&& cb) const {
-			_ptr->do_send_res(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), nullptr));
+			_ptr->do_send_res(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), nullptr), _sid);
 		}
 	template<typename Cb>
 		inline void server_end::async_send(msg_hdr&& hdr, uint16_t var, std::string_view buf, Cb&& cb) const {
-			_ptr->do_send_res(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, buf));
+			_ptr->do_send_res(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, buf), _sid);
 		}
 	template<typename Cb>
 		inline void server_end::async_send(msg_hdr&& hdr, uint16_t var, uint64_t szhint, Cb&& cb) const {
-			_ptr->do_send_res(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, szhint));
+			_ptr->do_send_res(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, szhint), _sid);
 		}
 	template<typename Cb>
 		inline void server_end::async_read(buffer_view buf, Cb&& cb) const {
-			_ptr->do_read_str(cb_wrapper::make_unique<impl::ReadStrOp>(std::move(cb), buf));
+			_ptr->do_read_str(cb_wrapper::make_unique<impl::ReadStrOp>(std::move(cb), buf), _sid);
 		}
 	template<typename Cb>
 		inline void server_end::async_write(std::string_view buf, bool eof, Cb&& cb) const {
-			_ptr->do_write_str(cb_wrapper::make_unique<impl::SendChkOp>(std::move(cb), buf, eof));
+			_ptr->do_write_str(cb_wrapper::make_unique<impl::SendChkOp>(std::move(cb), buf, eof), _sid);
 		}
 
 	template<typename Cb>
@@ -245,27 +275,27 @@ namespace gapr {
 
 	template<typename Cb>
 		inline void client_end::async_send(msg_hdr&& hdr, Cb&& cb) const {
-			_ptr->do_send_req(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), nullptr));
+			_ptr->do_send_req(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), nullptr), _sid);
 		}
 	template<typename Cb>
 		inline void client_end::async_send(msg_hdr&& hdr, uint16_t var, std::string_view buf, Cb&& cb) const {
-			_ptr->do_send_req(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, buf));
+			_ptr->do_send_req(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, buf), _sid);
 		}
 	template<typename Cb>
 		inline void client_end::async_send(msg_hdr&& hdr, uint16_t var, uint64_t szhint, Cb&& cb) const {
-			_ptr->do_send_req(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, szhint));
+			_ptr->do_send_req(cb_wrapper::make_unique<impl::SendHdrOp>(std::move(cb), std::move(hdr._hdr), var, szhint), _sid);
 		}
 	template<typename Cb>
 		inline void client_end::async_recv(Cb&& cb) const {
-			_ptr->do_recv_reply(cb_wrapper::make_unique<impl::RecvHdrOp>(std::move(cb)));
+			_ptr->do_recv_reply(cb_wrapper::make_unique<impl::RecvHdrOp>(std::move(cb), _info), _sid);
 		}
 	template<typename Cb>
 		inline void client_end::async_read(buffer_view buf, Cb&& cb) const {
-			_ptr->do_read_str(cb_wrapper::make_unique<impl::ReadStrOp>(std::move(cb), buf));
+			_ptr->do_read_str(cb_wrapper::make_unique<impl::ReadStrOp>(std::move(cb), buf), _sid);
 		}
 	template<typename Cb>
 		inline void client_end::async_write(std::string_view buf, bool eof, Cb&& cb) const {
-			_ptr->do_write_str(cb_wrapper::make_unique<impl::SendChkOp>(std::move(cb), buf, eof));
+			_ptr->do_write_str(cb_wrapper::make_unique<impl::SendChkOp>(std::move(cb), buf, eof), _sid);
 		}
 
 	namespace unit_test { int chk_connection(); }
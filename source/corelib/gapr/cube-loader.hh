@@ -66,7 +66,8 @@ namespace gapr {
 			bool _valid;
 	};
 
-	GAPR_CORE_DECL std::unique_ptr<cube_loader> make_cube_loader(std::string_view type_hint, Streambuf& file);
+	/*! nthreads, hint on the number of decoding threads (webm only) */
+	GAPR_CORE_DECL std::unique_ptr<cube_loader> make_cube_loader(std::string_view type_hint, Streambuf& file, unsigned int nthreads=1);
 
 }
 
@@ -27,6 +27,7 @@
 #include <vector>
 #include <atomic>
 #include <string>
+#include <cstdint>
 
 namespace gapr {
 
@@ -69,13 +70,31 @@ namespace gapr {
 		return (static_cast<unsigned int>(type)&0xF0)==0x10;
 	}
 
+	/*! large cube buffers are recycled instead of being unmapped,
+	 * to avoid faulting in the same amount of memory again.
+	 */
+	struct cube_pool_stats {
+		uint64_t hits;
+		uint64_t misses;
+		std::size_t cached; // bytes
+		std::size_t budget;
+	};
+	/*! budget, max. bytes kept for reuse (default GAPR_CUBE_POOL_MB or 1GiB).
+	 * populate, prefault new buffers.
+	 * huge_pages, advise huge pages for new buffers (linux).
+	 */
+	GAPR_CORE_DECL void cube_pool_config(std::size_t budget, bool populate, bool huge_pages);
+	/*! release cached buffers until at most keep bytes remain */
+	GAPR_CORE_DECL void cube_pool_trim(std::size_t keep=0) noexcept;
+	GAPR_CORE_DECL cube_pool_stats get_cube_pool_stats() noexcept;
+
 	class cube_PRIV {
 		struct Head {
 			std::atomic<unsigned int> refc;
 			cube_type type;
 			std::array<unsigned int, 3> sizes;
 			std::size_t ystride;
-			void* _unused{nullptr};
+			std::size_t _pool_size{0}; // 0 if not from the pool
 			constexpr Head(cube_type type, std::array<unsigned int, 3> sizes, std::size_t ystride) noexcept:
 				refc{1}, type{type}, sizes{sizes}, ystride{ystride} { }
 		};
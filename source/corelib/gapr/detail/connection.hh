@@ -25,11 +25,27 @@
 
 #include <boost/asio/steady_timer.hpp>
 
+#include <deque>
+#include <unordered_map>
+
 struct gapr::connection::impl {
 	/* constants */
 	static constexpr std::size_t MAX_HEADER=512;
 	static constexpr std::size_t ALLOC_HEADER=4*512;
 	static constexpr std::size_t MAX_CHUNK=16*1024;
+	/*! with peers speaking gapr/1.2 */
+	static constexpr std::size_t MAX_CHUNK_LARGE=256*1024;
+	/*! frames gathered in one write, small ones are copied to a
+	 * stage next to their headers */
+	static constexpr std::size_t MAX_GATHER=16;
+	static constexpr std::size_t SEND_COPY=4*1024;
+	static constexpr std::size_t SEND_STAGE=64*1024;
+	/*! with peers speaking gapr/1.3, input for a stream nobody is
+	 * reading yet is held up to this size, and requests up to this
+	 * count, before the connection stops reading */
+	static constexpr std::size_t MAX_STREAM_BUF=256*1024;
+	static constexpr std::size_t MAX_PENDING_REQS=64;
+	static constexpr std::size_t SWEEP_STREAMS=64;
 
 	/* aliases */
 	using ssl_stream=boost::asio::ssl::stream<socket>;
@@ -133,8 +149,13 @@ struct gapr::connection::impl {
 		uint16_t siz;
 		uint64_t sizhint;
 	};
+	/*! what a handle knows of the last message it received.  filled
+	 * before the callback is posted, shared by copies of the handle */
+	struct RecvInfo {
+		InstMisc misc{msg_type::hdr_only, 0, 0, 0};
+		uint16_t sid{0};
+	};
 	struct InstInfo {
-		InstMisc misc;
 		unsigned char st0{0};
 		unsigned char st1{0};
 	};
@@ -227,19 +248,6 @@ struct gapr::connection::impl {
 		explicit operator bool() const noexcept { return ptr; }
 		impl* operator->() const noexcept { return ptr; }
 		void release() noexcept { assert(ptr); ptr=nullptr; }
-
-		msg_type typ() const noexcept {
-			assert(ptr);
-			return ptr->_insts.misc.typ;
-		}
-		uint16_t siz() const noexcept {
-			assert(ptr);
-			return ptr->_insts.misc.siz;
-		}
-		uint64_t sizhint() const noexcept {
-			assert(ptr);
-			return ptr->_insts.misc.sizhint;
-		}
 	};
 	impl* api_lock();
 	struct Lock {
@@ -271,6 +279,12 @@ struct gapr::connection::impl {
 		void complete(const error_code& ec, socket&& sock) { return cb_wrapper_call(ec, std::move(sock)); }
 	};
 	struct RecvHdrOp: cb_wrapper::add<void(const error_code&, const msg_hdr_in&)> {
+		std::shared_ptr<RecvInfo> info;
+		explicit RecvHdrOp(std::shared_ptr<RecvInfo> info) noexcept: info{std::move(info)} { }
+		void set_info(uint16_t sid, const InstMisc& misc) noexcept {
+			info->misc=misc;
+			info->sid=sid;
+		}
 		void complete(const error_code& ec) { return cb_wrapper_call(ec, reinterpret_cast<const msg_hdr_in&>(_null_hdr)); }
 		void complete(const error_code& ec, const msg_hdr_in& hdr) { return cb_wrapper_call(ec, hdr); }
 	};
@@ -284,6 +298,7 @@ struct gapr::connection::impl {
 			Chunk,
 		};
 		int type;
+		uint16_t sid{0};
 		SendOp* next;
 		SendOp(int type) noexcept: type{type} { }
 		virtual ~SendOp() { }
@@ -313,12 +328,13 @@ struct gapr::connection::impl {
 	struct SendChkOp: SendChkOp_ {
 		WeakPtr<false, true, false> wptr{};
 		std::size_t nwrite;
+		std::size_t nsend; // in the write in progress
 		std::string_view buf;
 		std::array<unsigned char, 5> hdr;
 		bool eof;
 		void complete(const error_code& ec) { return cb_wrapper_call(ec, nwrite); }
 		SendChkOp(std::string_view buf, bool eof):
-			SendChkOp_{Chunk}, nwrite{0}, buf{buf}, eof{eof}
+			SendChkOp_{Chunk}, nwrite{0}, nsend{0}, buf{buf}, eof{eof}
 		{
 		}
 	};
@@ -366,17 +382,35 @@ struct gapr::connection::impl {
 			}
 		}
 	};
+	/*! one exchange at a time per stream.  only stream 0 is used,
+	 * unless the peer speaks gapr/1.3 */
+	struct Stream {
+		InstInfo insts{};
+		std::unique_ptr<RecvHdrOp> recv_reply;
+		std::unique_ptr<ReadStrOp> read;
+		std::deque<std::unique_ptr<SendHdrOp>> delayed_req;
+
+		/* input arrived before its op (gapr/1.3) */
+		bool expect{false};
+		bool has_hdr{false};
+		bool hdr_has_body;
+		hdr_info_base hdr_info;
+		InstMisc hdr_misc;
+		std::string hdr_line;
+		std::string body;
+		std::size_t body_off{0};
+		bool body_eof{false};
+	};
 	struct Ops { /* ops, be aware of cyclic ownership */
 		std::unique_ptr<RecvHdrOp> recv; // notifs, reqs
-		std::unique_ptr<RecvHdrOp> recv_reply;
 		SendQue send_que0; //hdr(notif) (!!!no code)
 		SendQue send_que1; //hdr hdr+buf code+chunk
 		SendQue send_que2; //hdr hdr+buf:  pending reqs
 		std::unique_ptr<SendHdrOp> send_que3;
-		std::unique_ptr<ReadStrOp> read;
 
-		std::unique_ptr<SendHdrOp> delayed_req;
 		std::unique_ptr<RecvHdrOp> delayed_recv;
+		std::unordered_map<uint16_t, Stream> streams;
+		std::deque<uint16_t> pending_reqs;
 		//send hdr code write
 		//
 		//recv hdr code read
@@ -398,6 +432,13 @@ struct gapr::connection::impl {
 	union { steady_timer _timer; };
 	union { Ops _ops; };
 	std::size_t _read_ops_n{0}, _recv_ops_reply_n{0};
+	bool _mux{false};
+	uint16_t _next_sid{0};
+	std::size_t _mux_expect{0}; // streams with input to come
+
+	/* write cache */
+	std::size_t _max_chunk{MAX_CHUNK};
+	std::unique_ptr<std::array<unsigned char, SEND_STAGE>> _send_stage;
 
 	/* read cache */
 	std::array<unsigned char, MAX_CHUNK> _recv_buf;
@@ -408,20 +449,27 @@ struct gapr::connection::impl {
 	unsigned char _recv_msg_code;
 	// no need** uint16_t _recv_msg_typ;
 	// no need** uint64_t _recv_msg_len64;
-	uint16_t _recv_chk_left;
+	uint32_t _recv_chk_left;
 	bool _recv_chk_is_eof;
 	int _recv_st;
 	int _recv_st_next;
+	uint16_t _recv_sid;
 	bool _recv_has_body;
 	bool _recv_is_notif;
 	bool _is_srv;
 
-	/* seqs and insts */
-	InstInfo _insts;
-
 	auto& sock() noexcept {
 		return *_ssl;
 	}
+	Stream& stream(uint16_t sid) noexcept {
+		return _ops.streams[sid];
+	}
+	void set_expect(Stream& st, bool v) noexcept {
+		if(st.expect!=v) {
+			st.expect=v;
+			v?++_mux_expect:--_mux_expect;
+		}
+	}
 	/// //////////////////////////
 	// ////////////////////////////////////////////////
 
@@ -463,17 +511,22 @@ struct gapr::connection::impl {
 	void do_shutdown_srv(std::unique_ptr<ShutdownOp>&& op);
 	void do_shutdown_cli(std::unique_ptr<ShutdownOp>&& op);
 
+	GAPR_CORE_DECL uint16_t do_fork();
+	void sweep_streams() noexcept;
 	GAPR_CORE_DECL void do_recv_req(std::unique_ptr<RecvHdrOp>&& op);
-	void do_recv_reply(std::unique_ptr<RecvHdrOp>&& op);
-	void do_send_req(std::unique_ptr<SendHdrOp>&& op);
-	GAPR_CORE_DECL void do_send_res(std::unique_ptr<SendHdrOp>&& op);
+	void do_recv_reply(std::unique_ptr<RecvHdrOp>&& op, uint16_t sid);
+	void do_recv_pending(std::unique_ptr<RecvHdrOp>&& op, uint16_t sid);
+	void do_send_req(std::unique_ptr<SendHdrOp>&& op, uint16_t sid);
+	GAPR_CORE_DECL void do_send_res(std::unique_ptr<SendHdrOp>&& op, uint16_t sid);
 	void do_send_impl_que1(WeakPtr<false, true, false>&& wptr);
 	void do_send_impl_next(WeakPtr<false, true, false>&& wptr);
 	void do_send_impl_chk(WeakPtr<false, true, false>&& wptr);
 	void do_recv_impl(WeakPtr<true, false, false>&& wptr, bool in_api);
-	std::unique_ptr<RecvHdrOp> do_recv_impl_get_op() noexcept;
-	GAPR_CORE_DECL void do_read_str(std::unique_ptr<ReadStrOp>&& op);
-	GAPR_CORE_DECL void do_write_str(std::unique_ptr<SendChkOp>&& op);
+	std::unique_ptr<RecvHdrOp> do_recv_impl_get_op(bool& kept) noexcept;
+	void do_recv_impl_abort(const error_code& ec, const error_code& ec_reply, const error_code& ec_read);
+	std::unique_ptr<ReadStrOp> take_pending(uint16_t sid, Stream& st, bool& is_eof);
+	GAPR_CORE_DECL void do_read_str(std::unique_ptr<ReadStrOp>&& op, uint16_t sid);
+	GAPR_CORE_DECL void do_write_str(std::unique_ptr<SendChkOp>&& op, uint16_t sid);
 
 	void start_timer();
 	void keep_heartbeat(WeakPtr<false, false, true>&& wptr);
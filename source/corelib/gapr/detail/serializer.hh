@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <array>
+#include <utility>
 
 // XXX remove states and reduce complexity
 // consider cases: mem_file file socket(use cache object)
@@ -530,12 +531,169 @@ namespace gapr { namespace Serializer_PRIV_v0 {
 			}
 		};
 
+	/*! stateless codec for elements with bounded encoded size, so
+	 * vec_saver can take a run of them in a tight loop when the buffer
+	 * surely holds the run.  max_size==0: unbounded (vectors).
+	 */
+	template<typename T, typename CTX, typename=void> struct fast_saver {
+		constexpr static std::size_t max_size=0;
+	};
+	template<typename T>
+		inline unsigned char* fast_save_enc(unsigned char* p, T obj) {
+			while(obj>=0x80) {
+				*(p++)=static_cast<unsigned char>(obj)|0x80;
+				obj>>=7;
+			}
+			*(p++)=static_cast<unsigned char>(obj);
+			return p;
+		}
+	/*! nullptr if longer than any value of T, left to the state machine */
+	template<typename T>
+		inline const unsigned char* fast_load_enc(const unsigned char* p, T& obj) {
+			constexpr int maxn=(sizeof(T)*8+6)/7;
+			T v{0};
+			for(int i=0; i<maxn; i++) {
+				auto c=p[i];
+				v|=(static_cast<T>(c&0x7f)<<(i*7));
+				if(!(c&0x80)) {
+					obj=v;
+					return p+i+1;
+				}
+			}
+			return nullptr;
+		}
+	template<typename T, typename CTX> struct fast_saver<T, CTX,
+		std::enable_if_t<std::is_integral<T>::value && std::is_same<typename CTX::PT, void_t>::value>> {
+			using UT=std::make_unsigned_t<T>;
+			constexpr static std::size_t max_size=sizeof(T)<=1?1:(sizeof(T)*8+6)/7;
+			static unsigned char* save(unsigned char* p, T obj, void_t obj0) {
+				if constexpr(sizeof(T)<=1) {
+					*(p++)=static_cast<unsigned char>(static_cast<UT>(obj));
+					return p;
+				} else if constexpr(std::is_signed<T>::value) {
+					return fast_save_enc<UT>(p, static_cast<UT>((obj<<1)^(obj>>(sizeof(T)*8-1))));
+				} else {
+					return fast_save_enc<T>(p, obj);
+				}
+			}
+			static const unsigned char* load(const unsigned char* p, T& obj, void_t obj0) {
+				if constexpr(sizeof(T)<=1) {
+					reinterpret_cast<UT&>(obj)=*(p++);
+					return p;
+				} else if constexpr(std::is_signed<T>::value) {
+					UT v;
+					p=fast_load_enc<UT>(p, v);
+					if(p)
+						obj=static_cast<T>((v&1)?((v>>1)^(~UT{0})):(v>>1));
+					return p;
+				} else {
+					return fast_load_enc<T>(p, obj);
+				}
+			}
+		};
+	template<typename T, typename CTX> struct fast_saver<T, CTX,
+		std::enable_if_t<std::is_integral<T>::value && !std::is_same<typename CTX::PT, void_t>::value>> {
+			using Td=typename int_saver<T, CTX>::Td;
+			using base=fast_saver<Td, s_ctx<typename CTX::ST, CTX::SI, CTX::N, CTX::L0, void_t>>;
+			constexpr static std::size_t max_size=base::max_size;
+			static unsigned char* save(unsigned char* p, T obj, typename CTX::PT obj0) {
+				Td d=gapr::SerializerPredictor<typename CTX::ST, CTX::SI>::sub(obj, obj0);
+				return base::save(p, d, void_t{});
+			}
+			static const unsigned char* load(const unsigned char* p, T& obj, typename CTX::PT obj0) {
+				Td d;
+				p=base::load(p, d, void_t{});
+				if(p)
+					obj=static_cast<T>(gapr::SerializerPredictor<typename CTX::ST, CTX::SI>::add(d, obj0));
+				return p;
+			}
+		};
+	template<typename T, typename CTX> struct fast_saver<T, CTX,
+		std::enable_if_t<s_traits<T>::is_tuple!=0>> {
+			constexpr static std::size_t S=st_traits<T, 0>::tup_size;
+			template<std::size_t I> using sub=fast_saver<typename st_traits<T, I>::map_type, s_ctx<T, I, CTX::N, CTX::L0, typename st_traits<typename CTX::PT, I>::map_type>>;
+			template<std::size_t... Is>
+				constexpr static std::size_t sum_size(std::index_sequence<Is...>) {
+					return ((sub<Is>::max_size>0) && ...)?(sub<Is>::max_size+...):0;
+				}
+			constexpr static std::size_t max_size=sum_size(std::make_index_sequence<S>{});
+			template<std::size_t... Is>
+				static unsigned char* save(unsigned char* p, const T& obj, const typename CTX::PT& obj0, std::index_sequence<Is...>) {
+					((p=sub<Is>::save(p, gapr::SerializerAdaptor<T, Is>::map(obj), gapr::SerializerAdaptor<typename CTX::PT, Is>::map(obj0))), ...);
+					return p;
+				}
+			static unsigned char* save(unsigned char* p, const T& obj, const typename CTX::PT& obj0) {
+				return save(p, obj, obj0, std::make_index_sequence<S>{});
+			}
+			template<std::size_t... Is>
+				static const unsigned char* load(const unsigned char* p, T& obj, const typename CTX::PT& obj0, std::index_sequence<Is...>) {
+					(... && (p=sub<Is>::load(p, gapr::SerializerAdaptor<T, Is>::map(obj), gapr::SerializerAdaptor<typename CTX::PT, Is>::map(obj0))));
+					return p;
+				}
+			static const unsigned char* load(const unsigned char* p, T& obj, const typename CTX::PT& obj0) {
+				return load(p, obj, obj0, std::make_index_sequence<S>{});
+			}
+		};
+
 	template<typename T, typename CTX> struct vec_saver<T, CTX,
 		std::enable_if_t<st_traits<typename CTX::ST, CTX::SI>::use_pred>
 			> {
 				using iter_type=typename sv_traits<T>::iter_type;
 				using citer_type=typename sv_traits<T>::citer_type;
 				constexpr static std::size_t L1=CTX::L0+stk_usage<iter_type>()+stk_usage<std::size_t>()+stk_usage<unsigned int>();
+				using fast=fast_saver<typename sv_traits<T>::map_type, s_ctx<typename CTX::ST, CTX::SI, CTX::N, L1, typename sv_traits<T>::map_type>>;
+				/*! at an element boundary, take the elements that surely
+				 * fit, all but the last, without the state machine */
+				static bool save_run(State<CTX::N>& st, unsigned char* eptr) {
+					if(st.bufn<=BUF_SIZ)
+						return false;
+					if constexpr(fast::max_size>0) {
+						auto& cnt=stk_cnt<CTX::L0, iter_type>(st);
+						auto n=(st.bufn-BUF_SIZ)/fast::max_size;
+						if(n>cnt-1)
+							n=cnt-1;
+						if(n>0) {
+							auto it=stk_iter<CTX::L0, citer_type>(st);
+							auto p=eptr-st.bufn;
+							for(std::size_t i=0; i<n; i++) {
+								auto it1=it;
+								++it1;
+								p=fast::save(p, *it1, *it);
+								it=it1;
+							}
+							stk_iter<CTX::L0, citer_type>(st)=it;
+							cnt-=n;
+							st.bufn=eptr-p;
+						}
+					}
+					return st.bufn>BUF_SIZ;
+				}
+				static bool load_run(State<CTX::N>& st, const unsigned char* eptr) {
+					if constexpr(fast::max_size>0) {
+						auto& cnt=stk_cnt<CTX::L0, iter_type>(st);
+						auto n=st.bufn/fast::max_size;
+						if(n>cnt-1)
+							n=cnt-1;
+						if(n>0) {
+							auto it=stk_iter<CTX::L0, iter_type>(st);
+							auto p=eptr-st.bufn;
+							std::size_t i=0;
+							for(; i<n; i++) {
+								auto it1=it;
+								++it1;
+								auto q=fast::load(p, *it1, *it);
+								if(!q)
+									break;
+								p=q;
+								it=it1;
+							}
+							stk_iter<CTX::L0, iter_type>(st)=it;
+							cnt-=i;
+							st.bufn=eptr-p;
+						}
+					}
+					return st.bufn>0;
+				}
 				static bool save(State<CTX::N>& st, const T& obj, unsigned char* eptr, const typename CTX::PT& obj0) {
 					if(L1>st.stkn) {
 						st.stkn=L1;
@@ -575,7 +733,7 @@ namespace gapr { namespace Serializer_PRIV_v0 {
 									break;
 								stk_cnt<CTX::L0, iter_type>(st)--;
 								stk_iter<CTX::L0, iter_type>(st)=st1;
-								if(st.bufn<=BUF_SIZ)
+								if(!save_run(st, eptr))
 									return false;
 							} while(true);
 
@@ -620,7 +778,7 @@ namespace gapr { namespace Serializer_PRIV_v0 {
 									break;
 								stk_cnt<CTX::L0, iter_type>(st)--;
 								stk_iter<CTX::L0, iter_type>(st)=st1;
-								if(st.bufn<=0)
+								if(!load_run(st, eptr))
 									return false;
 							} while(true);
 					}
@@ -634,6 +792,50 @@ namespace gapr { namespace Serializer_PRIV_v0 {
 				using iter_type=typename sv_traits<T>::iter_type;
 				using citer_type=typename sv_traits<T>::citer_type;
 				constexpr static std::size_t L1=CTX::L0+stk_usage<iter_type>()+stk_usage<std::size_t>()+stk_usage<unsigned int>();
+				using fast=fast_saver<typename sv_traits<T>::map_type, s_ctx<typename CTX::ST, CTX::SI, CTX::N, L1>>;
+				static bool save_run(State<CTX::N>& st, unsigned char* eptr) {
+					if(st.bufn<=BUF_SIZ)
+						return false;
+					if constexpr(fast::max_size>0) {
+						auto& cnt=stk_cnt<CTX::L0, iter_type>(st);
+						auto n=(st.bufn-BUF_SIZ)/fast::max_size;
+						if(n>cnt-1)
+							n=cnt-1;
+						if(n>0) {
+							auto it=stk_iter<CTX::L0, citer_type>(st);
+							auto p=eptr-st.bufn;
+							for(std::size_t i=0; i<n; i++, ++it)
+								p=fast::save(p, *it, void_t{});
+							stk_iter<CTX::L0, citer_type>(st)=it;
+							cnt-=n;
+							st.bufn=eptr-p;
+						}
+					}
+					return st.bufn>BUF_SIZ;
+				}
+				static bool load_run(State<CTX::N>& st, const unsigned char* eptr) {
+					if constexpr(fast::max_size>0) {
+						auto& cnt=stk_cnt<CTX::L0, iter_type>(st);
+						auto n=st.bufn/fast::max_size;
+						if(n>cnt-1)
+							n=cnt-1;
+						if(n>0) {
+							auto it=stk_iter<CTX::L0, iter_type>(st);
+							auto p=eptr-st.bufn;
+							std::size_t i=0;
+							for(; i<n; i++, ++it) {
+								auto q=fast::load(p, *it, void_t{});
+								if(!q)
+									break;
+								p=q;
+							}
+							stk_iter<CTX::L0, iter_type>(st)=it;
+							cnt-=i;
+							st.bufn=eptr-p;
+						}
+					}
+					return st.bufn>0;
+				}
 				static bool save(State<CTX::N>& st, const T& obj, unsigned char* eptr, const typename CTX::PT& obj0) {
 					//const char* format="                            save %zd\n";
 					//const char* format2="                            end\n";
@@ -664,7 +866,7 @@ namespace gapr { namespace Serializer_PRIV_v0 {
 									break;
 								stk_cnt<CTX::L0, iter_type>(st)--;
 								++stk_iter<CTX::L0, iter_type>(st);
-								if(st.bufn<=BUF_SIZ)
+								if(!save_run(st, eptr))
 									return false;
 							} while(true);
 					}
@@ -696,7 +898,7 @@ namespace gapr { namespace Serializer_PRIV_v0 {
 									break;
 								stk_cnt<CTX::L0, iter_type>(st)--;
 								++stk_iter<CTX::L0, iter_type>(st);
-								if(st.bufn<=0)
+								if(!load_run(st, eptr))
 									return false;
 							} while(true);
 					}
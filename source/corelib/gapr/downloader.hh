@@ -74,7 +74,12 @@ namespace gapr {
 			int progress() { return 0; }
 #endif
 
+			/*! download url into the cache when nothing else is waiting.
+			 * aborted as soon as a waited download starts, most recent first.
+			 */
 			static void when_idle(std::string&& url);
+			/*! drop queued when_idle requests */
+			static void cancel_idle();
 
 			constexpr static int FINISHED=1001;
 			constexpr static int TOTAL=1000;
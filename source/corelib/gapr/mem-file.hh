@@ -27,6 +27,7 @@
 //#include <utility>
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 
 /*! two modes
  * flat:     data        |info
@@ -35,9 +36,27 @@
 
 namespace gapr {
 
+	/*! counters of the block pool backing mem_file.
+	 * tiers[0] for BLK_SIZ1 blocks, tiers[1] for BLK_SIZ2 blocks.
+	 */
+	struct mem_file_stats {
+		struct tier {
+			std::size_t block_size;
+			uint64_t allocs;
+			uint64_t frees;
+			uint64_t sys_allocs;
+			uint64_t sys_frees;
+			std::size_t cached; // in the shared free list
+		} tiers[2];
+		bool huge_pages;
+	};
+	GAPR_CORE_DECL mem_file_stats get_mem_file_stats() noexcept;
+
 	class mem_file_PRIV {
+		public:
 		static constexpr std::size_t BLK_SIZ1=4*1024; // XXX hold most deltas
 		static constexpr std::size_t BLK_SIZ2=256*1024;
+		private:
 
 		struct Head {
 			std::atomic<unsigned int> refc;
@@ -67,6 +86,7 @@ namespace gapr {
 
 		GAPR_CORE_DECL static Head* alloc(bool flat);
 		GAPR_CORE_DECL static void destroy(Head* p) noexcept;
+		static void free_index(Head* p) noexcept;
 		static void try_ref(Head* p) noexcept {
 			if(p)
 				p->refc.fetch_add(1);
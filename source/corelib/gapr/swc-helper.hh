@@ -25,6 +25,7 @@
 #include "gapr/vec3.hh"
 
 #include <unordered_set>
+#include <memory>
 #include <ostream>
 #include <istream>
 #include <cassert>
@@ -75,9 +76,11 @@ namespace gapr {
 
 	class GAPR_CORE_DECL swc_input {
 		public:
-			explicit swc_input(std::istream& base):
-				_base{base} { }
-			~swc_input() { }
+			explicit swc_input(std::istream& base);
+			/*! reads in blocks of about block_size bytes and parses them
+			 * on up to jobs threads, yields the same as above */
+			swc_input(std::istream& base, unsigned int jobs, std::size_t block_size=4*1024*1024);
+			~swc_input();
 			swc_input(const swc_input&) =delete;
 			swc_input& operator=(const swc_input&) =delete;
 
@@ -141,6 +144,10 @@ namespace gapr {
 			std::size_t _annot_skip, _annot_keyl, _annot_skip2;
 			swc_node _cur_node;
 			std::size_t _line_no{0};
+			struct block;
+			struct blocks;
+			std::unique_ptr<blocks> _blks;
+			bool read_blocks();
 	};
 
 }
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <unordered_map>
 #include <filesystem>
+#include <functional>
 
 #if defined(__LITTLE_ENDIAN__) && !defined(__BIG_ENDIAN__)
 #define GAPR_BYTE_ORDER 4321
@@ -323,6 +324,16 @@ namespace gapr {
 
 	GAPR_CORE_DECL std::string to_url_if_path(std::string_view path);
 
+	/*! runs fn(i, worker) for i in [0, n), on the calling thread (worker 0)
+	 * and up to nworkers-1 helpers started with post().  the caller may
+	 * itself be on the pool that post() uses; late helpers do nothing.
+	 * the first exception is rethrown, after every item is done.
+	 */
+	GAPR_CORE_DECL void parallel_for(std::size_t n, unsigned int nworkers, const std::function<void(std::function<void()>&&)>& post, const std::function<void(std::size_t, unsigned int)>& fn);
+
+	/*! resident and peak resident set (KiB), 0 if unknown */
+	GAPR_CORE_DECL std::pair<std::size_t, std::size_t> mem_usage();
+
 	struct cli_helper {
 		GAPR_CORE_DECL explicit cli_helper();
 		GAPR_CORE_DECL ~cli_helper();
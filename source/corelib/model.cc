@@ -26,6 +26,7 @@
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <random>
 
 #include "config.hh"
 
@@ -189,6 +190,9 @@ namespace gapr {
 	bool commit_info::load(std::streambuf& str) {
 		return load_impl<commit_info>(*this, str);
 	}
+	bool commit_info::load(gapr::archive::view& view) {
+		return load_impl<commit_info>(*this, view);
+	}
 	bool commit_info::save(std::streambuf& str) const {
 		return save_impl<commit_info>(*this, str);
 	}
@@ -857,6 +861,10 @@ namespace gapr {
 		bool delta_traits<void, Typ>::load(delta<Typ>& delta, std::streambuf& str) {
 			return load_impl(delta, str);
 		}
+	template<delta_type Typ>
+		bool delta_traits<void, Typ>::load(delta<Typ>& delta, gapr::archive::view& view) {
+			return load_impl(delta, view);
+		}
 	template<delta_type Typ>
 		bool delta_traits<void, Typ>::save(const delta<Typ>& delta, std::streambuf& str) {
 			return save_impl(delta, str);
@@ -879,3 +887,149 @@ namespace gapr {
 	template struct delta_traits<void, delta_type::reset_proofread_>;
 }
 
+
+namespace {
+	template<typename T>
+		std::vector<unsigned char> test_save(const T& obj, std::mt19937& rng, std::size_t maxn) {
+			std::vector<unsigned char> buf;
+			gapr::Serializer<T> ser{};
+			do {
+				auto n=std::uniform_int_distribution<std::size_t>{1, maxn}(rng);
+				auto i=buf.size();
+				buf.resize(i+n);
+				buf.resize(i+ser.save(obj, &buf[i], n));
+			} while(ser);
+			return buf;
+		}
+	template<typename T>
+		bool test_load(T& obj, const std::vector<unsigned char>& buf, std::mt19937& rng, std::size_t maxn) {
+			gapr::Deserializer<T> deser{};
+			std::size_t i=0;
+			do {
+				auto n=std::uniform_int_distribution<std::size_t>{1, maxn}(rng);
+				if(n>buf.size()-i)
+					n=buf.size()-i;
+				if(n<=0)
+					return false;
+				i+=deser.load(obj, &buf[i], n);
+			} while(deser);
+			return i==buf.size();
+		}
+	/*! random walk, with jumps to extremes to get the longest varints */
+	gapr::node_attr::data_type test_node(std::mt19937& rng, const gapr::node_attr::data_type& prev) {
+		std::uniform_int_distribution<int> pick{0, 15};
+		auto node=prev;
+		for(auto& v: node.first) {
+			switch(pick(rng)) {
+				case 0:
+					v=std::numeric_limits<int32_t>::min();
+					break;
+				case 1:
+					v=std::numeric_limits<int32_t>::max();
+					break;
+				case 2:
+					v=std::uniform_int_distribution<int32_t>{}(rng);
+					break;
+				default:
+					v=static_cast<int32_t>(static_cast<uint32_t>(v)+std::uniform_int_distribution<int32_t>{-3000, 3000}(rng));
+			}
+		}
+		node.second=pick(rng)<2?std::uniform_int_distribution<uint32_t>{}(rng):(prev.second^(pick(rng)<<4));
+		return node;
+	}
+	gapr::delta_add_edge_ test_add_edge(std::mt19937& rng, std::size_t n) {
+		gapr::delta_add_edge_ delta{};
+		std::uniform_int_distribution<uint32_t> id{};
+		delta.left={id(rng), id(rng)&3};
+		delta.right={id(rng), 0};
+		gapr::node_attr::data_type node{};
+		for(std::size_t i=0; i<n; i++)
+			delta.nodes.push_back(node=test_node(rng, node));
+		return delta;
+	}
+}
+
+namespace gapr_test { int chk_serializer_fast() {
+	std::mt19937 rng{4231};
+	std::uniform_int_distribution<std::size_t> nnodes{0, 3000};
+	for(unsigned int k=0; k<400; k++) {
+		// the bulk path is taken only with large buffers, output must
+		// not depend on where the buffers are cut
+		auto maxn=k%4==0?std::size_t{7}:(std::size_t{1}<<(k%16+1));
+		{
+			auto delta=test_add_edge(rng, nnodes(rng));
+			auto ref=test_save(delta, rng, std::size_t{1}<<20);
+			if(test_save(delta, rng, maxn)!=ref)
+				return gapr::print("add_edge save mismatch: ", k), -1;
+			gapr::delta_add_edge_ delta2;
+			if(!test_load(delta2, ref, rng, maxn) || delta2.left!=delta.left
+					|| delta2.right!=delta.right || delta2.nodes!=delta.nodes)
+				return gapr::print("add_edge load mismatch: ", k), -1;
+		}
+		{
+			gapr::delta_add_patch_ delta;
+			std::uniform_int_distribution<uint32_t> id{};
+			gapr::node_attr::data_type node{};
+			for(std::size_t i=nnodes(rng); i-->0;) {
+				delta.nodes.emplace_back(node=test_node(rng, node), id(rng)>>(id(rng)%32));
+				delta.links.emplace_back(id(rng), gapr::link_id::data_type{id(rng), id(rng)});
+				if(i%5==0)
+					delta.props.emplace_back(id(rng), std::string(id(rng)%300, 'a'+i%26));
+			}
+			auto ref=test_save(delta, rng, std::size_t{1}<<20);
+			if(test_save(delta, rng, maxn)!=ref)
+				return gapr::print("add_patch save mismatch: ", k), -1;
+			gapr::delta_add_patch_ delta2;
+			if(!test_load(delta2, ref, rng, maxn) || delta2.nodes!=delta.nodes
+					|| delta2.links!=delta.links || delta2.props!=delta.props)
+				return gapr::print("add_patch load mismatch: ", k), -1;
+		}
+	}
+	return 0;
+} }
+
+namespace gapr_test { int bench_serializer() {
+	std::mt19937 rng{4231};
+	gapr::delta_add_edge_ delta{};
+	{
+		std::uniform_int_distribution<int32_t> step{-2000, 2000};
+		gapr::node_attr::data_type node{{1<<20, 1<<20, 1<<20}, 0};
+		for(std::size_t i=0; i<200'000; i++) {
+			for(auto& v: node.first)
+				v+=step(rng);
+			delta.nodes.push_back(node);
+		}
+	}
+	std::vector<unsigned char> buf(delta.nodes.size()*24);
+	auto mbps=[&delta](auto t0, auto t1, unsigned int rep) {
+		std::chrono::duration<double> d=t1-t0;
+		return rep*delta.nodes.size()*sizeof(delta.nodes[0])/d.count()/1024/1024;
+	};
+	// 16-byte slices never cover a run, as without the bulk path
+	for(std::size_t slice: {std::size_t{16}, std::size_t{4096}, buf.size()}) {
+		constexpr unsigned int rep=20;
+		std::size_t size;
+		auto t0=std::chrono::steady_clock::now();
+		for(unsigned int k=0; k<rep; k++) {
+			gapr::Serializer<gapr::delta_add_edge_> ser{};
+			size=0;
+			do {
+				size+=ser.save(delta, &buf[size], std::min(slice, buf.size()-size));
+			} while(ser);
+		}
+		auto t1=std::chrono::steady_clock::now();
+		gapr::delta_add_edge_ delta2;
+		for(unsigned int k=0; k<rep; k++) {
+			gapr::Deserializer<gapr::delta_add_edge_> deser{};
+			std::size_t i=0;
+			do {
+				i+=deser.load(delta2, &buf[i], std::min(slice, size-i));
+			} while(deser && i<size);
+		}
+		auto t2=std::chrono::steady_clock::now();
+		if(delta2.nodes!=delta.nodes)
+			return -1;
+		gapr::print("add_edge ", delta.nodes.size(), " nodes, ", slice, "B slices: save ", mbps(t0, t1, rep), "MiB/s, load ", mbps(t1, t2, rep), "MiB/s, ", size, "B");
+	}
+	return 0;
+} }
@@ -8,6 +8,9 @@
 #include <sstream>
 #include <cassert>
 #include <charconv>
+#include <vector>
+#include <deque>
+#include <future>
 
 #include "config.hh"
 
@@ -24,10 +27,67 @@ static inline std::from_chars_result from_chars(const char* first, const char* l
 	value=v;
 	return {end, std::errc{}};
 }
+/*! locale free, exact when the decimal fits in a double (no rounding
+ * in m*10^e), otherwise left to from_chars */
+static std::from_chars_result parse_double(const char* first, const char* last, double& value) {
+	static constexpr double pow10[]{1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+		1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+		1e20, 1e21, 1e22};
+	auto p=first;
+	auto digit=[&p,last]() { return p<last && static_cast<unsigned char>(*p-'0')<10; };
+	bool neg=false;
+	if(p<last && *p=='-') {
+		neg=true;
+		++p;
+	}
+	uint64_t m=0;
+	int nd=0, e=0;
+	bool any=false;
+	for(; digit(); ++p, any=true) {
+		m=m*10+(*p-'0');
+		if(m)
+			++nd;
+	}
+	if(p<last && *p=='.') {
+		++p;
+		for(; digit(); ++p, any=true) {
+			m=m*10+(*p-'0');
+			if(m)
+				++nd;
+			--e;
+		}
+	}
+	if(any && p<last && (*p=='e' || *p=='E')) {
+		auto q=p+1;
+		bool eneg=false;
+		if(q<last && (*q=='-' || *q=='+'))
+			eneg=*q++=='-';
+		if(q<last && static_cast<unsigned char>(*q-'0')<10) {
+			int x=0;
+			for(; q<last && static_cast<unsigned char>(*q-'0')<10; ++q)
+				if(x<100000)
+					x=x*10+(*q-'0');
+			e+=eneg?-x:x;
+			p=q;
+		}
+	}
+	if(!any || nd>19 || m>(uint64_t{1}<<53) || e<-22 || e>22) {
+		using namespace std;
+		return from_chars(first, last, value);
+	}
+	double v=m;
+	v=e<0?v/pow10[-e]:v*pow10[e];
+	value=neg?-v:v;
+	return {p, std::errc{}};
+}
 template<typename T>
 static inline std::from_chars_result parse_field(const char* begin, const char* end, T& val) {
 	using namespace std;
-	auto res=from_chars(begin, end, val);
+	from_chars_result res;
+	if constexpr(std::is_floating_point_v<T>)
+		res=parse_double(begin, end, val);
+	else
+		res=from_chars(begin, end, val);
 	if(res.ec!=std::errc{})
 		return res;
 	if(res.ptr>=end || !std::isspace(*res.ptr))
@@ -65,6 +125,8 @@ static std::from_chars_result parse_swc_node(std::string_view l, gapr::swc_node&
 }
 
 bool gapr::swc_input::read() {
+	if(_blks)
+		return read_blocks();
 	auto getline=[this]() ->bool {
 		switch(_buf_st) {
 			case _buf_avail:
@@ -230,6 +292,283 @@ bool gapr::swc_input::read() {
 	return false;
 }
 
+struct gapr::swc_input::block {
+	/*! one per line, checks that need the lines before are left to
+	 * read_blocks() */
+	struct line {
+		tags tag;
+		std::errc err;
+		/*! starts with ext_tag_prev_eq, merged into the node before */
+		bool prev_eq;
+		std::size_t beg, len;
+		/*! error position, position of parent/loop id, or _annot_skip */
+		std::size_t skip;
+		std::size_t keyl, skip2;
+		swc_node node;
+		gapr::misc_attr attr;
+	};
+	std::string text;
+	std::vector<line> lines;
+
+	static std::pair<std::size_t, std::errc> parse_line(std::string_view l, line& r);
+	void parse() {
+		lines.reserve(text.size()/40);
+		std::size_t i=0;
+		while(i<text.size()) {
+			auto j=text.find('\n', i);
+			assert(j!=std::string::npos);
+			auto e=j;
+			if(e>i && text[e-1]=='\r')
+				--e;
+			auto& r=lines.emplace_back();
+			r.beg=i;
+			r.len=e-i;
+			auto [pos, err]=parse_line({&text[i], e-i}, r);
+			if(err!=std::errc{}) {
+				r.tag=_tag_empty;
+				r.err=err;
+				r.skip=pos;
+			}
+			i=j+1;
+		}
+	}
+};
+
+std::pair<std::size_t, std::errc> gapr::swc_input::block::parse_line(std::string_view l, line& r) {
+	if(l.empty() || l[0]!='#') {
+		if(l.empty()) {
+			r.tag=tags::comment;
+			return {0, std::errc{}};
+		}
+		std::size_t p_pos;
+		auto [ptr, ec]=parse_swc_node(l, r.node, p_pos);
+		if(ec!=std::errc{})
+			return {ptr-l.data(), ec};
+		r.skip=p_pos;
+		r.tag=tags::node;
+		return {0, std::errc{}};
+	}
+	if(l.size()<ext_tag.size() || l.compare(1, ext_tag.size()-1, ext_tag.substr(1))!=0) {
+		r.tag=tags::comment;
+		return {0, std::errc{}};
+	}
+	r.prev_eq=l.compare(0, ext_tag_prev_eq.size(), ext_tag_prev_eq)==0;
+	int64_t id;
+	auto res=gapr::make_parser(id).from_dec(l.data()+ext_tag.size(), l.size()-ext_tag.size());
+	if(!res.second)
+		return {ext_tag.size()+1, std::errc::invalid_argument};
+	auto skip=res.first+ext_tag.size();
+	if(skip>=l.size())
+		return {skip, std::errc::invalid_argument};
+	r.node.id=id;
+	switch(l[skip]) {
+		case '=':
+			++skip;
+			if(skip+8!=l.size())
+				return {skip, std::errc::invalid_argument};
+			if(!gapr::make_parser(r.attr.data).from_hex<8>(&l[skip]))
+				return {skip, std::errc::invalid_argument};
+			r.tag=tags::misc_attr;
+			return {0, std::errc{}};
+		case '@':
+			{
+				++skip;
+				unsigned int skipdot=0;
+				if(skip<l.size() && l[skip]=='.')
+					++skipdot;
+				res=gapr::parse_name(l.data()+skip+skipdot, l.size()-skip-skipdot);
+				if(!res.second)
+					return {skip, std::errc::invalid_argument};
+				auto j=skip+skipdot+res.first;
+				if(j<l.size()) {
+					if(l[j]!='=')
+						return {j, std::errc::invalid_argument};
+					++j;
+				}
+				r.skip=skip;
+				r.keyl=res.first+skipdot;
+				r.skip2=j;
+				r.tag=tags::annot;
+				return {0, std::errc{}};
+			}
+		case '/':
+			{
+				++skip;
+				int64_t id2;
+				res=gapr::make_parser(id2).from_dec(l.data()+skip, l.size()-skip);
+				if(!res.second)
+					return {skip, std::errc::invalid_argument};
+				if(id2==-1)
+					return {skip, std::errc::result_out_of_range};
+				if(res.first+skip!=l.size())
+					return {res.first+skip, std::errc::invalid_argument};
+				r.node.par_id=id2;
+				r.skip=skip;
+				r.tag=tags::loop;
+				return {0, std::errc{}};
+			}
+	}
+	return {skip, std::errc::invalid_argument};
+}
+
+struct gapr::swc_input::blocks {
+	unsigned int jobs;
+	std::size_t block_size;
+	std::string rest{};
+	bool done{false};
+	bool bad{false};
+	bool failed{false};
+	std::deque<std::future<std::unique_ptr<block>>> todo{};
+	std::unique_ptr<block> cur{};
+	std::size_t idx{0};
+	std::size_t line0{0};
+
+	blocks(unsigned int jobs, std::size_t block_size):
+		jobs{jobs}, block_size{block_size} { }
+
+	/*! reads whole lines (in the calling thread, the stream may be a
+	 * decompressor) and leaves the parsing to a worker */
+	bool launch(std::istream& base) {
+		if(done)
+			return false;
+		auto blk=std::make_unique<block>();
+		auto& text=blk->text;
+		text.swap(rest);
+		do {
+			auto n=text.size();
+			text.resize(n+block_size);
+			base.read(&text[n], block_size);
+			text.resize(n+base.gcount());
+			if(!base) {
+				done=true;
+				bad=!base.eof();
+				if(!text.empty() && text.back()!='\n')
+					text.push_back('\n');
+				break;
+			}
+			auto p=text.rfind('\n');
+			if(p!=std::string::npos) {
+				rest.assign(text, p+1);
+				text.resize(p+1);
+				break;
+			}
+		} while(true);
+		if(text.empty())
+			return false;
+		todo.push_back(std::async(std::launch::async, [blk=std::move(blk)]() mutable {
+			blk->parse();
+			return std::move(blk);
+		}));
+		return true;
+	}
+	const block::line* peek(std::istream& base) {
+		while(!cur || idx>=cur->lines.size()) {
+			if(cur) {
+				line0+=cur->lines.size();
+				cur.reset();
+				idx=0;
+			}
+			while(todo.size()<=jobs && launch(base)) { }
+			if(todo.empty())
+				return nullptr;
+			cur=todo.front().get();
+			todo.pop_front();
+		}
+		return &cur->lines[idx];
+	}
+	std::string_view text(const block::line& r) const noexcept {
+		return {&cur->text[r.beg], r.len};
+	}
+};
+
+gapr::swc_input::swc_input(std::istream& base):
+	_base{base} { }
+gapr::swc_input::swc_input(std::istream& base, unsigned int jobs, std::size_t block_size):
+	_base{base}, _blks{std::make_unique<blocks>(jobs>0?jobs:1, block_size)} { }
+gapr::swc_input::~swc_input() { }
+
+bool gapr::swc_input::read_blocks() {
+	auto& b=*_blks;
+	_tag=_tag_empty;
+	if(b.failed)
+		return false;
+	auto fail=[this,&b](std::size_t pos, std::errc err) {
+		gapr::print("err read: ", _line_no, ':', pos, " ", (int)err);
+		b.failed=true;
+		return false;
+	};
+	auto check_id=[this](int64_t& id) {
+		if(id==-1) {
+			if(_prev_id==-1)
+				return false;
+			id=_prev_id;
+			return true;
+		}
+		return _ids.find(id)!=_ids.end();
+	};
+
+	auto r=b.peek(_base);
+	if(!r) {
+		_buf_st=b.bad?_buf_bad:_buf_eof;
+		return false;
+	}
+	++b.idx;
+	_line_no=b.line0+b.idx;
+	switch(r->tag) {
+		case tags::comment:
+			_buf=b.text(*r);
+			_buf.push_back('\n');
+			break;
+		case tags::node:
+			if(r->node.id==-1)
+				return fail(0, std::errc::result_out_of_range);
+			if(r->node.par_id!=-1 && _ids.find(r->node.par_id)==_ids.end())
+				return fail(r->skip, std::errc::result_out_of_range);
+			if(!_ids.emplace(r->node.id).second)
+				return fail(0, std::errc::result_out_of_range);
+			_cur_node=r->node;
+			_cur_attr={};
+			// may switch to the next block, r no longer valid
+			if(auto r2=b.peek(_base); r2 && r2->prev_eq) {
+				++b.idx;
+				++_line_no;
+				if(r2->tag!=tags::misc_attr)
+					return fail(r2->skip, r2->err);
+				_cur_attr=r2->attr;
+			}
+			_prev_id=_cur_node.id;
+			_tag=tags::node;
+			return true;
+		case tags::misc_attr:
+			_cur_node.id=r->node.id;
+			if(!check_id(_cur_node.id))
+				return fail(ext_tag.size()+1, std::errc::result_out_of_range);
+			_cur_attr=r->attr;
+			break;
+		case tags::annot:
+			_cur_node.id=r->node.id;
+			if(!check_id(_cur_node.id))
+				return fail(ext_tag.size()+1, std::errc::result_out_of_range);
+			_buf=b.text(*r);
+			_annot_skip=r->skip;
+			_annot_keyl=r->keyl;
+			_annot_skip2=r->skip2;
+			break;
+		case tags::loop:
+			_cur_node.id=r->node.id;
+			if(!check_id(_cur_node.id))
+				return fail(ext_tag.size()+1, std::errc::result_out_of_range);
+			if(_ids.find(r->node.par_id)==_ids.end())
+				return fail(r->skip, std::errc::result_out_of_range);
+			_cur_node.par_id=r->node.par_id;
+			break;
+		default:
+			return fail(r->skip, r->err);
+	}
+	_tag=r->tag;
+	return true;
+}
+
 #if 0
 unittest {
 	std::ofstream os{"/tmp/asdf.swc"};
@@ -848,3 +1187,185 @@ namespace gapr_test { int chk_serializer() {
 #endif
 	return r;
 } }
+
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+/*! everything the reader yields, in order */
+static std::string test_swc_events(std::string_view corpus, unsigned int jobs, std::size_t block_size) {
+	std::istringstream iss{std::string{corpus}};
+	std::optional<gapr::swc_input> swc;
+	if(jobs)
+		swc.emplace(iss, jobs, block_size);
+	else
+		swc.emplace(iss);
+	std::ostringstream oss;
+	oss.precision(17);
+	while(swc->read()) {
+		using tags=gapr::swc_input::tags;
+		oss<<static_cast<int>(swc->tag())<<' ';
+		switch(swc->tag()) {
+			case tags::comment:
+				oss<<swc->comment();
+				break;
+			case tags::node:
+				{
+					auto& n=swc->node();
+					oss<<n.id<<' '<<n.type<<' '<<n.pos[0]<<' '<<n.pos[1]<<' '<<n.pos[2]<<' '<<n.radius<<' '<<n.par_id<<' '<<swc->misc_attr().data;
+				}
+				break;
+			case tags::misc_attr:
+				oss<<swc->id()<<' '<<swc->misc_attr().data;
+				break;
+			case tags::annot:
+				oss<<swc->id()<<' '<<swc->annot()<<'|'<<swc->annot_key()<<'|'<<swc->annot_val();
+				break;
+			case tags::loop:
+				oss<<swc->id()<<' '<<swc->loop();
+				break;
+		}
+		oss<<'\n';
+	}
+	oss<<"eof "<<swc->eof()<<'\n';
+	return oss.str();
+}
+
+static std::string test_swc_corpus(std::mt19937& rng, std::size_t n) {
+	auto rnd=[&rng](int a, int b) { return std::uniform_int_distribution<int>{a, b}(rng); };
+	auto num=[&rng,&rnd]() {
+		char buf[64];
+		auto v=std::uniform_real_distribution<double>{-20000, 20000}(rng);
+		switch(rnd(0, 5)) {
+			case 0: std::snprintf(buf, sizeof buf, "%d", static_cast<int>(v)); break;
+			case 1: std::snprintf(buf, sizeof buf, "%.3f", v); break;
+			case 2: std::snprintf(buf, sizeof buf, "%g", v); break;
+			case 3: std::snprintf(buf, sizeof buf, "%.17g", v); break;
+			case 4: std::snprintf(buf, sizeof buf, "%.2e", v/1e5); break;
+			default: std::snprintf(buf, sizeof buf, "%.25f", v); break;
+		}
+		return std::string{buf};
+	};
+	std::string s{"# comment\n#\n\n"};
+	std::vector<int64_t> ids;
+	for(std::size_t i=0; i<n; i++) {
+		auto eol=rnd(0, 9)==0?"\r\n":"\n";
+		switch(rnd(0, 19)) {
+			case 0:
+				if(rnd(0, 1)) {
+					s+="# some comment ";
+					if(rnd(0, 50)==0)
+						s.append(rnd(100, 3000), 'x');
+				}
+				break;
+			case 1:
+				if(ids.empty())
+					continue;
+				s+=ext_tag;
+				s+=rnd(0, 1)?std::to_string(ids[rnd(0, ids.size()-1)]):"-1";
+				s+=rnd(0, 1)?"@root=neuron 1":(rnd(0, 1)?"@.traced":"@state=");
+				break;
+			case 2:
+				if(ids.empty())
+					continue;
+				s+=ext_tag;
+				s+=std::to_string(ids[rnd(0, ids.size()-1)]);
+				s+="=0000A0F1";
+				break;
+			case 3:
+				if(ids.empty())
+					continue;
+				s+=ext_tag;
+				s+=rnd(0, 1)?std::to_string(ids[rnd(0, ids.size()-1)]):"-1";
+				s+='/';
+				s+=std::to_string(ids[rnd(0, ids.size()-1)]);
+				break;
+			default:
+				{
+					int64_t id=ids.size()*3+rnd(1, 2);
+					auto par=(ids.empty() || rnd(0, 30)==0)?-1:ids[rnd(0, 3)?ids.size()-1:rnd(0, ids.size()-1)];
+					s+=std::to_string(id)+' '+std::to_string(rnd(0, 7));
+					for(unsigned int k=0; k<4; k++)
+						s+=' '+num();
+					s+=' '+std::to_string(par);
+					ids.push_back(id);
+					if(rnd(0, 3)==0) {
+						s+=eol;
+						s+=ext_tag_prev_eq;
+						s+=rnd(0, 1)?"1234ABCD":"00000000";
+					}
+				}
+		}
+		s+=eol;
+	}
+	if(rnd(0, 1))
+		s.pop_back();
+	return s;
+}
+
+namespace gapr_test { int chk_swc_input() {
+	int r=0;
+	std::mt19937 rng{20240615};
+	for(unsigned int i=0; i<20000; i++) {
+		char buf[64];
+		auto v=std::uniform_real_distribution<double>{-1e6, 1e6}(rng);
+		auto d=std::uniform_int_distribution<int>{0, 18}(rng);
+		std::snprintf(buf, sizeof buf, i%3==0?"%.*e":"%.*f", d, i%7==0?v*1e-12:v);
+		double a, b;
+		auto res=parse_double(buf, buf+std::strlen(buf), a);
+		char* end;
+		b=std::strtod(buf, &end);
+		if(res.ec!=std::errc{} || res.ptr!=end || std::memcmp(&a, &b, sizeof a)!=0) {
+			gapr::print("parse_double: ", buf);
+			r=1;
+		}
+	}
+
+	for(unsigned int t=0; t<12; t++) {
+		auto corpus=test_swc_corpus(rng, t<4?30:20000);
+		if(t>=8) {
+			// break a random line
+			auto p=corpus.find('\n', std::uniform_int_distribution<std::size_t>{0, corpus.size()-1}(rng));
+			if(p!=std::string::npos)
+				corpus.insert(p, t%2?" 1 x":"0");
+		}
+		auto ref=test_swc_events(corpus, 0, 0);
+		if(t<8 && ref.compare(ref.size()-6, 6, "eof 1\n")!=0) {
+			gapr::print("swc_input: ", t, " not read");
+			r=1;
+		}
+		for(auto [jobs, blk]: {std::pair{1u, std::size_t{61}}, {4u, 997}, {3u, 64*1024}, {8u, 4*1024*1024}}) {
+			if(test_swc_events(corpus, jobs, blk)!=ref) {
+				gapr::print("swc_input: ", t, ' ', jobs, ' ', blk);
+				r=1;
+			}
+		}
+	}
+	return r;
+} }
+
+namespace gapr_test { int bench_swc_input() {
+	std::mt19937 rng{1234};
+	auto corpus=test_swc_corpus(rng, 3000000);
+	auto time=[&corpus](unsigned int jobs) {
+		std::istringstream iss{corpus};
+		auto t0=std::chrono::steady_clock::now();
+		std::optional<gapr::swc_input> swc;
+		if(jobs)
+			swc.emplace(iss, jobs);
+		else
+			swc.emplace(iss);
+		std::size_t n=0;
+		while(swc->read())
+			++n;
+		std::chrono::duration<double> dt=std::chrono::steady_clock::now()-t0;
+		gapr::print("jobs ", jobs, ": ", n, " lines, ", corpus.size()/dt.count()/1024/1024, " MiB/s");
+		return swc->eof()?0:1;
+	};
+	int r=0;
+	for(auto jobs: {0u, 1u, 2u, std::thread::hardware_concurrency()})
+		r|=time(jobs);
+	return r;
+} }
@@ -67,7 +67,8 @@ gapr::future<tapi::handshake_result> tapi::handshake(client_end& cli) {
 	});
 	return fut;
 }
-gapr::future<tapi::login_result> tapi::login(client_end& cli, const std::string& usr, const std::string& pw) {
+gapr::future<tapi::login_result> tapi::login(client_end& cli0, const std::string& usr, const std::string& pw) {
+	auto cli=cli0.fork();
 	gapr::promise<login_result> prom{};
 	auto fut=prom.get_future();
 	client_end::msg_hdr hdr{"LOGIN", usr, pw};
@@ -129,7 +130,8 @@ gapr::future<tapi::login_result> tapi::login(client_end& cli, const std::string&
 	return fut;
 }
 
-gapr::future<tapi::select_result> tapi::select(client_end& cli, const std::string& grp) {
+gapr::future<tapi::select_result> tapi::select(client_end& cli0, const std::string& grp) {
+	auto cli=cli0.fork();
 	promise<select_result> prom{};
 	auto fut=prom.get_future();
 	client_end::msg_hdr hdr{"SELECT", grp};
@@ -233,7 +235,8 @@ static void receive_file(gapr::promise<gapr::mem_file>&& prom, gapr::client_end&
 	return receive_file_func(std::move(prom), std::move(msg), std::move(file));
 }
 
-gapr::future<tapi::get_catalog_result> tapi::get_catalog(client_end& cli) {
+gapr::future<tapi::get_catalog_result> tapi::get_catalog(client_end& cli0) {
+	auto cli=cli0.fork();
 	gapr::promise<get_catalog_result> prom{};
 	auto fut=prom.get_future();
 	client_end::msg_hdr hdr{"GET.CATALOG"};
@@ -286,7 +289,8 @@ gapr::future<tapi::get_catalog_result> tapi::get_catalog(client_end& cli) {
 	return fut;
 }
 
-gapr::future<tapi::get_state_result> tapi::get_state(client_end& cli) {
+gapr::future<tapi::get_state_result> tapi::get_state(client_end& cli0) {
+	auto cli=cli0.fork();
 	gapr::promise<get_state_result> prom{};
 	auto fut=prom.get_future();
 	client_end::msg_hdr hdr{"GET.STATE"};
@@ -337,7 +341,8 @@ gapr::future<tapi::get_state_result> tapi::get_state(client_end& cli) {
 	return fut;
 }
 
-gapr::future<tapi::get_commit_result> tapi::get_commit(client_end& cli, uint64_t id) {
+gapr::future<tapi::get_commit_result> tapi::get_commit(client_end& cli0, uint64_t id) {
+	auto cli=cli0.fork();
 // encrypt(aes-cbc-128)
 	gapr::promise<get_commit_result> prom{};
 	auto fut=prom.get_future();
@@ -389,7 +394,8 @@ gapr::future<tapi::get_commit_result> tapi::get_commit(client_end& cli, uint64_t
 	return fut;
 }
 
-gapr::future<tapi::get_commits_result> tapi::get_commits(client_end& cli, gapr::mem_file&& hist, uint64_t upto) {
+gapr::future<tapi::get_commits_result> tapi::get_commits(client_end& cli0, gapr::mem_file&& hist, uint64_t upto) {
+	auto cli=cli0.fork();
 	gapr::promise<get_commits_result> prom{};
 	auto fut=prom.get_future();
 	auto sz=hist.size();
@@ -442,7 +448,8 @@ gapr::future<tapi::get_commits_result> tapi::get_commits(client_end& cli, gapr::
 	return fut;
 }
 
-gapr::future<tapi::commit_result> tapi::commit(client_end& cli, gapr::delta_type type, gapr::mem_file&& payload, uint64_t base, uint64_t tip) {
+gapr::future<tapi::commit_result> tapi::commit(client_end& cli0, gapr::delta_type type, gapr::mem_file&& payload, uint64_t base, uint64_t tip) {
+	auto cli=cli0.fork();
 	auto t0=std::chrono::steady_clock::now();
 	gapr::promise<commit_result> prom{};
 	auto fut=prom.get_future();
@@ -529,7 +536,8 @@ gapr::future<tapi::commit_result> tapi::commit(client_end& cli, gapr::delta_type
 	return fut;
 }
 
-gapr::future<tapi::get_model_result> tapi::get_model(client_end& cli) {
+gapr::future<tapi::get_model_result> tapi::get_model(client_end& cli0) {
+	auto cli=cli0.fork();
 	gapr::promise<get_model_result> prom{};
 	auto fut=prom.get_future();
 	client_end::msg_hdr hdr{"GET.MODEL"};
@@ -580,7 +588,8 @@ gapr::future<tapi::get_model_result> tapi::get_model(client_end& cli) {
 	return fut;
 }
 
-gapr::future<int> tapi::upload_fragment(client_end& cli, gapr::mem_file&& payload, uint64_t base, uint64_t tip) {
+gapr::future<int> tapi::upload_fragment(client_end& cli0, gapr::mem_file&& payload, uint64_t base, uint64_t tip) {
+	auto cli=cli0.fork();
 	auto t0=std::chrono::steady_clock::now();
 	gapr::promise<int> prom{};
 	auto fut=prom.get_future();
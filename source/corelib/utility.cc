@@ -10,6 +10,8 @@
 #include <unordered_map>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <chrono>
 #include <cinttypes>
@@ -742,6 +744,62 @@ std::string gapr::to_url_if_path(std::string_view path) {
 	std::setlocale(LC_ALL, "");
 }
 
+void gapr::parallel_for(std::size_t n, unsigned int nworkers, const std::function<void(std::function<void()>&&)>& post, const std::function<void(std::size_t, unsigned int)>& fn) {
+	if(n<2 || nworkers<2 || !post) {
+		for(std::size_t i=0; i<n; i++)
+			fn(i, 0);
+		return;
+	}
+	struct State {
+		std::atomic<std::size_t> next{0};
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::size_t done{0};
+		std::exception_ptr err;
+	};
+	auto st=std::make_shared<State>();
+	// late helpers only touch st, so they may outlive this call
+	auto work=[st,n,&fn](unsigned int k) {
+		std::size_t i;
+		while((i=st->next++)<n) {
+			std::exception_ptr err;
+			try {
+				fn(i, k);
+			} catch(...) {
+				err=std::current_exception();
+			}
+			{
+				std::lock_guard lck{st->mtx};
+				if(err && !st->err)
+					st->err=err;
+				++st->done;
+			}
+			st->cv.notify_all();
+		}
+	};
+	auto nhelpers=std::min<std::size_t>(nworkers, n)-1;
+	for(unsigned int k=1; k<=nhelpers; k++)
+		post([work,k]() { work(k); });
+	work(0);
+	std::unique_lock lck{st->mtx};
+	st->cv.wait(lck, [&st,n]() { return st->done>=n; });
+	if(st->err)
+		std::rethrow_exception(st->err);
+}
+
+std::pair<std::size_t, std::size_t> gapr::mem_usage() {
+	std::pair<std::size_t, std::size_t> r{0, 0};
+	std::ifstream fs{"/proc/self/status"};
+	std::string line;
+	while(std::getline(fs, line)) {
+		if(line.compare(0, 6, "VmRSS:")==0)
+			r.first=std::strtoull(&line[6], nullptr, 10);
+		else if(line.compare(0, 6, "VmHWM:")==0)
+			r.second=std::strtoull(&line[6], nullptr, 10);
+	}
+	return r;
+}
+
 static void fix_flatpak_sigint() {
 	gapr::file_stream tty{"/dev/tty", "rb"};
 	if(!tty)
@@ -396,3 +396,224 @@ static void sel_proofread_nodes(gapr::edge_model::view model, const gapr::fix::P
 		std::filesystem::rename(tmppath, cachepath);
 }
 
+
+/*! local state cache: a base state dump (written by save_cache_file)
+ * plus an append-only journal of the commits loaded since, in the order
+ * they were loaded into the model.
+ * the journal starts with a commit_history holding the base count,
+ * followed by commit_info+delta records, as in GET_COMMITS.
+ */
+class state_journal {
+	public:
+		explicit state_journal() noexcept { }
+		state_journal(const state_journal&) =delete;
+		state_journal& operator=(const state_journal&) =delete;
+
+		void bind(const std::filesystem::path& basepath) {
+			std::lock_guard lck{_mtx};
+			if(basepath==_basepath)
+				return;
+			_ofs.close();
+			_basepath=basepath;
+			_path=basepath;
+			_path.replace_extension(".journal");
+			_active=false;
+			_size=0;
+		}
+
+		/*! after loading a base of ncommits, replay the journal into model.
+		 * hist is updated, false if a record fails to load.
+		 */
+		bool replay(gapr::edge_model& model, gapr::commit_history& hist) {
+			std::lock_guard lck{_mtx};
+			std::error_code ec;
+			_base_size=std::filesystem::file_size(_basepath, ec);
+			std::filebuf fb;
+			if(!fb.open(_path, std::ios::in|std::ios::binary))
+				return reset_impl(hist.body_count());
+			gapr::commit_history hdr;
+			if(!hdr.load(fb) || hdr.body_count()!=hist.body_count() || !hdr.tail().empty()) {
+				gapr::print("state_cache stale journal");
+				fb.close();
+				return reset_impl(hist.body_count());
+			}
+			auto good=fb.pubseekoff(0, std::ios::cur, std::ios::in);
+			std::size_t n=0;
+			auto fail=[this,&fb]() {
+				fb.close();
+				std::error_code ec;
+				std::filesystem::remove(_path, ec);
+				return false;
+			};
+			{
+				gapr::edge_model::loader loader{model};
+				while(true) {
+					gapr::commit_info info;
+					if(!info.load(fb))
+						break;
+					if(info.id<hist.body_count())
+						return fail();
+					if(info.id>hist.body_count() && info.id<=hist.tail_tip())
+						return fail();
+					bool got{false};
+					auto r=gapr::delta_variant::visit<bool>(gapr::delta_type{info.type}, [&loader,&info,&fb,&got](auto typ) {
+						gapr::delta<typ> delta;
+						if(!gapr::load(delta, fb))
+							return true;
+						got=true;
+						return loader.load(gapr::node_id{info.nid0}, std::move(delta));
+					});
+					if(!got)
+						break;
+					if(!r)
+						return fail();
+					if(info.id==hist.body_count())
+						hist.body_count(info.id+1);
+					else
+						hist.add_tail(info.id);
+					good=fb.pubseekoff(0, std::ios::cur, std::ios::in);
+					++n;
+				}
+			}
+			fb.close();
+			// drop a partially written record
+			std::filesystem::resize_file(_path, good, ec);
+			if(ec)
+				return reset_impl(hist.body_count());
+			gapr::print("state_cache journal replayed: ", n, " commits, ", static_cast<std::size_t>(good), " bytes");
+			_ofs.open(_path, std::ios::binary|std::ios::app);
+			_active=static_cast<bool>(_ofs);
+			_size=good;
+			return true;
+		}
+		/*! a new base of ncommits was saved */
+		void reset(uint64_t ncommits) {
+			std::lock_guard lck{_mtx};
+			std::error_code ec;
+			_base_size=std::filesystem::file_size(_basepath, ec);
+			reset_impl(ncommits);
+		}
+
+		/*! raw record, the bytes in [start, cur) of sb */
+		void append(std::streambuf& sb, std::streamoff start) {
+			auto end=sb.pubseekoff(0, std::ios::cur, std::ios::in);
+			std::lock_guard lck{_mtx};
+			_size+=end-start;
+			if(!_active)
+				return;
+			std::vector<char> buf(end-start);
+			sb.pubseekpos(start, std::ios::in);
+			sb.sgetn(buf.data(), buf.size());
+			_ofs.write(buf.data(), buf.size());
+			commit_impl();
+		}
+		void append(const gapr::commit_info& info, const gapr::mem_file& payload) {
+			std::lock_guard lck{_mtx};
+			_size+=payload.size();
+			if(!_active)
+				return;
+			if(!info.save(*_ofs.rdbuf()))
+				_ofs.setstate(std::ios::failbit);
+			for(std::size_t off=0; off<payload.size(); ) {
+				auto buf=payload.map(off);
+				_ofs.write(buf.data(), buf.size());
+				off+=buf.size();
+			}
+			commit_impl();
+		}
+
+		/*! the size that triggers compaction */
+		bool overflow() const {
+			std::lock_guard lck{_mtx};
+			if(!_active)
+				return _size>16*1024*1024;
+			return _size>std::max(std::size_t{64*1024*1024}, _base_size);
+		}
+		std::size_t size() const {
+			std::lock_guard lck{_mtx};
+			return _size;
+		}
+		/*! replace base with dump(), if nothing was appended since size0.
+		 * hold a model reader, so that no commits are applied meanwhile.
+		 * dump and write without the lock, appends go on meanwhile.
+		 */
+		template<typename Dump>
+		bool compact(uint64_t ncommits, std::size_t size0, Dump&& dump) {
+			std::filesystem::path basepath;
+			{
+				std::lock_guard lck{_mtx};
+				if(_size!=size0)
+					return false;
+				basepath=_basepath;
+			}
+			auto tmppath=basepath;
+			tmppath.replace_extension(".compact");
+			{
+				gapr::mem_file file=dump();
+				auto buf=gapr::make_streambuf(std::move(file));
+				std::ofstream ofs{tmppath, std::ios::binary};
+				ofs<<buf.get();
+				ofs.close();
+				if(!ofs) {
+					std::error_code ec;
+					std::filesystem::remove(tmppath, ec);
+					return false;
+				}
+			}
+			std::error_code ec;
+			auto base_size=std::filesystem::file_size(tmppath, ec);
+			std::lock_guard lck{_mtx};
+			if(ec || _size!=size0 || _basepath!=basepath) {
+				std::filesystem::remove(tmppath, ec);
+				return false;
+			}
+			std::filesystem::rename(tmppath, basepath, ec);
+			if(ec)
+				return false;
+			_base_size=base_size;
+			reset_impl(ncommits);
+			return true;
+		}
+
+	private:
+		std::filesystem::path _basepath;
+		std::filesystem::path _path;
+		std::ofstream _ofs;
+		std::size_t _size{0};
+		std::size_t _base_size{0};
+		bool _active{false};
+		mutable std::mutex _mtx;
+
+		bool reset_impl(uint64_t ncommits) {
+			_ofs.close();
+			_size=0;
+			_active=false;
+			if(ncommits==0) {
+				std::error_code ec;
+				std::filesystem::remove(_path, ec);
+				return true;
+			}
+			gapr::commit_history hdr;
+			hdr.body_count(ncommits);
+			_ofs.open(_path, std::ios::binary|std::ios::trunc);
+			if(!hdr.save(*_ofs.rdbuf()))
+				_ofs.setstate(std::ios::failbit);
+			_ofs.flush();
+			_active=static_cast<bool>(_ofs);
+			if(!_active) {
+				std::error_code ec;
+				std::filesystem::remove(_path, ec);
+			}
+			return true;
+		}
+		void commit_impl() {
+			_ofs.flush();
+			if(!_ofs) {
+				gapr::print("state_cache failed to write journal");
+				_ofs.close();
+				_active=false;
+				std::error_code ec;
+				std::filesystem::remove(_path, ec);
+			}
+		}
+};
@@ -491,6 +491,7 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 	gapr::edge_model _model;
 	gapr::commit_history _hist;
 	uint64_t _latest_commit;
+	state_journal _journal;
 
 	bool _states_valid{false};
 	//XXX state_section;
@@ -835,6 +836,10 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 			if(std::regex_search(dbg_flags, r)) {
 				_debug_fps=true;
 			}
+			std::regex r2{"\\bcache\\b", std::regex::icase};
+			if(std::regex_search(dbg_flags, r2)) {
+				_debug_cache=true;
+			}
 		}
 
 		if(has_args()) {
@@ -1705,38 +1710,39 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 			update_model_stats(updater);
 		}
 
-		std::size_t nocache_siz;
-		if(last && (nocache_siz=_model.nocache_inc(0))>16*1024*1024) {
-			assert(_hist.tail_tip()==0);
+		if(last && _hist.tail().empty() && _journal.overflow()) {
 			auto state_cnt=_hist.body_count();
+			auto size0=_journal.size();
 			auto ex1=gapr::app().thread_pool().get_executor();
-			gapr::print("state_cache cache overflow: ", nocache_siz, " dumping...");
-			ba::post(ex1, [this,state_cnt,nocache_siz]() mutable {
+			gapr::print("state_cache journal overflow: ", size0, " compacting...");
+			ba::post(ex1, [this,state_cnt,size0]() mutable {
 				gapr::edge_model::reader reader{_model};
-				auto file=reader.dump_state(state_cnt);
-				auto buf=gapr::make_streambuf(std::move(file));
-				// ZZZ
-				if(true) {
-					gapr::edge_model model2;
-					{
-						edge_model::loader loader2{model2};
-						auto r=loader2.init(*buf);
-						assert(r);
-						buf->pubseekpos(0);
-					}
-					{
-						edge_model::updater updater2{model2};
-						updater2.apply();
-					}
-					{
-						edge_model::reader reader2{model2};
-						auto r=reader2.equal(reader);
-						assert(r);
+				auto r=_journal.compact(state_cnt, size0, [this,&reader,state_cnt]() {
+					auto file=reader.dump_state(state_cnt);
+					if(_debug_cache) {
+						auto buf=gapr::make_streambuf(gapr::mem_file{file});
+						gapr::edge_model model2;
+						{
+							edge_model::loader loader2{model2};
+							auto r=loader2.init(*buf);
+							assert(r);
+							(void)r;
+						}
+						{
+							edge_model::updater updater2{model2};
+							updater2.apply();
+						}
+						{
+							edge_model::reader reader2{model2};
+							auto r=reader2.equal(reader);
+							assert(r);
+							(void)r;
+						}
 					}
-				}
-				auto cachepath=get_state_cachepath();
-				save_cache_file(cachepath, *buf);
-				_model.nocache_dec(nocache_siz);
+					return file;
+				});
+				if(!r)
+					gapr::print("state_cache compaction skipped");
 			});
 		}
 		return true;
@@ -1782,24 +1788,29 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 			gapr::fiber fib2{ctx.get_executor(), prom.get_future()};
 			auto ex1=this->thread_pool().get_executor();
 			ba::post(ex1, [this,prom=std::move(prom),strmbuf=strmbuf.get()]() mutable {
+				auto start=strmbuf->pubseekoff(0, std::ios::cur, std::ios::in);
 				gapr::commit_info info;
 				if(!info.load(*strmbuf))
 					gapr::report("commit file no commit info");
 				auto ex1=this->thread_pool().get_executor();
 				assert(ex1.running_in_this_thread());
 				(void)ex1;
-				gapr::edge_model::loader loader{_model};
-				auto r=gapr::delta_variant::visit<bool>(gapr::delta_type{info.type},
-						[&loader,&info,strmbuf](auto typ) {
-							gapr::delta<typ> delta;
-							if(!gapr::load(delta, *strmbuf))
-								gapr::report("commit file no delta");
-							if(!loader.load(gapr::node_id{info.nid0}, std::move(delta)))
-								return false;
-							return true;
-						});
+				bool r;
+				{
+					gapr::edge_model::loader loader{_model};
+					r=gapr::delta_variant::visit<bool>(gapr::delta_type{info.type},
+							[&loader,&info,strmbuf](auto typ) {
+								gapr::delta<typ> delta;
+								if(!gapr::load(delta, *strmbuf))
+									gapr::report("commit file no delta");
+								if(!loader.load(gapr::node_id{info.nid0}, std::move(delta)))
+									return false;
+								return true;
+							});
+				}
 				if(!r)
 					return std::move(prom).set(std::numeric_limits<uint64_t>::max());
+				_journal.append(*strmbuf, start);
 				return std::move(prom).set(info.id);
 			});
 
@@ -1826,7 +1837,6 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 			}
 			timer.mark<3>();
 		}
-		_model.nocache_inc(total_size);
 		gapr::print("load commits timming: ", timer);
 		return true;
 	}
@@ -1857,29 +1867,46 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 		}
 		timer.mark<1>();
 
-		gapr::promise<uint64_t> prom{};
+		gapr::promise<gapr::commit_history> prom{};
 		gapr::fiber fib2{ctx.get_executor(), prom.get_future()};
 		auto ex1=this->thread_pool().get_executor();
 		ba::post(ex1, [this,use_existing,prom=std::move(prom),buf=std::move(cachebuf),cachepath=std::move(cachepath)]() mutable {
 			auto ex1=this->thread_pool().get_executor();
 			assert(ex1.running_in_this_thread());
-			edge_model::loader loader{_model};
-			auto r=loader.init(*buf);
-			std::move(prom).set(r);
-			if(r && !use_existing && buf->pubseekoff(0, std::ios::cur, std::ios::in)>16*1024*1024) {
+			uint64_t r;
+			{
+				edge_model::loader loader{_model};
+				r=loader.init(*buf);
+			}
+			gapr::commit_history hist;
+			if(!r)
+				return std::move(prom).set(std::move(hist));
+			hist.body_count(r);
+			if(use_existing) {
+				if(!_journal.replay(_model, hist))
+					return std::move(prom).set(gapr::commit_history{});
+				return std::move(prom).set(std::move(hist));
+			}
+			// before any commit is journaled
+			if(buf->pubseekoff(0, std::ios::cur, std::ios::in)>16*1024*1024) {
 				buf->pubseekpos(0);
 				save_cache_file(cachepath, *buf);
- 			}
+				_journal.reset(r);
+			} else {
+				_journal.reset(0);
+			}
+			std::move(prom).set(std::move(hist));
 		});
-		auto r=std::move(fib2).async_wait(gapr::yield{ctx});
-		if(!r)
+		auto hist=std::move(fib2).async_wait(gapr::yield{ctx});
+		if(!hist.body_count())
 			return false;
 		timer.mark<2>();
-		_hist.body_count(r);
+		_hist=std::move(hist);
 		gapr::print("load model_state timming: ", timer);
 		return true;
 	}
 	bool do_load_latest(gapr::fiber_ctx& ctx) {
+		_journal.bind(get_state_cachepath());
 		if(_latest_commit>100 && _hist.body_count()==0 && _hist.tail().empty()) {
 			if(!load_model_state(ctx, _cur_conn))
 				return false;
@@ -1934,7 +1961,7 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 				}
 			});
 			auto payload=std::move(fib2).async_wait(gapr::yield{ctx});
-			auto payload_size=payload.size();
+			auto payload_copy=payload;
 
 			auto msg=_cur_conn;
 			gapr::fiber fib{ctx.get_executor(), api.commit(msg, Typ, std::move(payload), _hist.body_count(), _hist.tail_tip())};
@@ -1958,15 +1985,17 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 			gapr::promise<bool> prom2{};
 			gapr::fiber fib3{ctx.get_executor(), prom2.get_future()};
 			auto ex2=this->thread_pool().get_executor();
-			ba::post(ex2, [this,nid0=nid0,prom2=std::move(prom2),&delta]() mutable {
+			gapr::commit_info info{cmt_id, args().user, gapr::to_timestamp(std::chrono::system_clock::now()), nid0, static_cast<std::underlying_type_t<gapr::delta_type>>(Typ)};
+			ba::post(ex2, [this,nid0=nid0,prom2=std::move(prom2),&delta,&info,&payload_copy]() mutable {
 				auto r=model_prepare(gapr::node_id{nid0}, std::move(delta));
+				if(r)
+					_journal.append(info, payload_copy);
 				return std::move(prom2).set(r);
 			});
 			// XXX join edges
 			if(!std::move(fib3).async_wait(gapr::yield{ctx}))
 				return {SubmitRes::Deny, "err load2"};
 			gapr::print("prepare ok");
-			_model.nocache_inc(payload_size);
 			_hist.add_tail(cmt_id);
 			return {SubmitRes::Accept, {}};
 		}
@@ -4528,6 +4557,7 @@ class gapr::fix::SessionImpl: public gapr::fix::Session, private Base {
 	std::chrono::steady_clock::time_point prevt{};
 	int prevc=0;
 	bool _debug_fps{false};
+	bool _debug_cache{false};
 	void printFPS() {
 		auto nowt=std::chrono::steady_clock::now();
 		prevc++;
@@ -10,15 +10,20 @@
 #include <filesystem>
 #include <algorithm>
 #include <unordered_set>
+#include <random>
+#include <functional>
+#include <thread>
 
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/device/array.hpp>
 
 #include <sys/stat.h>
 //#include <unistd.h>
 #include <malloc.h>
 
 #include "../corelib/model-upgrade.hh"
+#include "../corelib/dup/serialize-delta.hh"
 
 static constexpr double HARD_COLL_DIST{1.0};
 static constexpr double SOFT_COLL_DIST{5.0};
@@ -162,6 +167,67 @@ struct spatial_info {
 	}
 };
 
+/*! caches for /api/stats and /api/proofread-stats.
+ * saved commits never change, so nothing here goes stale: dumps are
+ * kept gzip'ed per aligned segment of SEG_SIZE commits, and proofread
+ * related deltas are reduced to a log of events.  both are caught up
+ * in the background at startup and as commits are saved, a request
+ * only scans the unaligned ends of its range and what is not caught
+ * up yet.
+ */
+class stats_cache: public std::enable_shared_from_this<stats_cache> {
+	public:
+		static constexpr uint64_t SEG_SIZE{4096};
+
+		void dump(const gapr::archive& repo, uint64_t from, uint64_t to, std::ostream& str);
+		std::string proofread(const gapr::archive& repo, uint64_t from, uint64_t to);
+		/*! fill both caches for commits before `to' */
+		void catch_up(const gapr::archive& repo, uint64_t to);
+		/*! catch_up() in a job posted with post(), coalesced */
+		void extend(const gapr::archive& repo, uint64_t to) noexcept;
+
+		/*! decode SEG_SIZE chunks of commits concurrently */
+		void workers(unsigned int n, std::function<void(std::function<void()>&&)> post) {
+			_nworkers=n;
+			_post=std::move(post);
+		}
+
+	private:
+		struct pr_event {
+			uint64_t id;
+			uint32_t who;
+			enum Kind: uint8_t {
+				PROOFREAD,
+				REPORT,
+				RESOLVE
+			} kind;
+			uint64_t n;
+			std::string res;
+		};
+		struct pr_log {
+			std::vector<pr_event> events;
+			std::vector<std::string> users;
+			std::unordered_map<std::string, uint32_t> user_ids;
+			uint32_t who(const std::string& usr);
+			/*! events of r before commit `from' are dropped */
+			void append(pr_log&& r, uint64_t from);
+		};
+		std::mutex _seg_mtx;
+		std::vector<std::shared_ptr<const std::string>> _segs;
+		std::mutex _pr_mtx;
+		uint64_t _pr_scanned{0};
+		pr_log _pr_log;
+		unsigned int _nworkers{1};
+		std::function<void(std::function<void()>&&)> _post;
+		std::atomic<uint64_t> _bg_to{0};
+		std::atomic<bool> _bg_busy{false};
+
+		std::shared_ptr<const std::string> segment(const gapr::archive& repo, uint64_t seg);
+		void extend_log(const gapr::archive& repo, uint64_t to, unsigned int nworkers);
+		void run_bg(const gapr::archive& repo) noexcept;
+		friend struct pr_recorder;
+};
+
 struct gather_model::PRIV {
 
 	enum VAL_STATE {
@@ -198,9 +264,11 @@ struct gather_model::PRIV {
 	}
 
 	gapr::archive _repo;
+	// shared with background jobs, that may outlive the model
+	std::shared_ptr<stats_cache> _stats{std::make_shared<stats_cache>()};
 
 		template<gapr::delta_type Typ> static bool do_prepare(gather_model& model, gapr::delta<Typ>&& delta);
-		static void do_prepare1(gather_model& model, const gapr::commit_info& info, std::streambuf& fs);
+		template<typename Src> static void do_prepare1(gather_model& model, const gapr::commit_info& info, Src& fs);
 		static bool do_prepare2(gather_model& model, gapr::delta_type type, std::streambuf& str, std::unique_lock<std::mutex>& lck);
 
 
@@ -556,19 +624,17 @@ gather_model::gather_model(std::string&& path):
 	uint64_t id=0;
 	while(true) {
 		std::array<char,32> fn_buf;
-		auto sbuf=repo.reader_streambuf(gapr::to_string_lex(fn_buf, id));
-		if(!sbuf)
+		auto view=repo.get_view(gapr::to_string_lex(fn_buf, id));
+		if(!view)
 			break;
 
-		if(!sbuf)
-			gapr::report("failed to open file");
 		gapr::commit_info info;
-		if(!info.load(*sbuf))
+		if(!info.load(view))
 			gapr::report("commit file no commit info");
 		if(info.id!=id)
 			gapr::report("commit file wrong id");
 
-		PRIV::do_prepare1(*this, info, *sbuf);
+		PRIV::do_prepare1(*this, info, view);
 
 		PRIV::do_apply(*this);
 		id++;
@@ -672,6 +738,7 @@ std::tuple<gapr::node_id::data_type, uint64_t, uint64_t> gather_model::modifier:
 	// before unlock required.
 	_model._num_commits.fetch_add(1);
 	_lck.unlock();
+	_model._priv->_stats->extend(_model._priv->_repo, commit_id+1);
 	assert(nid_alloc);
 	gapr::print("end apply", soft_coll, ':', commit_id, ':', nid_alloc);
 	return {nid_alloc.data, commit_id, soft_coll};
@@ -1491,29 +1558,21 @@ bool dump_special(std::ostream& str, const gapr::delta<Typ>& delta, const gapr::
 	}
 	return false;
 }
-std::string gather_model::get_stats(uint64_t from) const {
-	std::ostringstream oss_{};
-	boost::iostreams::filtering_streambuf<boost::iostreams::output> oss_buf{};
-	oss_buf.push(boost::iostreams::gzip_compressor{4});
-	oss_buf.push(oss_);
-	std::ostream oss{&oss_buf};
-	auto to=_num_commits.load();
-	oss<<"Stats: ["<<from<<", "<<to<<")\n";
-	auto repo=_priv->_repo;
+static void scan_dump(const gapr::archive& repo, uint64_t from, uint64_t to, std::ostream& oss) {
 	for(auto id=from; id<to; id++) {
 		std::array<char,32> fn_buf;
-		auto sbuf=repo.reader_streambuf(gapr::to_string_lex(fn_buf, id));
-		if(!sbuf)
+		auto view=repo.get_view(gapr::to_string_lex(fn_buf, id));
+		if(!view)
 			gapr::report("failed to open file");
 
 		gapr::commit_info info;
-		if(!info.load(*sbuf))
+		if(!info.load(view))
 			gapr::report("commit file no commit info");
 		oss<<"Commit: "<<info<<": ";
 		gapr::delta_variant::visit<void>(gapr::delta_type{info.type},
-				[sbuf=std::move(sbuf),&info,&oss](auto typ) {
+				[&view,&info,&oss](auto typ) {
 					gapr::delta<typ> delta;
-					if(!gapr::load(delta, *sbuf))
+					if(!gapr::load(delta, view))
 						gapr::report("failed to load delta");
 					if(dump_special(oss, delta, info))
 						return;
@@ -1521,38 +1580,35 @@ std::string gather_model::get_stats(uint64_t from) const {
 				});
 		oss.flush();
 	}
-	oss_buf.reset();
-	return oss_.str();
 }
 
-std::string gather_model::get_proofread_stats(gapr::commit_id from, gapr::commit_id to_) const {
-	auto to=_num_commits.load();
-	if(to_.data>0) {
-		if(to>to_.data)
-			to=to_.data;
-	}
-	auto repo=_priv->_repo;
-	std::unordered_map<gapr::node_id, std::string> err2typ;
-	std::unordered_map<gapr::node_id, std::string> err2rep;
-	std::unordered_map<std::string, unsigned int> usr2pr;
-	std::vector<std::pair<gapr::node_id, std::string>> duprep;
-	for(auto id=from.data; id<to; id++) {
+/*! decodes proofread related commits in [from, to), for Sink */
+template<typename Sink>
+static void scan_proofread(const gapr::archive& repo, uint64_t from, uint64_t to, Sink& sink) {
+	for(auto id=from; id<to; id++) {
 		std::array<char,32> fn_buf;
-		auto sbuf=repo.reader_streambuf(gapr::to_string_lex(fn_buf, id));
-		if(!sbuf)
+		auto view=repo.get_view(gapr::to_string_lex(fn_buf, id));
+		if(!view)
 			gapr::report("failed to open file");
 
 		gapr::commit_info info;
-		if(!info.load(*sbuf))
+		if(!info.load(view))
 			gapr::report("commit file no commit info");
+		switch(gapr::delta_type{info.type}) {
+			case gapr::delta_type::proofread_:
+			case gapr::delta_type::add_prop_:
+			case gapr::delta_type::chg_prop_:
+				break;
+			default:
+				continue;
+		}
 		gapr::delta_variant::visit<void>(gapr::delta_type{info.type},
-				[sbuf=std::move(sbuf),&info,&usr2pr,&err2rep,&err2typ,&duprep](auto typ) {
+				[&view,&info,&sink](auto typ) {
 					gapr::delta<typ> delta;
-					if(!gapr::load(delta, *sbuf))
+					if(!gapr::load(delta, view))
 						gapr::report("failed to load delta");
 					if constexpr(typ==gapr::delta_type::proofread_) {
-						auto [it, ins]=usr2pr.emplace(info.who, 0);
-						it->second+=delta.nodes.size();
+						sink.proofread(info, delta.nodes.size());
 					} else if constexpr(typ==gapr::delta_type::add_prop_) {
 						auto n=delta.prop.find('=');
 						if(n==delta.prop.npos) {
@@ -1565,10 +1621,7 @@ std::string gather_model::get_proofread_stats(gapr::commit_id from, gapr::commit
 						gapr::link_id link{delta.link};
 						if(!link.nodes[0])
 							link.nodes[0]=gapr::node_id{info.nid0};
-						auto [it, ins]=err2rep.emplace(link.nodes[0], "");
-						if(!ins)
-							duprep.emplace_back(it->first, it->second);
-						it->second=info.who;
+						sink.report(info, link.nodes[0]);
 					} else if constexpr(typ==gapr::delta_type::chg_prop_) {
 						std::string res;
 						auto n=delta.prop.find('=');
@@ -1581,22 +1634,58 @@ std::string gather_model::get_proofread_stats(gapr::commit_id from, gapr::commit
 								return;
 							res=delta.prop.substr(n);
 						}
-						//die "no rep!\n" if(not defined($err2rep{$eid}));
-						auto [it, ins]=err2typ.emplace(delta.node, "");
-						if(!ins) {
-							//$err2typ{$eid}.=" $etyp($usr)";
-						}
-						it->second.reserve(res.size()+info.who.size()+2);
-						it->second=res;
-						it->second+='(';
-						it->second+=info.who;
-						it->second+=')';
+						sink.resolve(info, gapr::node_id{delta.node}, std::move(res));
 					}
 				});
 	}
+}
+
+namespace {
+struct pr_tally {
+	std::unordered_map<gapr::node_id, std::string> err2typ;
+	std::unordered_map<gapr::node_id, std::string> err2rep;
+	std::unordered_map<std::string, unsigned int> usr2pr;
+	std::vector<std::pair<gapr::node_id, std::string>> duprep;
+
+	void proofread(const std::string& who, std::size_t n) {
+		auto [it, ins]=usr2pr.emplace(who, 0);
+		it->second+=n;
+	}
+	void report(const std::string& who, gapr::node_id node) {
+		auto [it, ins]=err2rep.emplace(node, "");
+		if(!ins)
+			duprep.emplace_back(it->first, it->second);
+		it->second=who;
+	}
+	void resolve(const std::string& who, gapr::node_id node, const std::string& res) {
+		//die "no rep!\n" if(not defined($err2rep{$eid}));
+		auto [it, ins]=err2typ.emplace(node, "");
+		if(!ins) {
+			//$err2typ{$eid}.=" $etyp($usr)";
+		}
+		it->second.reserve(res.size()+who.size()+2);
+		it->second=res;
+		it->second+='(';
+		it->second+=who;
+		it->second+=')';
+	}
+	void proofread(const gapr::commit_info& info, std::size_t n) {
+		proofread(info.who, n);
+	}
+	void report(const gapr::commit_info& info, gapr::node_id node) {
+		report(info.who, node);
+	}
+	void resolve(const gapr::commit_info& info, gapr::node_id node, std::string&& res) {
+		resolve(info.who, node, res);
+	}
+
+	std::string json(uint64_t from, uint64_t to) const;
+};
+}
 
+std::string pr_tally::json(uint64_t from, uint64_t to) const {
 	std::ostringstream oss;
-	oss<<"{\"from\":"<<from.data<<",\"to\":"<<to;
+	oss<<"{\"from\":"<<from<<",\"to\":"<<to;
 	if(!duprep.empty()) {
 		oss<<",\"dupreps\"=[";
 		for(std::size_t i=0; i<duprep.size(); ++i) {
@@ -1652,6 +1741,228 @@ std::string gather_model::get_proofread_stats(gapr::commit_id from, gapr::commit
 	return oss.str();
 }
 
+struct pr_recorder {
+	stats_cache::pr_log& log;
+	void proofread(const gapr::commit_info& info, std::size_t n) {
+		log.events.push_back({info.id, log.who(info.who), stats_cache::pr_event::PROOFREAD, n, {}});
+	}
+	void report(const gapr::commit_info& info, gapr::node_id node) {
+		log.events.push_back({info.id, log.who(info.who), stats_cache::pr_event::REPORT, node.data, {}});
+	}
+	void resolve(const gapr::commit_info& info, gapr::node_id node, std::string&& res) {
+		log.events.push_back({info.id, log.who(info.who), stats_cache::pr_event::RESOLVE, node.data, std::move(res)});
+	}
+};
+
+uint32_t stats_cache::pr_log::who(const std::string& usr) {
+	auto [it, ins]=user_ids.emplace(usr, users.size());
+	if(ins)
+		users.push_back(usr);
+	return it->second;
+}
+void stats_cache::pr_log::append(pr_log&& r, uint64_t from) {
+	std::vector<uint32_t> ids;
+	ids.reserve(r.users.size());
+	for(auto& usr: r.users)
+		ids.push_back(who(usr));
+	events.reserve(events.size()+r.events.size());
+	for(auto& e: r.events) {
+		if(e.id<from)
+			continue;
+		e.who=ids[e.who];
+		events.push_back(std::move(e));
+	}
+}
+
+std::shared_ptr<const std::string> stats_cache::segment(const gapr::archive& repo, uint64_t seg) {
+	{
+		std::lock_guard lck{_seg_mtx};
+		if(seg<_segs.size() && _segs[seg])
+			return _segs[seg];
+	}
+	// racing builders produce the same bytes, keep the first
+	std::ostringstream oss_{};
+	{
+		boost::iostreams::filtering_streambuf<boost::iostreams::output> oss_buf{};
+		oss_buf.push(boost::iostreams::gzip_compressor{1});
+		oss_buf.push(oss_);
+		std::ostream oss{&oss_buf};
+		scan_dump(repo, seg*SEG_SIZE, (seg+1)*SEG_SIZE, oss);
+	}
+	auto str=std::make_shared<const std::string>(oss_.str());
+	std::lock_guard lck{_seg_mtx};
+	if(seg>=_segs.size())
+		_segs.resize(seg+1);
+	if(!_segs[seg])
+		_segs[seg]=std::move(str);
+	return _segs[seg];
+}
+
+void stats_cache::dump(const gapr::archive& repo, uint64_t from, uint64_t to, std::ostream& str) {
+	// pieces: an unaligned head, whole segments, an unaligned tail
+	struct piece {
+		uint64_t from, to;
+		bool cached;
+		std::shared_ptr<const std::string> buf;
+	};
+	std::vector<piece> pieces;
+	for(auto id=from; id<to; ) {
+		auto seg=id/SEG_SIZE;
+		auto seg_end=(seg+1)*SEG_SIZE;
+		auto end=std::min(seg_end, to);
+		pieces.push_back(piece{id, end, id==seg*SEG_SIZE && end==seg_end, {}});
+		id=end;
+	}
+
+	gapr::parallel_for(pieces.size(), _nworkers, _post, [this,&repo,&pieces](std::size_t i, unsigned int) {
+		auto& p=pieces[i];
+		if(p.cached) {
+			p.buf=segment(repo, p.from/SEG_SIZE);
+			return;
+		}
+		std::ostringstream oss;
+		scan_dump(repo, p.from, p.to, oss);
+		p.buf=std::make_shared<const std::string>(oss.str());
+	});
+
+	for(auto& p: pieces) {
+		if(!p.cached) {
+			str.write(p.buf->data(), p.buf->size());
+			str.flush();
+			continue;
+		}
+		boost::iostreams::filtering_streambuf<boost::iostreams::input> inp{};
+		inp.push(boost::iostreams::gzip_decompressor{});
+		inp.push(boost::iostreams::array_source{p.buf->data(), p.buf->size()});
+		str<<&inp;
+		str.flush();
+	}
+}
+
+void stats_cache::extend_log(const gapr::archive& repo, uint64_t to, unsigned int nworkers) {
+	uint64_t base;
+	{
+		std::lock_guard lck{_pr_mtx};
+		base=_pr_scanned;
+	}
+	if(base>=to)
+		return;
+	// scanned unlocked, requests in the meantime scan on their own
+	std::vector<pr_log> logs((to-base+SEG_SIZE-1)/SEG_SIZE);
+	gapr::parallel_for(logs.size(), nworkers, _post, [&repo,&logs,base,to](std::size_t i, unsigned int) {
+		pr_recorder rec{logs[i]};
+		auto a=base+i*SEG_SIZE;
+		scan_proofread(repo, a, std::min(a+SEG_SIZE, to), rec);
+	});
+	std::lock_guard lck{_pr_mtx};
+	if(_pr_scanned>=to)
+		return;
+	// only the part still missing
+	for(auto& log: logs)
+		_pr_log.append(std::move(log), _pr_scanned);
+	_pr_scanned=to;
+}
+
+std::string stats_cache::proofread(const gapr::archive& repo, uint64_t from, uint64_t to) {
+	extend_log(repo, to, _nworkers);
+	pr_tally tally;
+	std::lock_guard lck{_pr_mtx};
+	auto& events=_pr_log.events;
+	auto it=std::lower_bound(events.begin(), events.end(), from, [](auto& e, uint64_t id) {
+		return e.id<id;
+	});
+	for(; it!=events.end() && it->id<to; ++it) {
+		auto& who=_pr_log.users[it->who];
+		switch(it->kind) {
+			case pr_event::PROOFREAD:
+				tally.proofread(who, it->n);
+				break;
+			case pr_event::REPORT:
+				tally.report(who, gapr::node_id{static_cast<gapr::node_id::data_type>(it->n)});
+				break;
+			case pr_event::RESOLVE:
+				tally.resolve(who, gapr::node_id{static_cast<gapr::node_id::data_type>(it->n)}, it->res);
+				break;
+		}
+	}
+	return tally.json(from, to);
+}
+
+void stats_cache::catch_up(const gapr::archive& repo, uint64_t to) {
+	// one thread, leave the pool to requests and commits
+	extend_log(repo, to, 1);
+	for(uint64_t seg=0; seg<to/SEG_SIZE; seg++)
+		segment(repo, seg);
+}
+
+void stats_cache::extend(const gapr::archive& repo, uint64_t to) noexcept {
+	if(!_post)
+		return;
+	auto prev=_bg_to.load();
+	while(prev<to && !_bg_to.compare_exchange_weak(prev, to));
+	if(_bg_busy.exchange(true))
+		return;
+	try {
+		_post([ptr=weak_from_this(),repo]() {
+			if(auto cache=ptr.lock())
+				cache->run_bg(repo);
+		});
+	} catch(...) {
+		_bg_busy=false;
+	}
+}
+
+void stats_cache::run_bg(const gapr::archive& repo) noexcept {
+	do {
+		auto to=_bg_to.load();
+		try {
+			catch_up(repo, to);
+		} catch(const std::exception& e) {
+			// requests still scan what is missing
+			gapr::print("failed to update stats cache: ", e.what());
+			_bg_busy=false;
+			return;
+		}
+		_bg_busy=false;
+		if(_bg_to.load()==to)
+			return;
+	} while(!_bg_busy.exchange(true));
+}
+
+template<typename Body>
+static std::string gzip_stats(uint64_t from, uint64_t to, Body&& body) {
+	std::ostringstream oss_{};
+	boost::iostreams::filtering_streambuf<boost::iostreams::output> oss_buf{};
+	oss_buf.push(boost::iostreams::gzip_compressor{4});
+	oss_buf.push(oss_);
+	std::ostream oss{&oss_buf};
+	oss<<"Stats: ["<<from<<", "<<to<<")\n";
+	body(oss);
+	oss_buf.reset();
+	return oss_.str();
+}
+
+std::string gather_model::get_stats(uint64_t from) const {
+	auto to=_num_commits.load();
+	return gzip_stats(from, to, [this,from,to](std::ostream& oss) {
+		_priv->_stats->dump(_priv->_repo, from, to, oss);
+	});
+}
+
+void gather_model::scan_workers(unsigned int n, std::function<void(std::function<void()>&&)> post) {
+	_priv->_stats->workers(n, std::move(post));
+	_priv->_stats->extend(_priv->_repo, _num_commits.load());
+}
+
+std::string gather_model::get_proofread_stats(gapr::commit_id from, gapr::commit_id to_) const {
+	auto to=_num_commits.load();
+	if(to_.data>0) {
+		if(to>to_.data)
+			to=to_.data;
+	}
+	return _priv->_stats->proofread(_priv->_repo, from.data, to);
+}
+
 #include "gapr/detail/delta-stats.hh"
 
 void gather_model::update_stats(void* prev_, uint32_t& nn, uint32_t& nnr, uint32_t& nt, uint32_t& ntr, uint64_t& nc) const {
@@ -1663,17 +1974,17 @@ void gather_model::update_stats(void* prev_, uint32_t& nn, uint32_t& nnr, uint32
 	auto repo=_priv->_repo;
 	for(auto id=from; id<to; id++) {
 		std::array<char,32> fn_buf;
-		auto sbuf=repo.reader_streambuf(gapr::to_string_lex(fn_buf, id));
-		if(!sbuf)
+		auto view=repo.get_view(gapr::to_string_lex(fn_buf, id));
+		if(!view)
 			gapr::report("failed to open file");
 
 		gather_stats::CommitInfo info;
-		if(!info.load(*sbuf))
+		if(!info.load(view))
 			gapr::report("commit file no commit info");
 		gapr::delta_variant::visit<void>(gapr::delta_type{info.type},
-				[sbuf=std::move(sbuf),&info](auto typ) {
+				[&view,&info](auto typ) {
 					gapr::delta<typ> delta;
-					if(!gapr::load(delta, *sbuf))
+					if(!gapr::load(delta, view))
 						gapr::report("failed to load delta");
 					DeltaStats stats;
 					stats.add(delta);
@@ -1828,7 +2139,7 @@ void gather_stats::update_end() {
 
 
 /*! after templ. inst. */
-void gather_model::PRIV::do_prepare1(gather_model& model, const gapr::commit_info& info, std::streambuf& fs) {
+template<typename Src> void gather_model::PRIV::do_prepare1(gather_model& model, const gapr::commit_info& info, Src& fs) {
 	gapr::node_id nid0{info.nid0};
 	if(nid0!=model._num_nodes+1) {
 		if(nid0<model._num_nodes+1)
@@ -1867,6 +2178,9 @@ std::unique_ptr<std::streambuf> gather_model::get_commit(uint32_t id) const {
 void gather_model::xxx_prepare(const gapr::commit_info& info, std::streambuf& buf) {
 	return PRIV::do_prepare1(*this, info, buf);
 }
+void gather_model::xxx_prepare(const gapr::commit_info& info, gapr::archive::view& view) {
+	return PRIV::do_prepare1(*this, info, view);
+}
 void gather_model::xxx_apply() {
 	return PRIV::do_apply(*this);
 }
@@ -1925,3 +2239,383 @@ void gather_model::peek_bbox(gapr::bbox_int& bbox) const noexcept {
 		bbox.add(l.p1);
 	}
 }
+
+static void fill_test_repo(gapr::archive& repo, uint64_t ncommits) {
+	std::mt19937 rng{2024};
+	const char* users[]={"alice", "bob", "carol", "dave"};
+	const char* errs[]={"error", "error=", "error=fixed", "error=deferred", "state=end"};
+	for(uint64_t id=0; id<ncommits; id++) {
+		gapr::commit_info info{static_cast<gapr::commit_id::data_type>(id), users[rng()%4], 1600000000000+id*1000, static_cast<gapr::node_id::data_type>(1+id), 0};
+		std::ostringstream oss;
+		auto save=[&info,&oss](auto typ, auto& delta) {
+			info.type=static_cast<std::underlying_type_t<gapr::delta_type>>(typ);
+			if(!info.save(*oss.rdbuf()) || !gapr::save(delta, *oss.rdbuf()))
+				gapr::report("failed to save");
+		};
+		switch(rng()%3) {
+			case 0:
+				{
+					gapr::delta_proofread_ delta;
+					for(unsigned int i=rng()%5; i>0; i--)
+						delta.nodes.push_back(1+rng()%1000);
+					save(gapr::delta_type::proofread_, delta);
+				}
+				break;
+			case 1:
+				{
+					gapr::delta_add_prop_ delta;
+					delta.link=gapr::link_id{gapr::node_id{static_cast<gapr::node_id::data_type>(rng()%300)}, {}}.data();
+					delta.node=gapr::node_attr{1.0*(rng()%100), 2.0, 3.0}.data();
+					delta.prop=errs[rng()%5];
+					save(gapr::delta_type::add_prop_, delta);
+				}
+				break;
+			case 2:
+				{
+					gapr::delta_chg_prop_ delta;
+					delta.node=1+rng()%300;
+					delta.prop=errs[rng()%5];
+					save(gapr::delta_type::chg_prop_, delta);
+				}
+				break;
+		}
+		std::array<char,32> fn_buf;
+		auto ofs=repo.get_writer(gapr::to_string_lex(fn_buf, id));
+		auto str=oss.str();
+		auto [buf, siz]=ofs.buffer();
+		if(!buf || siz<str.size())
+			gapr::report("commit too large");
+		std::memcpy(buf, str.data(), str.size());
+		ofs.commit(str.size());
+		if(!ofs.flush())
+			gapr::report("failed to flush");
+	}
+}
+
+namespace gapr_test { int chk_stats_cache() {
+	// commits written straight to a scratch repo, no model validation
+	auto path=std::filesystem::temp_directory_path()/"gapr-chk-stats-cache";
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	gapr::archive repo{path.string().c_str()};
+	uint64_t ncommits=stats_cache::SEG_SIZE*2+321;
+	fill_test_repo(repo, ncommits);
+
+	std::pair<uint64_t, uint64_t> ranges[]={
+		{0, ncommits}, {0, ncommits}, {17, ncommits-5},
+		{stats_cache::SEG_SIZE, stats_cache::SEG_SIZE*2},
+		{100, 200}, {ncommits, ncommits}, {5, ncommits},
+	};
+	int ret=0;
+	// cold, and caught up to the middle of a segment
+	for(uint64_t warm: {uint64_t{0}, stats_cache::SEG_SIZE*2-100}) {
+		stats_cache cache;
+		cache.workers(3, [](std::function<void()>&& f) {
+			std::thread{std::move(f)}.detach();
+		});
+		cache.catch_up(repo, warm);
+		for(auto [from, to]: ranges) {
+			auto a=gzip_stats(from, to, [&](std::ostream& oss) {
+				scan_dump(repo, from, to, oss);
+			});
+			auto b=gzip_stats(from, to, [&](std::ostream& oss) {
+				cache.dump(repo, from, to, oss);
+			});
+			pr_tally tally;
+			scan_proofread(repo, from, to, tally);
+			auto c=tally.json(from, to);
+			auto d=cache.proofread(repo, from, to);
+			if(a!=b || c!=d) {
+				gapr::print("mismatch: [", from, ", ", to, "), warm ", warm);
+				ret=-1;
+			}
+		}
+	}
+	repo={};
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	return ret;
+} }
+
+namespace gapr_test { int bench_stats_scan() {
+	auto path=std::filesystem::temp_directory_path()/"gapr-bench-stats-scan";
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	gapr::archive repo{path.string().c_str()};
+	constexpr uint64_t ncommits=200'000;
+	repo.begin_buffered(2);
+	fill_test_repo(repo, ncommits);
+	repo.end_buffered();
+
+	std::string ref;
+	for(unsigned int n: {1u, std::max(std::thread::hardware_concurrency(), 2u)}) {
+		stats_cache cache;
+		cache.workers(n, [](std::function<void()>&& f) {
+			std::thread{std::move(f)}.detach();
+		});
+		auto t0=std::chrono::steady_clock::now();
+		auto a=gzip_stats(0, ncommits, [&](std::ostream& oss) {
+			cache.dump(repo, 0, ncommits, oss);
+		});
+		auto t1=std::chrono::steady_clock::now();
+		auto b=cache.proofread(repo, 0, ncommits);
+		auto t2=std::chrono::steady_clock::now();
+		gapr::print("workers ", n, ": stats ", std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count(),
+				"ms, proofread-stats ", std::chrono::duration_cast<std::chrono::milliseconds>(t2-t1).count(), "ms");
+		if(ref.empty())
+			ref=a+b;
+		else if(ref!=a+b)
+			return -1;
+	}
+	repo={};
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	return 0;
+} }
+
+namespace gapr_test { int bench_model_replay() {
+	auto path=std::filesystem::temp_directory_path()/"gapr-bench-model-replay";
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	gapr::archive repo{path.string().c_str()};
+	constexpr uint64_t ncommits=100'000;
+	repo.begin_buffered(2);
+	{
+		// unconnected paths, each commit valid on its own
+		std::mt19937 rng{2024};
+		gapr::node_id::data_type nid0=1;
+		for(uint64_t id=0; id<ncommits; id++) {
+			gapr::delta_add_edge_ delta{};
+			gapr::node_attr node{1.0*(rng()%10000), 1.0*(rng()%10000), 1.0*(rng()%1000)};
+			for(auto n=2+rng()%60; n>0; n--) {
+				for(unsigned int i=0; i<3; i++)
+					node.ipos[i]+=static_cast<int32_t>(rng()%2001)-1000;
+				delta.nodes.push_back(node.data());
+			}
+			gapr::commit_info info{static_cast<gapr::commit_id::data_type>(id), "alice", 1600000000000+id*1000, nid0, static_cast<std::underlying_type_t<gapr::delta_type>>(gapr::delta_type::add_edge_)};
+			nid0+=delta.nodes.size();
+			std::ostringstream oss;
+			if(!info.save(*oss.rdbuf()) || !gapr::save(delta, *oss.rdbuf()))
+				gapr::report("failed to save");
+			std::array<char,32> fn_buf;
+			auto ofs=repo.get_writer(gapr::to_string_lex(fn_buf, id));
+			auto str=oss.str();
+			for(std::size_t i=0; i<str.size();) {
+				auto [buf, siz]=ofs.buffer();
+				auto n=std::min(siz, str.size()-i);
+				std::memcpy(buf, &str[i], n);
+				ofs.commit(n);
+				i+=n;
+			}
+			if(!ofs.flush())
+				gapr::report("failed to flush");
+		}
+	}
+	repo.end_buffered();
+
+	// decoding only, then decoding and applying
+	auto replay=[&repo](auto open, bool apply) {
+		gather_model model{};
+		uint64_t nnodes=0;
+		auto t0=std::chrono::steady_clock::now();
+		for(uint64_t id=0; id<ncommits; id++) {
+			std::array<char,32> fn_buf;
+			auto src=open(gapr::to_string_lex(fn_buf, id));
+			if(!src)
+				gapr::report("failed to open file");
+			auto& str=[&src]() ->auto& {
+				if constexpr(std::is_same_v<decltype(src), gapr::archive::view>)
+					return src;
+				else
+					return *src;
+			}();
+			gapr::commit_info info;
+			if(!info.load(str))
+				gapr::report("commit file no commit info");
+			if(apply) {
+				model.xxx_prepare(info, str);
+				model.xxx_apply();
+				continue;
+			}
+			gapr::delta_add_edge_ delta;
+			if(!gapr::load(delta, str))
+				gapr::report("failed to load delta");
+			nnodes+=delta.nodes.size();
+		}
+		auto t1=std::chrono::steady_clock::now();
+		return std::make_pair(std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count(), apply?model.peek_nodes().size():nnodes);
+	};
+	auto open_sbuf=[&repo](std::string_view key) {
+		return repo.reader_streambuf(key);
+	};
+	auto open_view=[&repo](std::string_view key) {
+		return repo.get_view(key);
+	};
+	int ret=0;
+	for(bool apply: {false, true}) {
+		auto [ms_a, n_a]=replay(open_sbuf, apply);
+		auto [ms_b, n_b]=replay(open_view, apply);
+		gapr::print(apply?"replay ":"decode ", ncommits, " commits, ", n_b, " nodes: streambuf ", ms_a, "ms, view ", ms_b, "ms");
+		if(n_a!=n_b)
+			ret=-1;
+	}
+	repo={};
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	return ret;
+} }
+
+/*! synthetic workload for bench_model_mix */
+struct model_mix {
+	const char* name;
+	uint64_t ncommits;
+	// relative weights of add_edge, add_prop, proofread and del_patch
+	std::array<unsigned int, 4> weights;
+	// side of the box new paths start in (um), smaller is denser
+	double extent;
+	// commits the client is behind, checked for collisions
+	unsigned int lag;
+};
+
+static int run_model_mix(const model_mix& mix) {
+	auto path=std::filesystem::temp_directory_path()/"gapr-bench-model-mix";
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+
+	std::vector<std::chrono::steady_clock::duration> lat;
+	lat.reserve(mix.ncommits);
+	uint64_t nrejected{0};
+	std::array<std::size_t, 3> sizes;
+	{
+		gather_model model{path.string()};
+		std::mt19937 rng{2024};
+		struct path_info {
+			std::vector<gapr::node_id> nodes;
+			std::vector<bool> has_prop;
+			unsigned int nprops{0};
+			bool proofread{false};
+		};
+		std::vector<path_info> paths;
+		gapr::commit_history hist;
+		// true if accepted
+		auto commit=[&](gapr::delta_type type, auto& delta, gapr::node_id& nid0) {
+			gapr::mem_file payload{serialize(delta)};
+			auto n=model.num_commits();
+			if(n>mix.lag)
+				hist.try_body_count(n-mix.lag);
+			auto t0=std::chrono::steady_clock::now();
+			{
+				gather_model::modifier modif{model, type, std::move(payload)};
+				if(modif.prepare()!=0)
+					gapr::report("failed to prepare");
+				nid0=gapr::node_id{std::get<0>(modif.apply("alice", hist))};
+			}
+			lat.push_back(std::chrono::steady_clock::now()-t0);
+			if(!nid0)
+				++nrejected;
+			return !!nid0;
+		};
+		auto wsum=mix.weights[0]+mix.weights[1]+mix.weights[2]+mix.weights[3];
+		for(uint64_t i=0; i<mix.ncommits; i++) {
+			auto w=rng()%wsum;
+			unsigned int op=0;
+			while(w>=mix.weights[op])
+				w-=mix.weights[op++];
+			// otherwise fall back to add_edge
+			path_info* pth{nullptr};
+			if(op!=0 && !paths.empty()) {
+				pth=&paths[rng()%paths.size()];
+				if((op==2 && pth->proofread) || (op==3 && pth->nprops>0))
+					pth=nullptr;
+			}
+			gapr::node_id nid0;
+			if(!pth) {
+				gapr::delta_add_edge_ delta{};
+				gapr::node_attr node{mix.extent*(rng()%1024)/1024, mix.extent*(rng()%1024)/1024, mix.extent*(rng()%1024)/1024};
+				for(auto n=2+rng()%30; n>0; n--) {
+					for(unsigned int k=0; k<3; k++)
+						node.ipos[k]+=static_cast<int32_t>(rng()%2049)-1024;
+					delta.nodes.push_back(node.data());
+				}
+				if(commit(gapr::delta_type::add_edge_, delta, nid0)) {
+					auto& p=paths.emplace_back();
+					for(std::size_t k=0; k<delta.nodes.size(); k++)
+						p.nodes.push_back(nid0.offset(k));
+					p.has_prop.resize(p.nodes.size(), false);
+				}
+			} else if(op==1) {
+				auto k=rng()%pth->nodes.size();
+				if(pth->has_prop[k])
+					continue;
+				gapr::delta_add_prop_ delta;
+				delta.link=gapr::link_id{pth->nodes[k], {}}.data();
+				delta.node=gapr::node_attr{}.data();
+				delta.prop=rng()%2?"error=":"state=end";
+				if(commit(gapr::delta_type::add_prop_, delta, nid0)) {
+					pth->has_prop[k]=true;
+					++pth->nprops;
+				}
+			} else if(op==2) {
+				gapr::delta_proofread_ delta;
+				for(auto id: pth->nodes)
+					delta.nodes.push_back(id.data);
+				if(commit(gapr::delta_type::proofread_, delta, nid0))
+					pth->proofread=true;
+			} else {
+				// the whole path, ends included
+				gapr::delta_del_patch_ delta;
+				delta.nodes.push_back(pth->nodes.front().data);
+				for(auto id: pth->nodes)
+					delta.nodes.push_back(id.data);
+				delta.nodes.push_back(pth->nodes.back().data);
+				if(commit(gapr::delta_type::del_patch_, delta, nid0)) {
+					*pth=std::move(paths.back());
+					paths.pop_back();
+				}
+			}
+		}
+		sizes={model.peek_nodes().size(), model.peek_links().size(), model.peek_props().size()};
+	}
+#ifdef __GLIBC__
+	malloc_trim(0);
+#endif
+
+	auto mem0=gapr::mem_usage();
+	auto t0=std::chrono::steady_clock::now();
+	gather_model model{path.string()};
+	auto t1=std::chrono::steady_clock::now();
+	auto mem1=gapr::mem_usage();
+	int ret=0;
+	if(sizes!=std::array<std::size_t, 3>{model.peek_nodes().size(), model.peek_links().size(), model.peek_props().size()}) {
+		gapr::print("replay mismatch: ", mix.name);
+		ret=-1;
+	}
+
+	std::sort(lat.begin(), lat.end());
+	auto pct=[&lat](unsigned int p) {
+		auto i=(lat.size()-1)*p/100;
+		return std::chrono::duration_cast<std::chrono::microseconds>(lat[i]).count();
+	};
+	gapr::print(mix.name, ": ", lat.size(), " commits (", nrejected, " rejected), ",
+			sizes[0], " nodes, ", sizes[1], " links, ", sizes[2], " props");
+	gapr::print("  apply us: p50 ", pct(50), ", p90 ", pct(90), ", p99 ", pct(99), ", max ", pct(100));
+	gapr::print("  replay ", std::chrono::duration_cast<std::chrono::milliseconds>(t1-t0).count(), "ms, rss +",
+			mem1.first-std::min(mem0.first, mem1.first), "KiB, peak ", mem1.second, "KiB");
+	std::filesystem::remove(path);
+	std::filesystem::remove(path.string()+"-lock");
+	return ret;
+}
+
+namespace gapr_test { int bench_model_mix() {
+	const model_mix mixes[]={
+		{"edges", 50'000, {1, 0, 0, 0}, 2000, 0},
+		{"mixed", 50'000, {4, 2, 3, 1}, 2000, 0},
+		{"dense", 50'000, {4, 2, 3, 1}, 50, 16},
+	};
+	int ret=0;
+	for(auto& mix: mixes) {
+		if(run_model_mix(mix)!=0)
+			ret=-1;
+	}
+	return ret;
+} }
@@ -9,6 +9,7 @@
 #include <mutex>
 #include <atomic>
 #include <memory>
+#include <functional>
 #include <unordered_map>
 
 
@@ -33,11 +34,15 @@ class gather_model {
 
 		std::string get_stats(uint64_t from) const;
 		std::string get_proofread_stats(gapr::commit_id from, gapr::commit_id to) const;
+		// for the two above; post() runs helpers elsewhere, the caller always joins in.
+		// their caches are also caught up with post(), now and after each commit.
+		void scan_workers(unsigned int n, std::function<void(std::function<void()>&&)> post);
 		void update_stats(void* prev, uint32_t& nn, uint32_t& nnr, uint32_t& nt, uint32_t& ntr, uint64_t& nc) const;
 
 		// XXX
 		explicit gather_model();
 		void xxx_prepare(const gapr::commit_info& info, std::streambuf& buf);
+		void xxx_prepare(const gapr::commit_info& info, gapr::archive::view& view);
 		void xxx_apply();
 		void peek_nodes_mod(std::vector<std::tuple<gapr::node_id, gapr::node_attr, int>>& out) const;
 		void peek_links_mod(std::vector<std::tuple<gapr::node_id, gapr::node_id, int>>& out) const;
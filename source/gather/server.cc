@@ -58,6 +58,7 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/asio/thread_pool.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <boost/beast/http.hpp>
 
@@ -228,6 +229,19 @@ inline static bool parse_http_args(std::string_view args, Req& req, Reqs&... req
 static constexpr unsigned char priv_proto[]={
 	'g', 'a', 'p', 'r', '/', '1', '.', '1'
 };
+// same messages, larger chunks
+static constexpr unsigned char priv_proto2[]={
+	'g', 'a', 'p', 'r', '/', '1', '.', '2'
+};
+// also concurrent requests
+static constexpr unsigned char priv_proto3[]={
+	'g', 'a', 'p', 'r', '/', '1', '.', '3'
+};
+static bool is_priv_proto(const unsigned char* p, unsigned int l) noexcept {
+	return std::equal(p, p+l, priv_proto, &priv_proto[sizeof(priv_proto)])
+		|| std::equal(p, p+l, priv_proto2, &priv_proto2[sizeof(priv_proto2)])
+		|| std::equal(p, p+l, priv_proto3, &priv_proto3[sizeof(priv_proto3)]);
+}
 static constexpr unsigned char http11_proto[]={
 	'h', 't', 't', 'p', '/', '1', '.', '1'
 };
@@ -235,7 +249,7 @@ static int alpn_select_cb(SSL* ssl, const unsigned char** out, unsigned char* ou
 	for(unsigned int i=0; i<inlen;) {
 		unsigned char l=in[i];
 		auto p=&in[i+1];
-		if(std::equal(p, p+l, priv_proto, &priv_proto[sizeof(priv_proto)])) {
+		if(is_priv_proto(p, l)) {
 			*out=p;
 			*outlen=l;
 			return SSL_TLSEXT_ERR_OK;
@@ -1074,6 +1088,8 @@ struct gapr::gather_server::PRIV {
 			conn.next=std::move(it->second.first);
 		}
 		it->second.first=conn.shared_from_this();
+		if(ins)
+			pending_wake(proj);
 	}
 	void pending_data_schedule(const std::string& proj, const std::string& path) {
 		auto [it, ins]=_pending_data_reqs.try_emplace({proj, path});
@@ -1081,7 +1097,41 @@ struct gapr::gather_server::PRIV {
 			it->second.second=++_pending_data_seq;
 			assert(!it->second.first);
 			it->second.first={};
+			pending_wake(proj);
+		}
+	}
+
+	// "pending" requests held until there are newer jobs, or their timers expire
+	std::unordered_map<std::string, std::vector<std::shared_ptr<boost::asio::steady_timer>>> _pending_waits;
+	bool pending_data_newer(const std::string& proj, uint64_t ts_sync) const {
+		for(auto& [key, val]: _pending_data_reqs) {
+			if(key.first==proj && val.second>ts_sync)
+				return true;
 		}
+		return false;
+	}
+	void pending_wait(const std::string& proj, uint64_t ts_sync, unsigned int wait, HttpConnection& conn) {
+		auto timer=std::make_shared<boost::asio::steady_timer>(_io_ctx);
+		timer->expires_after(std::chrono::seconds{wait});
+		_pending_waits[proj].push_back(timer);
+		timer->async_wait([this,timer,proj,ts_sync,wait,conn=conn.shared_from_this()](bs_error_code ec) {
+			if(auto it=_pending_waits.find(proj); it!=_pending_waits.end()) {
+				auto& timers=it->second;
+				timers.erase(std::remove(timers.begin(), timers.end(), timer), timers.end());
+				if(timers.empty())
+					_pending_waits.erase(it);
+			}
+			write_response(*conn, pending_response(conn->parser->get(), proj, ts_sync, wait));
+		});
+	}
+	void pending_wake(const std::string& proj) {
+		auto it=_pending_waits.find(proj);
+		if(it==_pending_waits.end())
+			return;
+		auto timers=std::move(it->second);
+		_pending_waits.erase(it);
+		for(auto& timer: timers)
+			timer->cancel();
 	}
 	
 	void pending_data_get(const std::string& proj, std::ostream& str, uint64_t ts_sync) {
@@ -1285,20 +1335,37 @@ struct gapr::gather_server::PRIV {
 			return http_server_err(req);
 		}
 
-		std::string err{};
-		std::ostringstream str;
+		// long poll, with the number of seconds the client will wait
+		unsigned int wait{0};
+		if(auto it=req.find("GaprWait"); it!=req.end()) {
+			auto val=it->value();
+			auto [eptr, ec]=std::from_chars(val.data(), val.data()+val.size(), wait, 10);
+			if(ec!=std::errc{} || eptr!=val.data()+val.size())
+				return http_bad_request(req);
+			wait=std::min(wait, 60u);
+		}
+
 		assert(_io_ctx.get_executor().running_in_this_thread());
-		try {
-			// logMessage(__FILE__, "Processing pending data for project: " + proj + " with ts_sync: " + std::to_string(ts_sync));
+		// logMessage(__FILE__, "Processing pending data for project: " + proj + " with ts_sync: " + std::to_string(ts_sync));
 
-			// Log before attempting to update _models
-			//logMessage(__FILE__, "Attempting to update pending timestamp for project: " + proj);
+		// Log before attempting to update _models
+		//logMessage(__FILE__, "Attempting to update pending timestamp for project: " + proj);
 
-			std::shared_ptr<gather_model> model = std::make_shared<gather_model>();
-			_models[proj] = ModelState(std::move(model));
-			_models[proj].pending_ts = std::chrono::steady_clock::now();
-			//logMessage(__FILE__, "Project successfully added to _models: " + proj);
+		std::shared_ptr<gather_model> model = std::make_shared<gather_model>();
+		_models[proj] = ModelState(std::move(model));
+		_models[proj].pending_ts = std::chrono::steady_clock::now();
+		//logMessage(__FILE__, "Project successfully added to _models: " + proj);
 
+		if(wait>0 && !pending_data_newer(proj, ts_sync)) {
+			pending_wait(proj, ts_sync, wait, conn);
+			return {};
+		}
+		return pending_response(req, proj, ts_sync, wait);
+	}
+	HttpResponsePtr pending_response(HttpRequest& req, const std::string& proj, uint64_t ts_sync, unsigned int wait) {
+		std::string err{};
+		std::ostringstream str;
+		try {
 			_models.at(proj).pending_ts = std::chrono::steady_clock::now();
 
 			// Log before calling pending_data_get
@@ -1320,6 +1387,8 @@ struct gapr::gather_server::PRIV {
 		http::response<http::string_body> res{err.empty()?http::status::ok:http::status::internal_server_error, req.version()};
 		res.set(http::field::server, _env->http_server());
 		res.set(http::field::content_type, "application/json");
+		if(wait>0)
+			res.set("GaprWait", std::to_string(wait));
 		res.keep_alive(req.keep_alive());
 		res.body()=err.empty()?str.str():err;
 		res.prepare_payload();
@@ -2045,9 +2114,12 @@ void gapr::gather_server::PRIV::load_project(std::string&& proj) {
 	gapr::promise<std::shared_ptr<gather_model>> prom;
 	auto fut=prom.get_future();
 	auto repo=_env->project_repo(proj);
-	ba::post(_thr_pool, [prom=std::move(prom),repo]() mutable {
+	ba::post(_thr_pool, [this,prom=std::move(prom),repo]() mutable {
 		try {
 			auto m=std::make_shared<gather_model>(std::move(repo));
+			m->scan_workers(std::thread::hardware_concurrency(), [ex=_thr_pool.get_executor()](std::function<void()>&& f) {
+				ba::post(ex, std::move(f));
+			});
 			return std::move(prom).set(std::move(m));
 		} catch(const std::bad_alloc& e) {
 			// XXX handle oom
@@ -2137,7 +2209,7 @@ void gapr::gather_server::PRIV::do_handshake(tcp::socket&& sock) {
             auto& ssl = *conn->ssl;
             ::SSL_get0_alpn_selected(ssl.native_handle(), &alpn_str, &alpn_len);
 
-            if (alpn_str && std::equal(alpn_str, alpn_str + alpn_len, &priv_proto[0], &priv_proto[sizeof(priv_proto)])) {
+            if (alpn_str && is_priv_proto(alpn_str, alpn_len)) {
                 logMessage(__FILE__, "ALPN protocol matched, creating session.");
                 auto ses = std::make_shared<Session>();
                 std::shared_ptr<ssl::stream<tcp::socket>> ssl2{conn, &ssl};
@@ -2159,6 +2231,7 @@ void gapr::gather_server::PRIV::recv_request(Session& ses, gapr::server_end&& ms
 					gapr::print("recv err: ", ec.message());
 					return;
 				}
+				auto req=msg.fork();
 				recv_request(*ses, gapr::server_end{msg});
 
 				std::string cmdstr{};
@@ -2174,10 +2247,10 @@ void gapr::gather_server::PRIV::recv_request(Session& ses, gapr::server_end&& ms
 
 				auto it=_str2command.find(cmdstr);
 				if(it==_str2command.end())
-					return handle_message_simple(std::move(msg),
+					return handle_message_simple(std::move(req),
 							"ERR", "Unknown command.");
 
-				return (this->*(it->second))(*ses, hdr, std::move(msg));
+				return (this->*(it->second))(*ses, hdr, std::move(req));
 			});
 }
 
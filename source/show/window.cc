@@ -20,7 +20,9 @@
 #include <fstream>
 #include <cmath>
 #include <algorithm>
+#include <cstring>
 #include <deque>
+#include <thread>
 
 #include <boost/asio/post.hpp>
 
@@ -559,18 +561,16 @@ struct gapr::show::Session::playback_helper {
 		std::unordered_set<std::string> users;
 		while(true) {
 			std::array<char,32> fn_buf;
-			auto sbuf=_repo.reader_streambuf(to_string_lex(fn_buf, _infos.size()));
-			if(!sbuf)
+			auto view=_repo.get_view(to_string_lex(fn_buf, _infos.size()));
+			if(!view)
 				break;
-			if(!sbuf)
-				gapr::report("failed to open file");
 			CommitInfo info;
-			if(!info.load(*sbuf))
+			if(!info.load(view))
 				gapr::report("commit file no commit info");
 			if(info.id!=_infos.size())
 				gapr::report("commit file wrong id");
 			users.insert(info.who);
-			_model->xxx_prepare(info, *sbuf);
+			_model->xxx_prepare(info, view);
 			_model->peek_props_mod(info.props_mod);
 			_model->peek_bbox(info.bbox);
 			_model->xxx_apply();
@@ -954,14 +954,14 @@ struct lua_base {
 };
 
 
-struct gapr::show::Session::script_helper: lua_base {
-	static auto load_mesh(const std::filesystem::path& fn) {
+namespace {
+	/*! OBJ meshes, triangles only */
+	template<typename Vert>
+	void parse_mesh(const std::filesystem::path& fn, std::vector<Vert>& meshVerts, std::vector<GLuint>& meshIdxes) {
 		std::ifstream f{fn};
 		if(!f)
 			throw std::runtime_error{"Failed to open"};
 
-		std::vector<MeshVert> meshVerts;
-		std::vector<GLuint> meshIdxes;
 		std::string line;
 		std::vector<gapr::vec3<double>> vertNormals;
 		while(std::getline(f, line)) {
@@ -1124,6 +1124,103 @@ struct gapr::show::Session::script_helper: lua_base {
 		   meshIdxes.push_back(2);
 		   meshIdxes.push_back(1);
 		   */
+	}
+
+	/*! binary mesh cache, buffers as uploaded to GL.
+	 * in host byte order, it never leaves the machine.
+	 */
+	struct mesh_cache_header {
+		char magic[8];
+		uint64_t src_size;
+		int64_t src_mtime;
+		uint64_t nverts;
+		uint64_t nidxes;
+	};
+	constexpr char mesh_cache_magic[8]={'G', 'A', 'P', 'R', 'M', 'S', 'H', '1'};
+
+	/*! keyed by path, the header has to match mtime and size */
+	std::filesystem::path mesh_cache_path(const std::filesystem::path& fn, mesh_cache_header& key) {
+		std::error_code ec;
+		auto abs=std::filesystem::absolute(fn, ec);
+		if(ec)
+			return {};
+		auto size=std::filesystem::file_size(abs, ec);
+		if(ec)
+			return {};
+		auto mtime=std::filesystem::last_write_time(abs, ec);
+		if(ec)
+			return {};
+		std::memcpy(key.magic, mesh_cache_magic, sizeof key.magic);
+		key.src_size=size;
+		key.src_mtime=mtime.time_since_epoch().count();
+		try {
+			return gapr::get_cachepath("mesh:"+abs.string());
+		} catch(const std::exception& e) {
+			gapr::print("no mesh cache: ", e.what());
+			return {};
+		}
+	}
+	template<typename Vert>
+	bool load_mesh_cache(const std::filesystem::path& path, const mesh_cache_header& key, std::vector<Vert>& verts, std::vector<GLuint>& idxes) {
+		static_assert(std::is_trivially_copyable_v<Vert>);
+		std::ifstream f{path, std::ios::binary};
+		if(!f)
+			return false;
+		mesh_cache_header hdr;
+		if(!f.read(reinterpret_cast<char*>(&hdr), sizeof hdr))
+			return false;
+		if(std::memcmp(hdr.magic, key.magic, sizeof hdr.magic)!=0
+				|| hdr.src_size!=key.src_size || hdr.src_mtime!=key.src_mtime)
+			return false;
+		std::error_code ec;
+		auto size=std::filesystem::file_size(path, ec);
+		if(ec || size!=sizeof hdr+hdr.nverts*sizeof(Vert)+hdr.nidxes*sizeof(GLuint))
+			return false;
+		verts.resize(hdr.nverts);
+		idxes.resize(hdr.nidxes);
+		f.read(reinterpret_cast<char*>(verts.data()), verts.size()*sizeof(Vert));
+		f.read(reinterpret_cast<char*>(idxes.data()), idxes.size()*sizeof(GLuint));
+		if(!f) {
+			verts.clear();
+			idxes.clear();
+			return false;
+		}
+		return true;
+	}
+	template<typename Vert>
+	void save_mesh_cache(const std::filesystem::path& path, const mesh_cache_header& key, const std::vector<Vert>& verts, const std::vector<GLuint>& idxes) {
+		auto hdr=key;
+		hdr.nverts=verts.size();
+		hdr.nidxes=idxes.size();
+		auto tmp=path;
+		tmp+=".tmp";
+		std::ofstream f{tmp, std::ios::binary};
+		f.write(reinterpret_cast<const char*>(&hdr), sizeof hdr);
+		f.write(reinterpret_cast<const char*>(verts.data()), verts.size()*sizeof(Vert));
+		f.write(reinterpret_cast<const char*>(idxes.data()), idxes.size()*sizeof(GLuint));
+		f.close();
+		std::error_code ec;
+		if(!f) {
+			std::filesystem::remove(tmp, ec);
+			return;
+		}
+		std::filesystem::rename(tmp, path, ec);
+	}
+}
+
+struct gapr::show::Session::script_helper: lua_base {
+	static auto load_mesh(const std::filesystem::path& fn) {
+		std::vector<MeshVert> meshVerts;
+		std::vector<GLuint> meshIdxes;
+		mesh_cache_header key;
+		auto cache=mesh_cache_path(fn, key);
+		if(!cache.empty() && load_mesh_cache(cache, key, meshVerts, meshIdxes)) {
+			gapr::print("nv: ", meshVerts.size(), "; ni: ", meshIdxes.size(), " (cached)");
+			return std::make_pair(std::move(meshVerts), std::move(meshIdxes));
+		}
+		parse_mesh(fn, meshVerts, meshIdxes);
+		if(!cache.empty())
+			save_mesh_cache(cache, key, meshVerts, meshIdxes);
 		return std::make_pair(std::move(meshVerts), std::move(meshIdxes));
 	}
 
@@ -3450,7 +3547,7 @@ void gapr::show::Session::load_data_swc() {
 			filter.push(boost::iostreams::gzip_decompressor{});
 		filter.push(fs);
 
-		gapr::swc_input swc{filter};
+		gapr::swc_input swc{filter, std::thread::hardware_concurrency()};
 		while(swc.read()) {
 			switch(swc.tag()) {
 				case swc_input::tags::comment:
@@ -4220,4 +4317,65 @@ void gapr::show::Session::locate_camera(MainWindow* win) {
 	update(win);
 }
 
+/*! text parse vs. cache load, on a multi-million-triangle mesh */
+namespace gapr_test { int bench_mesh_cache() {
+	struct Vert {
+		std::array<GLint, 3> ipos;
+		gapr::gl::Packed<GLuint, GL_INT_2_10_10_10_REV> norm;
+	};
+	std::error_code ec;
+	auto dir=std::filesystem::temp_directory_path(ec)/"gapr-bench-mesh";
+	if(ec)
+		return -1;
+	std::filesystem::create_directories(dir);
+	auto obj=dir/"grid.obj";
+	auto cache=dir/"grid.cache";
+	{
+		// a wavy sheet, 2 triangles per grid cell
+		constexpr unsigned int n=1100;
+		std::ofstream f{obj};
+		for(unsigned int j=0; j<n; j++)
+			for(unsigned int i=0; i<n; i++)
+				f<<"v "<<i*0.5<<' '<<j*0.5<<' '<<std::sin(i*0.01)*std::cos(j*0.013)*40<<'\n';
+		// the parser takes normals as given
+		for(unsigned int j=0; j<n; j++)
+			for(unsigned int i=0; i<n; i++)
+				f<<"vn "<<-std::cos(i*0.01)*std::cos(j*0.013)*0.8<<' '<<std::sin(i*0.01)*std::sin(j*0.013)*1.04<<" 1\n";
+		for(unsigned int j=0; j+1<n; j++) {
+			for(unsigned int i=0; i+1<n; i++) {
+				auto a=j*n+i+1;
+				f<<"f "<<a<<' '<<a+1<<' '<<a+n<<'\n';
+				f<<"f "<<a+1<<' '<<a+n+1<<' '<<a+n<<'\n';
+			}
+		}
+		if(!f)
+			return -1;
+	}
+	mesh_cache_header key;
+	if(mesh_cache_path(obj, key).empty())
+		return -1;
+
+	std::vector<Vert> verts, verts2;
+	std::vector<GLuint> idxes, idxes2;
+	auto t0=std::chrono::steady_clock::now();
+	parse_mesh(obj, verts, idxes);
+	auto t1=std::chrono::steady_clock::now();
+	save_mesh_cache(cache, key, verts, idxes);
+	auto t2=std::chrono::steady_clock::now();
+	if(!load_mesh_cache(cache, key, verts2, idxes2))
+		return -1;
+	auto t3=std::chrono::steady_clock::now();
+	auto ms=[](auto dt) { return std::chrono::duration_cast<std::chrono::milliseconds>(dt).count(); };
+	gapr::print("mesh, ", verts.size(), " vertices, ", idxes.size()/3, " triangles: parse ", ms(t1-t0),
+			"ms, save ", ms(t2-t1), "ms, load ", ms(t3-t2), "ms");
+
+	bool same=idxes==idxes2 && verts.size()==verts2.size()
+		&& std::memcmp(verts.data(), verts2.data(), verts.size()*sizeof(Vert))==0;
+	// stale once the source changes
+	key.src_size++;
+	bool stale=!load_mesh_cache(cache, key, verts2, idxes2);
+	std::filesystem::remove_all(dir, ec);
+	return same && stale ? 0 : -1;
+} }
+
 #include "gapr/gui/opengl-impl.hh"
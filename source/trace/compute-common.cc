@@ -70,11 +70,15 @@ void gapr::trace::EvaluateAlg::Job::operator()(gapr::trace::EvaluateAlg& alg) {
 }
 
 void gapr::trace::ConnectAlg::Job::operator()(gapr::trace::ConnectAlg& alg) {
+	auto t0=std::chrono::steady_clock::now();
 	alg.impl(*this);
+	auto t1=std::chrono::steady_clock::now();
+	dt_connect=t1-t0;
 	if(alg._evaluator) {
 		EvaluateHelper helper{*alg._evaluator, alg._xform, alg._graph, alg._dirty, cube, offset};
 		helper.args.cancel=cancel;
 		delta2=helper.evaluate(&delta);
+		dt_evaluate=std::chrono::steady_clock::now()-t1;
 	}
 	std::sort(delta.props.begin(), delta.props.end(), [](auto& a, auto& b) {
 		if(a.first<b.first)
@@ -4,6 +4,12 @@
 
 #include "gapr/utility.hh"
 
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <thread>
+
 extern "C" {
 #include "tz_local_neuroseg.h"
 #include "tz_trace_utils.h"
@@ -218,6 +224,33 @@ void gapr::trace::ProbeAlg::Job::operator()(gapr::trace::ProbeAlg& alg) {
 	}
 }
 
+struct DisjointSets {
+	std::vector<std::size_t> parent;
+	explicit DisjointSets(std::size_t n): parent(n) {
+		std::iota(parent.begin(), parent.end(), 0);
+	}
+	std::size_t find(std::size_t i) noexcept {
+		while(parent[i]!=i)
+			i=parent[i]=parent[parent[i]];
+		return i;
+	}
+	bool unite(std::size_t a, std::size_t b) noexcept {
+		a=find(a);
+		b=find(b);
+		if(a==b)
+			return false;
+		if(b<a)
+			std::swap(a, b);
+		parent[b]=a;
+		return true;
+	}
+};
+static uint64_t cell_key(int x, int y, int z) noexcept {
+	// biased, so that slightly negative positions still fit
+	auto k=[](int v) { return uint64_t(v+2)&((uint64_t{1}<<21)-1); };
+	return (k(x)<<42)|(k(y)<<21)|k(z);
+}
+
 struct NeutubeHelper {
 
 	struct Seed {
@@ -351,9 +384,18 @@ struct NeutubeHelper {
 
 	Stack _stack;
 	std::shared_ptr<Stack> _stack_ptr;
-	TraceWorkspacePtr _trace_workspace;
-	Locseg_Fit_Workspace* _fit_workspace;
-	Stack* _stack_lbl;
+	struct Workspace {
+		TraceWorkspacePtr trace;
+		Locseg_Fit_Workspace* fit;
+		Stack* lbl;
+	};
+	Workspace _ws;
+	// overrides _ws while a seed worker runs on this thread
+	static thread_local Workspace* _ws_local;
+	Workspace& ws() noexcept { return _ws_local?*_ws_local:_ws; }
+
+	unsigned int _nworkers{1};
+	std::function<void(std::function<void()>&&)> _post;
 
 	std::vector<Chain> _existing_chains;
 	std::vector<Chain> _fresh_chains;
@@ -640,20 +682,29 @@ struct NeutubeHelper {
 		_existing_chains.push_back(chain);
 	}
 	void add_fresh_chain(ChainPtr c, const Seed& seed) {
-		auto all_masked=check_all_masked(c);
 		Chain chain;
+		auto all_masked=prepare_fresh_chain(c, seed, chain);
+		commit_fresh_chain(std::move(chain), all_masked);
+	}
+	// only reads the mask, so it can run against a worker's copy
+	bool prepare_fresh_chain(ChainPtr c, const Seed& seed, Chain& chain) {
+		auto all_masked=check_all_masked(c);
 		chain.chain=c;
 		chain.seed=seed;
 		chain.eid=0;
 		chain.len=Locseg_Chain_Length(c.get());
 		gapr::print(1, "seed: ", seed.nid.data, " ", seed.pos[0],'/', seed.pos[1],'/', seed.pos[2]);
 		link_seed(chain);
+		return all_masked;
+	}
+	void commit_fresh_chain(Chain&& chain, bool all_masked) {
+		auto c=chain.chain;
 		update_mask(c);
 		if(all_masked)
 			return;
 		if(Locseg_Chain_Length(c.get())<=3)
 			return;
-		_fresh_chains.push_back(chain);
+		_fresh_chains.push_back(std::move(chain));
 	}
 
 	void process_edges() {
@@ -685,7 +736,7 @@ struct NeutubeHelper {
 					chain=wrap(New_Locseg_Chain());
 					start_i=i;
 				}
-				Local_Neuroseg_Label_G(seg.get(), _stack_lbl, 0, 1, _z_scale);
+				Local_Neuroseg_Label_G(seg.get(), ws().lbl, 0, 1, _z_scale);
 
 				auto tr=New_Trace_Record();
 				tr->mask=ZERO_BIT_MASK;
@@ -700,7 +751,7 @@ struct NeutubeHelper {
 
 	void update_mask(ChainPtr chain) {
 		auto n=Locseg_Chain_Length(chain.get());
-		Locseg_Chain_Label_G(chain.get(), _stack_lbl, _z_scale, 0, n, 1.5, 0.0, 0, 1);
+		Locseg_Chain_Label_G(chain.get(), ws().lbl, _z_scale, 0, n, 1.5, 0.0, 0, 1);
 	}
 
 	template<unsigned int npix>
@@ -729,7 +780,7 @@ struct NeutubeHelper {
 		if(check_boundary(pos))
 			return true;
 
-		if(*STACK_PIXEL_8(_stack_lbl, x, y, z, 0) > 0) {
+		if(*STACK_PIXEL_8(ws().lbl, x, y, z, 0) > 0) {
 			return true;
 		}
 		return false;
@@ -758,7 +809,7 @@ struct NeutubeHelper {
 		constexpr double seed_min_score=0.35;
 		Stack_Fit_Score fs;
 		fs.n=1;
-		fs.options[0]=_trace_workspace->tscore_option;
+		fs.options[0]=ws().trace->tscore_option;
 		auto s=Local_Neuroseg_Score(locseg, &_stack, _z_scale, &fs);
 		gapr::print("score: ", s);
 		if(s<seed_min_score)
@@ -767,6 +818,9 @@ struct NeutubeHelper {
 	}
 
 	void get_workspace() {
+		_ws=make_workspace(nullptr);
+	}
+	Workspace make_workspace(const Stack* lbl) {
 		auto tspace=wrap(Locseg_Chain_Default_Trace_Workspace(nullptr, &_stack));
 		if(!tspace->fit_workspace) {
 			tspace->fit_workspace=New_Locseg_Fit_Workspace();
@@ -786,14 +840,25 @@ struct NeutubeHelper {
 		tspace->trace_range[2]=0;
 		tspace->trace_range[5]=_cuberef.sizes[2]-1;
 
-		_stack_lbl=tspace->trace_mask=Make_Stack(GREY8, _stack.width, _stack.height, _stack.depth);
-		Zero_Stack(_stack_lbl);
+		if(lbl) {
+			// borrowed (read only), detached before the workspace is killed
+			tspace->trace_mask=const_cast<Stack*>(lbl);
+			tspace=TraceWorkspacePtr{tspace.get(), [tspace,lbl](Trace_Workspace* ws) mutable {
+				if(ws->trace_mask==lbl)
+					ws->trace_mask=nullptr;
+				tspace.reset();
+			}};
+		} else {
+			tspace->trace_mask=Make_Stack(GREY8, _stack.width, _stack.height, _stack.depth);
+			Zero_Stack(tspace->trace_mask);
+		}
 
 		tspace->min_score=0.3;
 		tspace->tscore_option=STACK_FIT_CORRCOEF;
 
-		_trace_workspace=tspace;
-		_fit_workspace=(Locseg_Fit_Workspace*)tspace->fit_workspace;
+		auto fit=(Locseg_Fit_Workspace*)tspace->fit_workspace;
+		auto mask=tspace->trace_mask;
+		return Workspace{std::move(tspace), fit, mask};
 	}
 
 	void prepare_stack() {
@@ -849,7 +914,7 @@ struct NeutubeHelper {
 		double r=3.0, c=0.0, h=11.0, theta=M_PI/4, psi=0*M_PI/2, curv=0, alpha=0, scale=1;
 		Set_Neuroseg(&(locseg->seg), r, c, h, theta, psi, curv, alpha, scale);
 		Set_Neuroseg_Position(locseg.get(), &pos[0], NEUROSEG_CENTER);
-		Local_Neuroseg_Optimize_W(locseg.get(), &_stack, _z_scale, 1, _fit_workspace);
+		Local_Neuroseg_Optimize_W(locseg.get(), &_stack, _z_scale, 1, ws().fit);
 		r=locseg->seg.r1;
 		c=locseg->seg.c;
 		h=locseg->seg.h;
@@ -863,7 +928,7 @@ struct NeutubeHelper {
 	NeurosegPtr optimize_fixed_pos(const std::array<double, 3>& pos, const Local_Neuroseg* ref) {
 		NeurosegPtr locseg{Copy_Local_Neuroseg(ref)};
 		Set_Neuroseg_Position(locseg.get(), &pos[0], NEUROSEG_CENTER);
-		Fit_Local_Neuroseg_W(locseg.get(), &_stack, _z_scale, _fit_workspace);
+		Fit_Local_Neuroseg_W(locseg.get(), &_stack, _z_scale, ws().fit);
 		return locseg;
 	}
 	NeurosegPtr optimize_fixed_pos(const std::array<double, 3>& pos) {
@@ -878,7 +943,7 @@ struct NeutubeHelper {
 			Local_Neuroseg_Orientation_Search_C(locseg.get(), &_stack, _z_scale, &fs); 
 			Local_Neuroseg_R_Scale_Search(locseg.get(), &_stack, _z_scale, 1.0, 10.0, 1.0,
 					0.5, 5.0, 0.5, NULL);
-			Fit_Local_Neuroseg_W(locseg.get(), &_stack, _z_scale, _fit_workspace);
+			Fit_Local_Neuroseg_W(locseg.get(), &_stack, _z_scale, ws().fit);
 		}
 		r=locseg->seg.r1;
 		c=locseg->seg.c;
@@ -898,19 +963,118 @@ struct NeutubeHelper {
 		Trace_Record_Set_Direction(tr, DL_BOTHDIR);
 		auto p=Make_Locseg_Node(locseg.release(), tr);
 		auto locseg_chain=wrap(Make_Locseg_Chain(p));
-		_trace_workspace->trace_status[0]=TRACE_NORMAL;
-		_trace_workspace->trace_status[1]=TRACE_NORMAL;
-		Trace_Locseg(&_stack, _z_scale, locseg_chain.get(), _trace_workspace.get());
+		auto& tw=ws().trace;
+		tw->trace_status[0]=TRACE_NORMAL;
+		tw->trace_status[1]=TRACE_NORMAL;
+		Trace_Locseg(&_stack, _z_scale, locseg_chain.get(), tw.get());
 		Locseg_Chain_Remove_Overlap_Ends(locseg_chain.get());
 		Locseg_Chain_Remove_Turn_Ends(locseg_chain.get(), 1.0);
-		printf("status0 %d\n", _trace_workspace->trace_status[0]);
-		printf("status1 %d\n", _trace_workspace->trace_status[1]);
+		printf("status0 %d\n", tw->trace_status[0]);
+		printf("status1 %d\n", tw->trace_status[1]);
 		return locseg_chain;
 	}
 
 	gapr::delta_add_patch_ debug_ds_seeds();
 	gapr::delta_add_patch_ debug_cube_seeds();
 	gapr::delta_add_patch_ compute();
+
+	/*! parallel seed tracing:
+	 * seeds are split into groups of (26-)connected cells of seed_sep,
+	 * each group is traced on a private copy of the mask, and the
+	 * results are committed in seed order.  groups whose footprints
+	 * (every voxel read or labeled while tracing) overlap are merged
+	 * and traced again, so the outcome matches the serial pass.
+	 */
+	static constexpr int seed_sep=32;
+	static constexpr int footprint_cell=16;
+	// bounds the private masks, each the size of the cube
+	static constexpr unsigned int max_seed_workers=8;
+	static constexpr std::size_t seed_mask_budget=512*1024*1024;
+	struct Box {
+		std::array<int, 3> p0, p1;
+	};
+	struct SeedTrace {
+		enum Kind {
+			SKIP,
+			RETRY,
+			FRESH
+		} kind{SKIP};
+		ChainPtr chain;
+		Chain fresh;
+		bool all_masked;
+	};
+	struct SeedGroup {
+		std::vector<std::size_t> seeds;
+		std::vector<Seed> out;
+		std::vector<std::pair<std::size_t, SeedTrace>> traced;
+		std::vector<Box> boxes;
+	};
+	void trace_seed(Seed& seed, SeedTrace& res, std::vector<Box>* boxes);
+	void apply_seed(const Seed& seed, SeedTrace&& res, std::vector<std::pair<ChainPtr, Seed>>& seeds_retry);
+	bool trace_seeds_parallel(std::vector<Seed>& seeds, std::vector<std::pair<ChainPtr, Seed>>& seeds_retry);
+	std::vector<SeedGroup> partition_seeds(const std::vector<Seed>& seeds);
+	void trace_groups(std::vector<SeedGroup>& groups, const std::vector<std::size_t>& todo, const std::vector<Seed>& seeds);
+	void trace_group(SeedGroup& grp, const std::vector<Seed>& seeds);
+	std::vector<std::size_t> merge_conflicts(std::vector<SeedGroup>& groups);
+
+	Box make_box(std::array<double, 3> lo, std::array<double, 3> hi) {
+		std::array<int, 3> lim{_stack.width, _stack.height, _stack.depth};
+		lo[2]*=_z_scale;
+		hi[2]*=_z_scale;
+		Box b;
+		for(unsigned int i=0; i<3; i++) {
+			b.p0[i]=std::clamp(static_cast<int>(std::floor(lo[i])), 0, lim[i]-1);
+			b.p1[i]=std::clamp(static_cast<int>(std::ceil(hi[i])), 0, lim[i]-1);
+		}
+		return b;
+	}
+	void add_footprint(std::vector<Box>& boxes, const std::array<double, 3>& pos) {
+		// covers optimize() drifting off the seed
+		constexpr double pad=seed_sep/2-1;
+		boxes.push_back(make_box({pos[0]-pad, pos[1]-pad, pos[2]-pad},
+					{pos[0]+pad, pos[1]+pad, pos[2]+pad}));
+	}
+	void add_footprint(std::vector<Box>& boxes, Locseg_Chain* chain) {
+		std::array<double, 3> lo{INFINITY, INFINITY, INFINITY};
+		std::array<double, 3> hi{-INFINITY, -INFINITY, -INFINITY};
+		auto iter=Locseg_Node_Dlist_Head(chain->list);
+		if(!iter)
+			return;
+		while(iter) {
+			auto seg=iter->data->locseg;
+			std::array<double, 3> pos;
+			Local_Neuroseg_Center(seg, &pos[0]);
+			// one trace step past the segment, plus the labeled radius
+			auto pad=seg->seg.h+2*seg->seg.r1*std::max(seg->seg.scale, 1.0)+4;
+			for(unsigned int i=0; i<3; i++) {
+				lo[i]=std::min(lo[i], pos[i]-pad);
+				hi[i]=std::max(hi[i], pos[i]+pad);
+			}
+			iter=iter->next;
+		}
+		boxes.push_back(make_box(lo, hi));
+	}
+	/*! a worker reads the shared mask until its group labels a chain,
+	 * then switches to a private copy, kept for its later groups.
+	 */
+	void own_mask(Workspace& w) {
+		if(w.lbl!=_ws.lbl)
+			return;
+		w.lbl=w.trace->trace_mask=Copy_Stack(_ws.lbl);
+	}
+	void restore_mask(Stack* lbl, const std::vector<Box>& boxes) {
+		auto src=_ws.lbl;
+		if(lbl==src)
+			return;
+		for(auto& b: boxes) {
+			for(int z=b.p0[2]; z<=b.p1[2]; z++) {
+				for(int y=b.p0[1]; y<=b.p1[1]; y++) {
+					auto off=(std::size_t(z)*src->height+y)*src->width+b.p0[0];
+					std::memcpy(lbl->array+off, src->array+off, b.p1[0]-b.p0[0]+1);
+				}
+			}
+		}
+	}
 	void print_chain(ChainPtr chain) {
 		gapr::print("chain: ", chain);
 		auto iter=Locseg_Node_Dlist_Head(chain->list);
@@ -1245,7 +1409,7 @@ struct NeutubeHelper {
 
 		auto iter=Locseg_Node_Dlist_Head(chain.chain->list);
 		for(int i=0; i<len; i++) {
-			oss<<iter->data->tr->fs.scores[_trace_workspace->tscore_option]<<',';
+			oss<<iter->data->tr->fs.scores[ws().trace->tscore_option]<<',';
 			iter=iter->next;
 		}
 		oss<<"], [";
@@ -1368,6 +1532,8 @@ void gapr::trace::ConnectAlg::impl(Job& job) {
 		cube_ref.bind(job.cube, _xform, job.offset);
 	}
 	NeutubeHelper impl{_graph, std::move(cube_ref)};
+	impl._nworkers=_seed_workers;
+	impl._post=_post;
 	switch(1) {
 		default:
 			job.delta=impl.compute();
@@ -1399,40 +1565,12 @@ gapr::delta_add_patch_ NeutubeHelper::compute() {
 	std::vector<ChainPtr> chains;
 	std::vector<std::pair<ChainPtr, Seed>> seeds_retry;
 	// 1st, only long chains
-	for(auto& seed: seeds) {
-		NeurosegPtr localseg;
-		if(!seed.nid) {
-			if(check_mask(seed.pos))
-				continue;
-			if(check_boundary(seed.pos))
-				continue;
-			localseg=optimize(seed.pos);
-			if(check_boundary(localseg.get()))
-				continue;
-			if(check_mask(localseg.get()))
-				continue;
-			if(check_score(localseg.get()))
-				continue;
-			Local_Neuroseg_Center(localseg.get(), &seed.pos[0]);
-		} else {
-			localseg=optimize_fixed_pos(seed.pos);
-			check_score(localseg.get());
-		}
-
-		auto chain=trace(std::move(localseg));
-		if(Locseg_Chain_Length(chain.get())<10) {
-			seeds_retry.push_back({chain, seed});
-			continue;
-		}
-		if(!seed.nid) {
-			if(!check_val(chain.get()))
-				continue;
-		} else {
-			if(!check_val(chain.get()))
-				continue;
+	if(!trace_seeds_parallel(seeds, seeds_retry)) {
+		for(auto& seed: seeds) {
+			SeedTrace res;
+			trace_seed(seed, res, nullptr);
+			apply_seed(seed, std::move(res), seeds_retry);
 		}
-
-		add_fresh_chain(chain, seed);
 	}
 
 	// 2nd, new short chains
@@ -1465,6 +1603,222 @@ gapr::delta_add_patch_ NeutubeHelper::compute() {
 	return delta;
 }
 
+thread_local NeutubeHelper::Workspace* NeutubeHelper::_ws_local{nullptr};
+
+void NeutubeHelper::trace_seed(Seed& seed, SeedTrace& res, std::vector<Box>* boxes) {
+	NeurosegPtr localseg;
+	if(!seed.nid) {
+		if(check_mask(seed.pos))
+			return;
+		if(check_boundary(seed.pos))
+			return;
+		localseg=optimize(seed.pos);
+		if(check_boundary(localseg.get()))
+			return;
+		if(check_mask(localseg.get()))
+			return;
+		if(check_score(localseg.get()))
+			return;
+		Local_Neuroseg_Center(localseg.get(), &seed.pos[0]);
+	} else {
+		localseg=optimize_fixed_pos(seed.pos);
+		check_score(localseg.get());
+	}
+
+	auto chain=trace(std::move(localseg));
+	if(boxes)
+		add_footprint(*boxes, chain.get());
+	if(Locseg_Chain_Length(chain.get())<10) {
+		res.kind=SeedTrace::RETRY;
+		res.chain=chain;
+		return;
+	}
+	if(!check_val(chain.get()))
+		return;
+
+	res.kind=SeedTrace::FRESH;
+	res.all_masked=prepare_fresh_chain(chain, seed, res.fresh);
+}
+
+void NeutubeHelper::apply_seed(const Seed& seed, SeedTrace&& res, std::vector<std::pair<ChainPtr, Seed>>& seeds_retry) {
+	switch(res.kind) {
+		case SeedTrace::SKIP:
+			break;
+		case SeedTrace::RETRY:
+			seeds_retry.push_back({std::move(res.chain), seed});
+			break;
+		case SeedTrace::FRESH:
+			commit_fresh_chain(std::move(res.fresh), res.all_masked);
+			break;
+	}
+}
+
+std::vector<NeutubeHelper::SeedGroup> NeutubeHelper::partition_seeds(const std::vector<Seed>& seeds) {
+	std::unordered_map<uint64_t, std::size_t> cells;
+	std::vector<std::size_t> seed_cell;
+	seed_cell.reserve(seeds.size());
+	for(auto& seed: seeds) {
+		std::array<int, 3> c;
+		for(unsigned int i=0; i<3; i++)
+			c[i]=std::floor(seed.pos[i]/seed_sep);
+		auto [it, ins]=cells.emplace(cell_key(c[0], c[1], c[2]), cells.size());
+		seed_cell.push_back(it->second);
+	}
+
+	// seeds in non-adjacent cells are at least seed_sep apart
+	DisjointSets sets{cells.size()};
+	for(auto& seed: seeds) {
+		std::array<int, 3> c;
+		for(unsigned int i=0; i<3; i++)
+			c[i]=std::floor(seed.pos[i]/seed_sep);
+		auto a=cells.at(cell_key(c[0], c[1], c[2]));
+		for(int dz=-1; dz<=1; dz++) {
+			for(int dy=-1; dy<=1; dy++) {
+				for(int dx=-1; dx<=1; dx++) {
+					auto it=cells.find(cell_key(c[0]+dx, c[1]+dy, c[2]+dz));
+					if(it!=cells.end())
+						sets.unite(a, it->second);
+				}
+			}
+		}
+	}
+
+	std::vector<SeedGroup> groups;
+	std::unordered_map<std::size_t, std::size_t> root2grp;
+	for(std::size_t i=0; i<seeds.size(); i++) {
+		auto [it, ins]=root2grp.emplace(sets.find(seed_cell[i]), groups.size());
+		if(ins)
+			groups.emplace_back();
+		groups[it->second].seeds.push_back(i);
+	}
+	return groups;
+}
+
+void NeutubeHelper::trace_group(SeedGroup& grp, const std::vector<Seed>& seeds) {
+	grp.out.clear();
+	grp.traced.clear();
+	grp.boxes.clear();
+	for(std::size_t k=0; k<grp.seeds.size(); k++) {
+		auto i=grp.seeds[k];
+		auto seed=seeds[i];
+		add_footprint(grp.boxes, seed.pos);
+		SeedTrace res;
+		trace_seed(seed, res, &grp.boxes);
+		if(res.kind!=SeedTrace::SKIP) {
+			// later seeds of the group must see it, as in the serial pass
+			if(res.kind==SeedTrace::FRESH && k+1<grp.seeds.size()) {
+				own_mask(ws());
+				update_mask(res.fresh.chain);
+			}
+			grp.traced.emplace_back(i, std::move(res));
+		}
+		grp.out.push_back(seed);
+	}
+}
+
+void NeutubeHelper::trace_groups(std::vector<SeedGroup>& groups, const std::vector<std::size_t>& todo, const std::vector<Seed>& seeds) {
+	auto n=todo.size();
+	std::size_t mask_size=std::size_t{1}*_ws.lbl->width*_ws.lbl->height*_ws.lbl->depth;
+	std::size_t nworkers=std::min({std::size_t{_nworkers}, std::size_t{max_seed_workers},
+			std::max(seed_mask_budget/mask_size, std::size_t{1}), n});
+	// one workspace per worker, made on its first group
+	std::vector<std::optional<Workspace>> wss(nworkers);
+	gapr::parallel_for(n, nworkers, _post, [this,&wss,&groups,&todo,&seeds](std::size_t i, unsigned int k) {
+		auto& ws_local=wss[k];
+		if(!ws_local)
+			ws_local=make_workspace(_ws.lbl);
+		_ws_local=&*ws_local;
+		try {
+			auto& grp=groups[todo[i]];
+			trace_group(grp, seeds);
+			// back to the snapshot, for the next group
+			restore_mask(ws_local->lbl, grp.boxes);
+		} catch(...) {
+			_ws_local=nullptr;
+			throw;
+		}
+		_ws_local=nullptr;
+	});
+}
+
+std::vector<std::size_t> NeutubeHelper::merge_conflicts(std::vector<SeedGroup>& groups) {
+	DisjointSets sets{groups.size()};
+	std::unordered_map<uint64_t, std::size_t> cells;
+	bool hit{false};
+	for(std::size_t g=0; g<groups.size(); g++) {
+		for(auto& b: groups[g].boxes) {
+			for(int z=b.p0[2]/footprint_cell; z<=b.p1[2]/footprint_cell; z++) {
+				for(int y=b.p0[1]/footprint_cell; y<=b.p1[1]/footprint_cell; y++) {
+					for(int x=b.p0[0]/footprint_cell; x<=b.p1[0]/footprint_cell; x++) {
+						auto [it, ins]=cells.emplace(cell_key(x, y, z), g);
+						if(!ins && it->second!=g && sets.unite(it->second, g))
+							hit=true;
+					}
+				}
+			}
+		}
+	}
+	if(!hit)
+		return {};
+
+	std::vector<std::size_t> count(groups.size(), 0);
+	for(std::size_t g=0; g<groups.size(); g++)
+		++count[sets.find(g)];
+	std::vector<SeedGroup> merged;
+	std::vector<std::size_t> todo;
+	std::unordered_map<std::size_t, std::size_t> root2grp;
+	for(std::size_t g=0; g<groups.size(); g++) {
+		auto r=sets.find(g);
+		if(count[r]==1) {
+			merged.push_back(std::move(groups[g]));
+			continue;
+		}
+		auto [it, ins]=root2grp.emplace(r, merged.size());
+		if(ins) {
+			merged.emplace_back();
+			todo.push_back(it->second);
+		}
+		auto& dst=merged[it->second].seeds;
+		dst.insert(dst.end(), groups[g].seeds.begin(), groups[g].seeds.end());
+	}
+	for(auto g: todo)
+		std::sort(merged[g].seeds.begin(), merged[g].seeds.end());
+	groups=std::move(merged);
+	return todo;
+}
+
+bool NeutubeHelper::trace_seeds_parallel(std::vector<Seed>& seeds, std::vector<std::pair<ChainPtr, Seed>>& seeds_retry) {
+	if(_nworkers<2 || !_post)
+		return false;
+	auto groups=partition_seeds(seeds);
+	if(groups.size()<2)
+		return false;
+
+	std::vector<std::size_t> todo(groups.size());
+	std::iota(todo.begin(), todo.end(), 0);
+	unsigned int rounds=0;
+	do {
+		trace_groups(groups, todo, seeds);
+		++rounds;
+		todo=merge_conflicts(groups);
+	} while(!todo.empty());
+	gapr::print("parallel seeds: ", groups.size(), " groups, ", rounds, " rounds");
+
+	std::vector<std::pair<std::size_t, SeedTrace*>> order;
+	for(auto& grp: groups) {
+		for(std::size_t k=0; k<grp.seeds.size(); k++)
+			seeds[grp.seeds[k]]=grp.out[k];
+		for(auto& [i, res]: grp.traced)
+			order.emplace_back(i, &res);
+	}
+	std::sort(order.begin(), order.end(), [](auto& a, auto& b) {
+		return a.first<b.first;
+	});
+	for(auto& [i, res]: order)
+		apply_seed(seeds[i], std::move(*res), seeds_retry);
+	return true;
+}
+
 void NeutubeHelper::build_delta2(gapr::delta_add_patch_& delta) {
 
 	//Seed nid assoc.
@@ -1821,3 +2175,54 @@ void NeutubeHelper::build_delta2(gapr::delta_add_patch_& delta) {
 	}
 }
 
+
+namespace gapr_test { int chk_parallel_seeds() {
+	constexpr unsigned int w=192, h=192, d=64;
+	gapr::mutable_cube mcube{gapr::cube_type::u8, {w, h, d}};
+	auto view=mcube.view<uint8_t>();
+	// dim background with bright tubes, far enough apart to be split
+	auto tube=[](double d2) { return 200*std::exp(-d2/(2*1.5*1.5)); };
+	for(unsigned int z=0; z<d; z++) {
+		for(unsigned int y=0; y<h; y++) {
+			auto row=view.row(y, z);
+			for(unsigned int x=0; x<w; x++) {
+				double v=20+(x*7+y*13+z*5)%9;
+				if(x>20 && x<170)
+					v+=tube((y-40.0)*(y-40.0)+(z-20.0)*(z-20.0));
+				if(y>20 && y<170)
+					v+=tube((x-150.0)*(x-150.0)+(z-44.0)*(z-44.0));
+				if(x>20 && x<100)
+					v+=tube((y-140.0-(x-20)/4.0)*(y-140.0-(x-20)/4.0)+(z-32.0)*(z-32.0));
+				row[x]=std::min(v, 255.0);
+			}
+		}
+	}
+	gapr::cube cube{std::move(mcube)};
+	gapr::affine_xform xform{};
+	xform.update_direction_inv();
+	xform.update_resolution();
+	gapr::edge_model model{};
+
+	auto run=[&](unsigned int nworkers) {
+		CubeRef cube_ref;
+		cube_ref.bind(cube, xform, {0, 0, 0});
+		NeutubeHelper helper{model, std::move(cube_ref)};
+		helper._nworkers=nworkers;
+		helper._post=[](std::function<void()>&& f) {
+			std::thread{std::move(f)}.detach();
+		};
+		return helper.compute();
+	};
+	auto serial=run(1);
+	auto parallel=run(4);
+	gapr::print("serial/parallel nodes: ", serial.nodes.size(), '/', parallel.nodes.size());
+	if(serial.nodes.empty())
+		return -1;
+	if(serial.nodes!=parallel.nodes)
+		return -1;
+	if(serial.links!=parallel.links)
+		return -1;
+	if(serial.props!=parallel.props)
+		return -1;
+	return 0;
+} }
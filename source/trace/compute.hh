@@ -1,6 +1,8 @@
 #ifndef _TRACE_COMPUTE_HH_
 #define _TRACE_COMPUTE_HH_
 
+#include <chrono>
+#include <functional>
 #include <unordered_set>
 
 #include "gapr/cube.hh"
@@ -32,6 +34,12 @@ namespace gapr::trace {
 			~ConnectAlg() { }
 
 			void evaluator(const std::string& params);
+			// trace well separated seeds of a cube concurrently;
+			// post() runs helpers elsewhere, the job thread always joins in.
+			void seed_workers(unsigned int n, std::function<void(std::function<void()>&&)> post) {
+				_seed_workers=n;
+				_post=std::move(post);
+			}
 
 			struct Job {
 				gapr::cube cube;
@@ -40,6 +48,9 @@ namespace gapr::trace {
 				void operator()(ConnectAlg& alg);
 				gapr::delta_add_patch_ delta;
 				gapr::delta_proofread_ delta2;
+				// spent in tracing and in the evaluator
+				std::chrono::steady_clock::duration dt_connect{};
+				std::chrono::steady_clock::duration dt_evaluate{};
 			};
 
 		private:
@@ -48,6 +59,8 @@ namespace gapr::trace {
 			std::unordered_set<gapr::node_id> _dirty;
 			std::shared_ptr<Evaluator> _evaluator;
 			std::shared_ptr<Detector> _detector;
+			unsigned int _seed_workers{1};
+			std::function<void(std::function<void()>&&)> _post;
 			void impl(Job& job);
 	};
 
@@ -571,7 +571,7 @@ Tree load_swc(const char* fn) {
 	std::unordered_map<int64_t, std::size_t> id2idx;
 
 	std::ifstream fs{fn};
-	gapr::swc_input swc{fs};
+	gapr::swc_input swc{fs, std::thread::hardware_concurrency()};
 	while(swc.read()) {
 		switch(swc.tag()) {
 		case gapr::swc_input::tags::node:
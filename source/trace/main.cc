@@ -48,6 +48,7 @@
 #include <random>
 #include <chrono>
 #include <thread>
+#include <future>
 #include <filesystem>
 #include <algorithm>
 
@@ -72,6 +73,211 @@ using resolver=ba::ip::tcp::resolver;
 
 
 namespace {
+	/*! offsets of running tasks, hashed into cells as large as the
+	 * conflict span, so a conflict can only come from adjacent cells.
+	 */
+	class running_grid {
+		public:
+			/*! offsets conflict if closer than span on all axes */
+			explicit running_grid(const std::array<unsigned int, 3>& span):
+				_span{span} { }
+
+			void add(const std::array<unsigned int, 3>& offset) {
+				_cells[cell_of(offset)].push_back(offset);
+			}
+			void remove(const std::array<unsigned int, 3>& offset) {
+				auto it=_cells.find(cell_of(offset));
+				assert(it!=_cells.end());
+				auto& v=it->second;
+				auto j=std::find(v.begin(), v.end(), offset);
+				assert(j!=v.end());
+				*j=v.back();
+				v.pop_back();
+				if(v.empty())
+					_cells.erase(it);
+			}
+			bool conflicts(const std::array<unsigned int, 3>& offset) const {
+				if(_cells.empty())
+					return false;
+				auto c=cell_of(offset);
+				std::array<unsigned int, 3> c2;
+				for(int dz=-1; dz<=1; dz++) {
+					if(!shift(c, 2, dz, c2))
+						continue;
+					for(int dy=-1; dy<=1; dy++) {
+						if(!shift(c, 1, dy, c2))
+							continue;
+						for(int dx=-1; dx<=1; dx++) {
+							if(!shift(c, 0, dx, c2))
+								continue;
+							auto it=_cells.find(c2);
+							if(it==_cells.end())
+								continue;
+							for(auto& o2: it->second) {
+								if(overlap(offset, o2))
+									return true;
+							}
+						}
+					}
+				}
+				return false;
+			}
+			bool overlap(const std::array<unsigned int, 3>& a, const std::array<unsigned int, 3>& b) const noexcept {
+				for(unsigned int i=0; i<3; i++) {
+					if(!(a[i]<b[i]+_span[i] && b[i]<a[i]+_span[i]))
+						return false;
+				}
+				return true;
+			}
+
+		private:
+			struct Hash {
+				std::size_t operator()(const std::array<unsigned int, 3>& v) const noexcept {
+					std::hash<unsigned int> h{};
+					return h(v[0])^h(v[1]+11)^h(v[2]+23);
+				}
+			};
+			std::array<unsigned int, 3> _span;
+			std::unordered_map<std::array<unsigned int, 3>, std::vector<std::array<unsigned int, 3>>, Hash> _cells;
+
+			std::array<unsigned int, 3> cell_of(const std::array<unsigned int, 3>& offset) const noexcept {
+				return {offset[0]/_span[0], offset[1]/_span[1], offset[2]/_span[2]};
+			}
+			static bool shift(const std::array<unsigned int, 3>& c, unsigned int i, int d, std::array<unsigned int, 3>& c2) noexcept {
+				if(d<0 && c[i]==0)
+					return false;
+				c2[i]=c[i]+d;
+				return true;
+			}
+	};
+
+	/*! uncovered nodes binned by position, to draw benchmark seeds and
+	 * their neighborhoods without scanning the whole model.
+	 * entries turn stale as nodes get covered, they are dropped when
+	 * drawn or collected.
+	 */
+	class seed_bins {
+		public:
+			using ipos_type=gapr::node_attr::ipos_type;
+			explicit seed_bins(int32_t size): _size{size} { }
+
+			void add(gapr::node_id id, const ipos_type& pos) {
+				auto [it, ins]=_bins.try_emplace(bin_of(pos));
+				if(ins) {
+					it->second.slot=_keys.size();
+					_keys.push_back(it->first);
+				}
+				it->second.nodes.emplace_back(id, pos);
+			}
+			void remove(gapr::node_id id, const ipos_type& pos) {
+				auto it=_bins.find(bin_of(pos));
+				if(it==_bins.end())
+					return;
+				auto& v=it->second.nodes;
+				auto j=std::find_if(v.begin(), v.end(), [id](auto& e) { return e.first==id; });
+				if(j==v.end())
+					return;
+				*j=v.back();
+				v.pop_back();
+				if(v.empty())
+					erase(it);
+			}
+			bool empty() const noexcept { return _keys.empty(); }
+
+			template<typename Rng, typename Stale>
+			std::pair<gapr::node_id, ipos_type> draw(Rng& rng, Stale&& stale) {
+				while(!_keys.empty()) {
+					auto it=_bins.find(_keys[rng()%_keys.size()]);
+					auto& v=it->second.nodes;
+					auto j=rng()%v.size();
+					if(!stale(v[j].first))
+						return v[j];
+					v[j]=v.back();
+					v.pop_back();
+					if(v.empty())
+						erase(it);
+				}
+				return {};
+			}
+			/*! nodes within r of center on all axes */
+			template<typename Stale>
+			void collect(const ipos_type& center, int32_t r, std::vector<gapr::node_id>& out, Stale&& stale) {
+				ipos_type lo, hi, b;
+				for(unsigned int i=0; i<3; i++) {
+					lo[i]=floor_div(int64_t{center[i]}-r, _size);
+					hi[i]=floor_div(int64_t{center[i]}+r, _size);
+				}
+				for(b[2]=lo[2]; b[2]<=hi[2]; b[2]++)
+					for(b[1]=lo[1]; b[1]<=hi[1]; b[1]++)
+						for(b[0]=lo[0]; b[0]<=hi[0]; b[0]++) {
+							auto it=_bins.find(b);
+							if(it==_bins.end())
+								continue;
+							auto& v=it->second.nodes;
+							for(std::size_t j=0; j<v.size(); ) {
+								auto& [id, pos]=v[j];
+								if(!hit(center, r, pos)) {
+									j++;
+									continue;
+								}
+								if(stale(id)) {
+									v[j]=v.back();
+									v.pop_back();
+									continue;
+								}
+								out.push_back(id);
+								j++;
+							}
+							if(v.empty())
+								erase(it);
+						}
+			}
+
+		private:
+			struct Hash {
+				std::size_t operator()(const ipos_type& v) const noexcept {
+					// bins are dense around the origin, mix before combining
+					std::size_t h=static_cast<uint32_t>(v[0]);
+					h=h*0x9e3779b97f4a7c15ull^static_cast<uint32_t>(v[1]);
+					h=h*0x9e3779b97f4a7c15ull^static_cast<uint32_t>(v[2]);
+					return h^(h>>29);
+				}
+			};
+			struct Bin {
+				std::vector<std::pair<gapr::node_id, ipos_type>> nodes;
+				std::size_t slot;
+			};
+			int32_t _size;
+			std::unordered_map<ipos_type, Bin, Hash> _bins;
+			// non-empty bins, for drawing uniformly
+			std::vector<ipos_type> _keys;
+
+			static int32_t floor_div(int64_t v, int32_t d) noexcept {
+				return v>=0 ? v/d : -((-v+d-1)/d);
+			}
+			ipos_type bin_of(const ipos_type& pos) const noexcept {
+				return {floor_div(pos[0], _size), floor_div(pos[1], _size), floor_div(pos[2], _size)};
+			}
+			// same as gapr::bbox_int::hit_test
+			static bool hit(const ipos_type& center, int32_t r, const ipos_type& pos) noexcept {
+				for(unsigned int i=0; i<3; i++) {
+					int64_t d=int64_t{pos[i]}-center[i];
+					if(d<=-r || d>=r)
+						return false;
+				}
+				return true;
+			}
+			void erase(decltype(_bins)::iterator it) {
+				auto slot=it->second.slot;
+				if(slot+1<_keys.size()) {
+					_keys[slot]=_keys.back();
+					_bins.at(_keys[slot]).slot=slot;
+				}
+				_keys.pop_back();
+				_bins.erase(it);
+			}
+	};
+
 	class Tracer {
 		public:
 			struct Args {
@@ -91,6 +297,11 @@ namespace {
 				double range0{0.0};
 				double range1{INFINITY};
 				bool benchmark{false};
+				// benchmark: rng seed, local model state and catalog, json report
+				unsigned int bench_seed{1};
+				std::filesystem::path bench_model{};
+				std::filesystem::path bench_catalog{};
+				std::filesystem::path bench_out{};
 				std::filesystem::path from_swc{};
 				bool from_swc_fin{false};
 			};
@@ -173,6 +384,8 @@ namespace {
 			std::priority_queue<std::size_t, std::vector<std::size_t>, Compare> _pq_queue{Compare{_pq_store}};
 			std::unordered_map<std::array<unsigned int, 3>, std::size_t, Hash> _pq_map;
 			std::size_t _pq_store_free{0};
+			// out of _pq_queue while conflicting with running tasks
+			std::vector<std::size_t> _pq_blocked;
 			void recycle(std::size_t i) {
 				_pq_store[i].next_free=_pq_store_free;
 				_pq_store_free=i+1;
@@ -180,6 +393,10 @@ namespace {
 			void vote(const std::array<double, 3>& pos, const std::array<double, 3>& dir, int w0, int w1);
 			void vote_helper(const std::array<unsigned, 3>& offset, int w0, int w1);
 			bool _model_updated{true};
+			// attrs of root vertices, shared by the tasks started since the last change
+			std::shared_ptr<const std::vector<gapr::node_attr>> _roots;
+			bool _roots_dirty{true};
+			std::shared_ptr<const std::vector<gapr::node_attr>> get_roots();
 			void vote_unfinished();
 			std::array<unsigned int, 3> to_offset(const std::array<double, 3>& pos);
 
@@ -227,7 +444,7 @@ namespace {
 				Retry
 			};
 			template<gapr::delta_type Typ>
-				std::pair<SubmitRes, std::string> submit_commit(gapr::fiber_ctx& ctx, gapr::delta<Typ>&& delta) {
+				std::pair<SubmitRes, std::string> submit_commit(gapr::fiber_ctx& ctx, gapr::delta<Typ>&& delta, gapr::node_id* nid0_ret=nullptr) {
 					gapr::promise<gapr::mem_file> prom{};
 					gapr::fiber fib2{ctx.get_executor(), prom.get_future()};
 					auto ex1=_thr_pool.get_executor();
@@ -275,6 +492,39 @@ namespace {
 						return {SubmitRes::Deny, "err load2"};
 					gapr::print("prepare ok");
 					_hist.add_tail(cmt_id);
+					if(nid0_ret)
+						*nid0_ret=gapr::node_id{nid0};
+					return {SubmitRes::Accept, {}};
+				}
+			// offline benchmark: next id to number new nodes with
+			gapr::node_id _local_nid{};
+			/*! loads delta into the local model as if accepted by gather */
+			template<gapr::delta_type Typ>
+				std::pair<SubmitRes, std::string> commit_local(gapr::fiber_ctx& ctx, gapr::delta<Typ>&& delta) {
+					gapr::promise<bool> prom{};
+					gapr::fiber fib{ctx.get_executor(), prom.get_future()};
+					auto ex1=_thr_pool.get_executor();
+					ba::post(ex1, [this,prom=std::move(prom),&delta]() mutable {
+						try {
+							if(cannolize(delta)<0)
+								throw std::runtime_error{"invalid delta"};
+							auto nid0=_local_nid;
+							if constexpr(Typ==gapr::delta_type::add_patch_) {
+								// all but links to existing nodes get new ids
+								auto n=delta.nodes.size();
+								for(auto& [idx, link]: delta.links) {
+									if(gapr::link_id{link}.on_node())
+										--n;
+								}
+								_local_nid=_local_nid.offset(n);
+							}
+							std::move(prom).set(model_prepare(nid0, std::move(delta)));
+						} catch(const std::runtime_error& e) {
+							return unlikely(std::move(prom), std::current_exception());
+						}
+					});
+					if(!std::move(fib).async_wait(gapr::yield{ctx}))
+						return {SubmitRes::Deny, "err load2"};
 					return {SubmitRes::Accept, {}};
 				}
 			std::pair<std::size_t, std::size_t> select_chan() {
@@ -651,6 +901,21 @@ void Tracer::vote_unfinished() {
 				}
 				for(auto i: idxes)
 					_pq_queue.push(i);
+				std::size_t j=0;
+				for(auto i: _pq_blocked) {
+					if(_pq_store[i].skip) {
+						recycle(i);
+						continue;
+					}
+					if(_pq_store[i].vote_ds==0) {
+						_pq_map.erase(_pq_store[i].offset);
+						recycle(i);
+						continue;
+					}
+					_pq_store[i].vote_total=_pq_store[i].vote_ds;
+					_pq_blocked[j++]=i;
+				}
+				_pq_blocked.resize(j);
 	}
 	gapr::edge_model::reader model{_model};
 
@@ -913,10 +1178,28 @@ bool Tracer::model_apply(bool last) {
 			return false;
 		_model_updated=true;
 		prev_nid0=updater.nid0();
+		// roots are always vertices, and only come and go with root props
+		if(!updater.trees_add().empty() || !updater.trees_del().empty())
+			_roots_dirty=true;
 	}
 	return true;
 }
 
+std::shared_ptr<const std::vector<gapr::node_attr>> Tracer::get_roots() {
+	if(!_roots_dirty)
+		return _roots;
+	auto roots=std::make_shared<std::vector<gapr::node_attr>>();
+	gapr::edge_model::reader model{_model};
+	auto& vertices=model.vertices();
+	for(auto nid: model.props().per_key("root")) {
+		if(auto it=vertices.find(nid); it!=vertices.end())
+			roots->push_back(it->second.attr);
+	}
+	_roots=std::move(roots);
+	_roots_dirty=false;
+	return _roots;
+}
+
 int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 	prepare(ctx);
 
@@ -976,8 +1259,22 @@ int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 	unsigned int niter=0;
 	gapr::trace::ConnectAlg alg{"", _cube_infos[_closeup_ch-1].xform, _model};
 	alg.evaluator(_args.evaluator);
+	// one cube at a time leaves the pool idle, split seeds instead
+	if(_args.jobs<=1) {
+		alg.seed_workers(std::thread::hardware_concurrency(), [ex=_thr_pool.get_executor()](std::function<void()>&& f) {
+			ba::post(ex, std::move(f));
+		});
+	}
 	bool need_loading{true};
 	std::deque<std::tuple<std::size_t, gapr::future<int>, std::unique_ptr<gapr::trace::ConnectAlg::Job>>> running_tasks{};
+	running_grid running_cells{[&info=_cube_infos[_closeup_ch-1]]() {
+		std::array<unsigned int, 3> span;
+		for(unsigned int i=0; i<3; i++) {
+			unsigned int pad=4;
+			span[i]=info.cube_sizes[i]*3+pad;
+		}
+		return span;
+	}()};
 	do {
 		if(_args.maxiter==0 || niter<_args.maxiter) {
 			if(need_loading) {
@@ -989,32 +1286,13 @@ int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 			}
 			vote_unfinished();
 
-			std::vector<std::size_t> avoiding{};
-			auto avoid_running=[this,&running_tasks](const std::array<unsigned, 3>& offset) ->bool {
-				auto& info=_cube_infos[_closeup_ch-1];
-				for(auto& [idx, fut_, alg_]: running_tasks) {
-					auto o2=_pq_store[idx].offset;
-					bool hit=true;
-					for(unsigned int i=0; i<3; i++) {
-						unsigned int pad=4;
-						unsigned int s=info.cube_sizes[i]*3+pad;
-						hit=hit&&(offset[i]<o2[i]+s);
-						hit=hit&&(o2[i]<offset[i]+s);
-					}
-					if(hit) {
-						return true;
-					}
-				}
-				return false;
-			};
-
 			std::size_t idx{SIZE_MAX};
 			while(!_pq_queue.empty()) {
 				auto i=_pq_queue.top();
 				_pq_queue.pop();
 				if(!_pq_store[i].skip) {
-					if(avoid_running(_pq_store[i].offset)) {
-						avoiding.push_back(i);
+					if(running_cells.conflicts(_pq_store[i].offset)) {
+						_pq_blocked.push_back(i);
 						continue;
 					}
 					idx=i;
@@ -1022,8 +1300,6 @@ int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 				}
 				recycle(i);
 			}
-			for(auto i: avoiding)
-				_pq_queue.push(i);
 			if(idx==SIZE_MAX) {
 				if(running_tasks.empty()) {
 					if(!get_retry(ctx))
@@ -1035,16 +1311,10 @@ int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 			} else {
 				_pq_store[idx].stage=TaskStage::Running;
 
-				std::vector<gapr::node_attr> to_skip{};
+				auto roots=get_roots();
+				auto& to_skip=*roots;
 				if(true) {
 					gapr::edge_model::reader model{_model};
-					for(auto& [vid, vert]: model.vertices()) {
-						gapr::edge_model::prop_id pid{vid, "root"};
-						if(model.props().find(pid)!=model.props().end()) {
-							to_skip.push_back(vert.attr);
-						}
-					}
-
 					using namespace std::string_view_literals;
 					auto& logs=model.logs();
 					while(traced_cubes_last<logs.size()) {
@@ -1115,6 +1385,7 @@ int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 
 				++niter;
 				running_tasks.emplace_back(idx, std::move(fut), std::move(job));
+				running_cells.add(info.offset);
 
 				if(_args.jobs!=0 && running_tasks.size()<_args.jobs)
 					continue;
@@ -1129,6 +1400,18 @@ int Tracer::run_impl(gapr::fiber_ctx& ctx) {
 			running_tasks.pop_front();
 			gapr::fiber fib2{ctx.get_executor(), std::move(fut)};
 			std::move(fib2).async_wait(gapr::yield{ctx});
+			running_cells.remove(_pq_store[idx].offset);
+			{
+				std::size_t j=0;
+				for(auto i: _pq_blocked) {
+					if(!_pq_store[i].skip && running_cells.conflicts(_pq_store[i].offset)) {
+						_pq_blocked[j++]=i;
+						continue;
+					}
+					_pq_queue.push(i);
+				}
+				_pq_blocked.resize(j);
+			}
 			auto delta=std::move(alg->delta);
 			{
 				using namespace std::string_view_literals;
@@ -1194,6 +1477,7 @@ struct ImportHelper {
 	struct Node: gapr::node_attr {
 		int64_t par_id;
 		gapr::node_id id2{};
+		// 0: todo, 1: in the delta being built, 2: committed, 3: in a commit not acked yet
 		unsigned int state;
 	};
 	std::unordered_map<int64_t, Node> nodes;
@@ -1253,7 +1537,7 @@ struct ImportHelper {
 				Node* par{nullptr};
 				if(nn.par_id!=-1) {
 					auto& np=helper.nodes.at(nn.par_id);
-					if(np.state==0)
+					if(np.state==0 || np.state==3)
 						continue;
 					else if(np.state==1)
 						par_id=np.id2;
@@ -1299,8 +1583,94 @@ struct ImportHelper {
 				return a.second<b.second;
 			});
 			//dump(delta, std::cerr, 1, gapr::node_id{});
+			for(auto n: tofix)
+				n->state=3;
+		}
+		void acked(gapr::node_id nid0) {
+			for(unsigned int i=0; i<tofix.size(); ++i) {
+				auto n=tofix[i];
+				assert(n);
+				assert(n->id2);
+				assert(n->state==3);
+				n->id2=nid0.offset(i);
+				n->state=2;
+			}
 		}
 	};
+	/*! first node left (in file order) with its parent and loops
+	 * committed, or with any, simply the first one left */
+	int64_t take_seed(bool any) {
+		while(!todo.empty() && todo.back()==-1)
+			todo.pop_back();
+		for(std::size_t k=todo.size(); k-->0; ) {
+			auto id=todo[k];
+			if(id==-1)
+				continue;
+			auto& nn=nodes.at(id);
+			bool ready=nn.par_id==-1 || nodes.at(nn.par_id).state==2;
+			auto [a, b]=loops.equal_range(id);
+			for(auto it=a; ready && it!=b; ++it)
+				ready=nodes.at(it->second).state==2;
+			if(ready) {
+				todo[k]=-1;
+				return id;
+			}
+		}
+		if(!any || todo.empty())
+			return -1;
+		auto id=todo.back();
+		todo.pop_back();
+		return id;
+	}
+	/*! start(builder, seed_pos) gets builder.finish() going and returns
+	 * a future for wait(), commit(delta) returns the acked nid0.
+	 * With overlap, the next delta is built (from committed nodes)
+	 * while the previous one is being committed. */
+	template<typename Start, typename Wait, typename Commit>
+	void commit_all(Start&& start, Wait&& wait, Commit&& commit, bool overlap) {
+		using Fut=decltype(start(std::declval<DeltaBuilder&>(), gapr::vec3<>{}));
+		struct fragment {
+			DeltaBuilder builder;
+			std::optional<Fut> fut{};
+		};
+		auto next_fragment=[this,&start](bool any) {
+			std::unique_ptr<fragment> frag{};
+			if(auto seed=take_seed(any); seed!=-1) {
+				frag.reset(new fragment{DeltaBuilder{*this}});
+				frag->fut.emplace(start(frag->builder, frag->builder.init(seed)));
+			}
+			return frag;
+		};
+		auto cur=next_fragment(true);
+		if(cur)
+			wait(std::move(*cur->fut));
+		while(cur) {
+			std::unique_ptr<fragment> next{};
+			if(overlap)
+				next=next_fragment(false);
+			gapr::node_id nid0{};
+			std::exception_ptr err{};
+			try {
+				auto delta=std::move(cur->builder.delta);
+				assert(delta.nodes.size()>0);
+				nid0=commit(std::move(delta));
+			} catch(...) {
+				err=std::current_exception();
+			}
+			// next->builder is still in use
+			if(next)
+				wait(std::move(*next->fut));
+			if(err)
+				std::rethrow_exception(err);
+			cur->builder.acked(nid0);
+			if(!next) {
+				next=next_fragment(true);
+				if(next)
+					wait(std::move(*next->fut));
+			}
+			cur=std::move(next);
+		}
+	}
 	void add_node(int64_t id, const gapr::swc_node& n, gapr::misc_attr misc) {
 		auto [it, ins]=nodes.emplace(id, Node{});
 		assert(ins);
@@ -1383,7 +1753,7 @@ int Tracer::run_import(gapr::fiber_ctx& ctx) {
 		if(_args.from_swc.extension()==".gz")
 			filter.push(boost::iostreams::gzip_decompressor{});
 		filter.push(fs);
-		gapr::swc_input swc{filter};
+		gapr::swc_input swc{filter, std::thread::hardware_concurrency()};
 		while(swc.read()) {
 			switch(swc.tag()) {
 			case gapr::swc_input::tags::comment:
@@ -1423,24 +1793,12 @@ int Tracer::run_import(gapr::fiber_ctx& ctx) {
 
 	start_cube_builder();
 	std::reverse(helper.todo.begin(), helper.todo.end());
-	do {
-		assert(!helper.todo.empty());
-		auto seed=helper.todo.back();
-		helper.todo.pop_back();
-		if(seed==-1)
-			continue;
 
-		ImportHelper::DeltaBuilder builder{helper};
-		auto seed_pos=builder.init(seed);
-		auto seed_off=_cube_infos[_closeup_ch-1].to_offseti(seed_pos, true);
+	auto& info=_cube_infos[closeup_ch-1];
+	auto start=[this,&info](ImportHelper::DeltaBuilder& builder, gapr::vec3<> seed_pos) {
+		auto seed_off=info.to_offseti(seed_pos, true);
 		fprintf(stderr, "%d %d %d\n", seed_off[0], seed_off[1], seed_off[2]);
-		//gapr::print("cur cube: [", info.offset[0], ':', info.offset[1], ':', info.offset[2], "] [", info.vote_total, '/', info.vote_ds, "] [", info.skip, ',', static_cast<int>(info.stage), ']');
-		//
-		//get closeup cube
-		//XXX lock best
-		//
-		auto& info=_cube_infos[closeup_ch-1];
-		auto filter=[&info,&seed_off,&seed_pos](const auto& pos) {
+		auto filter=[&info,seed_off,seed_pos](const auto& pos) {
 			double maxl1=0;
 			for(unsigned int i=0; i<3; ++i)
 				maxl1=std::max(maxl1, std::abs(pos[i]-seed_pos[i]));
@@ -1468,43 +1826,31 @@ int Tracer::run_import(gapr::fiber_ctx& ctx) {
 				unlikely(std::move(prom), std::current_exception());
 			}
 		});
-
-		do {
-			gapr::fiber fib2{ctx.get_executor(), std::move(fut)};
-			std::move(fib2).async_wait(gapr::yield{ctx});
-			auto delta=std::move(builder.delta);
-			assert(delta.nodes.size()>0);
-			auto res=submit_commit(ctx, std::move(delta));
+		return fut;
+	};
+	auto wait=[&ctx](gapr::future<int>&& fut) {
+		gapr::fiber fib2{ctx.get_executor(), std::move(fut)};
+		std::move(fib2).async_wait(gapr::yield{ctx});
+	};
+	// the model is only read back at the end, apply in batches
+	unsigned int n_unapplied{0};
+	auto commit=[this,&ctx,&n_unapplied](gapr::delta_add_patch_&& delta) {
+		gapr::node_id nid0{};
+		auto res=submit_commit(ctx, std::move(delta), &nid0);
+		if(res.first!=SubmitRes::Accept) {
+			gapr::str_glue err{"failed to commit: ", res.second.empty()?std::string_view{"not accepted"}:std::string_view{res.second}};
+			throw gapr::reported_error{err.str()};
+		}
+		if(++n_unapplied>=16) {
 			if(!model_apply(true))
 				throw gapr::reported_error{"failed to update model 2"};
-			switch(res.first) {
-			case SubmitRes::Retry:
-			case SubmitRes::Deny:
-				if(!res.second.empty()) {
-					gapr::str_glue err{"failed to commit: ", res.second};
-					throw gapr::reported_error{err.str()};
-				}
-				break;
-			case SubmitRes::Accept:
-				break;
-			}
-
-			for(unsigned int i=0; i<builder.tofix.size(); ++i) {
-				auto n=builder.tofix[i];
-				assert(n);
-				assert(n->id2);
-				assert(n->state==1);
-				n->id2=prev_nid0.offset(i);
-				n->state=2;
-			}
-		} while(false);
-
-		select(ctx);
-		if(!load_commits(ctx, _cur_conn, _latest_commit))
-			throw gapr::reported_error{"failed to load commits"};
-		if(!model_apply(true))
-			throw gapr::reported_error{"failed to update model"};
-	} while(!helper.todo.empty());
+			n_unapplied=0;
+		}
+		return nid0;
+	};
+	helper.commit_all(start, wait, commit, true);
+	if(!model_apply(true))
+		throw gapr::reported_error{"failed to update model"};
 
 	{
 		auto cli=std::move(_cur_conn);
@@ -2453,54 +2799,191 @@ int Tracer::run_remove_edges(gapr::fiber_ctx& ctx) {
 }
 
 int Tracer::run_benchmark(gapr::fiber_ctx& ctx) {
-	prepare(ctx);
-	if(!load_commits(ctx, _cur_conn, _latest_commit))
+	using clock=std::chrono::steady_clock;
+	// commits go where the model comes from
+	bool offline=!_args.bench_model.empty();
+	if(!offline || _args.bench_catalog.empty())
+		prepare(ctx);
+	if(!_args.bench_catalog.empty()) {
+		std::ifstream str{_args.bench_catalog};
+		if(!str)
+			throw gapr::reported_error{"unable to open catalog file"};
+		std::vector<gapr::mesh_info> mesh_infos;
+		_cube_infos.clear();
+		gapr::parse_catalog(str, _cube_infos, mesh_infos, gapr::to_url_if_path(_args.bench_catalog.string()));
+		if(_cube_infos.empty())
+			throw gapr::reported_error{"no imaging data"};
+	}
+	if(offline) {
+		gapr::promise<uint64_t> prom{};
+		gapr::fiber fib2{ctx.get_executor(), prom.get_future()};
+		auto ex1=_thr_pool.get_executor();
+		ba::post(ex1, [this,prom=std::move(prom)]() mutable {
+			try {
+				auto sb=gapr::make_streambuf(_args.bench_model.string().c_str());
+				gapr::edge_model::loader loader{_model};
+				return std::move(prom).set(loader.init(*sb));
+			} catch(const std::runtime_error& e) {
+				return unlikely(std::move(prom), std::current_exception());
+			}
+		});
+		if(!std::move(fib2).async_wait(gapr::yield{ctx}))
+			throw gapr::reported_error{"failed to load model"};
+	} else if(!load_commits(ctx, _cur_conn, _latest_commit)) {
 		throw gapr::reported_error{"failed to load commits"};
+	}
 	if(!model_apply(true))
 		throw gapr::reported_error{"failed to update model"};
+	if(offline) {
+		gapr::edge_model::reader model{_model};
+		gapr::node_id::data_type last{0};
+		for(auto& [id, pos]: model.nodes())
+			last=std::max(last, id.data);
+		_local_nid=gapr::node_id{last+1};
+	}
+
+	auto [first_c, first_g]=select_chan();
+	_global_ch=first_g;
+	_closeup_ch=first_c;
+	start_cube_builder();
+	gapr::trace::ConnectAlg alg{"", _cube_infos[_closeup_ch-1].xform, _model};
+	alg.evaluator(_args.evaluator);
+	alg.seed_workers(std::thread::hardware_concurrency(), [ex=_thr_pool.get_executor()](std::function<void()>&& f) {
+		ba::post(ex, std::move(f));
+	});
+
+	struct {
+		clock::duration cube{}, connect{}, evaluate{}, delta{}, submit{}, apply{};
+		clock::duration total{};
+		std::size_t cubes{0}, commits{0}, traced{0}, proofread{0};
+	} st;
+	auto commit=[this,&ctx,offline,&st](auto&& delta) {
+		auto t0=clock::now();
+		auto res=offline?commit_local(ctx, std::move(delta)):submit_commit(ctx, std::move(delta));
+		auto t1=clock::now();
+		if(!model_apply(true))
+			throw gapr::reported_error{"failed to update model 2"};
+		st.submit+=t1-t0;
+		st.apply+=clock::now()-t1;
+		if(res.first!=SubmitRes::Accept && !res.second.empty()) {
+			gapr::str_glue err{"failed to commit: ", res.second};
+			throw gapr::reported_error{err.str()};
+		}
+		if(res.first==SubmitRes::Accept)
+			++st.commits;
+		return res.first;
+	};
+	std::unordered_set<std::array<unsigned int, 3>, Hash> traced_cubes;
+	// traces the cube a seed falls in, once
+	auto trace_at=[&](const gapr::node_attr::ipos_type& ipos) {
+		gapr::node_attr attr{ipos, gapr::misc_attr{}};
+		auto& info=_cube_infos[_closeup_ch-1];
+		auto offset=to_offset({attr.pos(0), attr.pos(1), attr.pos(2)});
+		for(unsigned int i=0; i<3; i++) {
+			auto s=2*info.cube_sizes[i];
+			offset[i]=offset[i]/s*s;
+		}
+		if(!traced_cubes.emplace(offset).second)
+			return;
+		auto t0=clock::now();
+		get_closeup(offset, get_center(offset), ctx);
+		auto t1=clock::now();
+		st.cube+=t1-t0;
+		++st.cubes;
 
-	std::mt19937 rng{std::random_device{}()};
+		gapr::trace::ConnectAlg::Job job{_closeup_cube, _closeup_offset};
+		job.cancel=&_cancel_flag;
+		gapr::promise<int> prom;
+		gapr::fiber fib{ctx.get_executor(), prom.get_future()};
+		ba::post(_thr_pool.get_executor(), [prom=std::move(prom),&alg,&job]() mutable {
+			try {
+				job(alg);
+				std::move(prom).set(0);
+			} catch(const std::runtime_error& e) {
+				unlikely(std::move(prom), std::current_exception());
+			}
+		});
+		std::move(fib).async_wait(gapr::yield{ctx});
+		st.connect+=job.dt_connect;
+		st.evaluate+=job.dt_evaluate;
+
+		// the rest of the job sorts and dumps the delta
+		auto delta=std::move(job.delta);
+		{
+			using namespace std::string_view_literals;
+			auto [x, y, z]=job.offset;
+			auto log=gapr::str_glue{nullptr, ":"sv}("traced=")(x, y, z).str();
+			delta.props.emplace_back(gapr::node_id::max().data, std::move(log));
+		}
+		auto added=delta.nodes.size()-delta.links.size();
+		auto t2=clock::now();
+		st.delta+=(t2-t1)-job.dt_connect-job.dt_evaluate;
+		if(commit(std::move(delta))==SubmitRes::Accept)
+			st.traced+=added;
+		if(!job.delta2.nodes.empty())
+			commit(std::move(job.delta2));
+	};
+
+	std::mt19937 rng{_args.bench_seed};
+	// seeds and their neighborhoods, 50um around
+	constexpr int32_t radius=1024*50;
+	seed_bins bins{radius};
+	auto fill_bins=[&bins](const gapr::edge_model::reader& model) {
+		for(auto& [eid, edg]: model.edges()) {
+			for(unsigned int i=0; i<edg.nodes.size(); i++) {
+				gapr::node_attr attr{edg.points[i]};
+				if(!attr.misc.coverage())
+					bins.add(edg.nodes[i], attr.ipos);
+			}
+		}
+	};
+	{
+		gapr::edge_model::reader model{_model};
+		fill_bins(model);
+	}
 	std::vector<gapr::node_id> todo;
 	bool stop{false};
-	auto t0=std::chrono::steady_clock::now();
+	auto t_start=clock::now();
+	clock::duration paced{};
+	auto t0=t_start;
 	do {
 
 		gapr::delta_proofread_ delta;
+		std::vector<std::pair<gapr::node_id, gapr::node_attr::ipos_type>> marked;
+		std::optional<gapr::node_attr::ipos_type> to_trace;
+		auto t1=clock::now();
 		do {
 			gapr::edge_model::reader model{_model};
 			if(todo.empty()) {
-				gapr::node_id seed{};
-				gapr::node_attr seedp;
-				for(auto& [eid, edg]: model.edges()) {
-					for(unsigned int i=0; i<edg.nodes.size(); i++) {
-						auto id=edg.nodes[i];
-						gapr::node_attr attr{edg.points[i]};
-						if(!attr.misc.coverage()) {
-							seed=id;
-							seedp=attr;
-							break;
-						}
+				// removed, or covered by others
+				auto stale=[&model](gapr::node_id id) {
+					auto it=model.nodes().find(id);
+					if(it==model.nodes().end())
+						return true;
+					auto pos=it->second;
+					if(pos.edge) {
+						auto& edg=model.edges().at(pos.edge);
+						return gapr::node_attr{edg.points[pos.index/128]}.misc.coverage();
 					}
-					if(seed && rng()%1000==0)
-						break;
-				}
-				if(!seed) {
+					return model.vertices().at(pos.vertex).attr.misc.coverage();
+				};
+				if(_args.maxiter!=0 && st.cubes>=_args.maxiter) {
 					stop=true;
 					break;
 				}
-				gapr::bbox_int bbox{};
-				bbox.add(seedp.ipos);
-				bbox.grow(1024*50);
-				for(auto& [eid, edg]: model.edges()) {
-					for(unsigned int i=0; i<edg.nodes.size(); i++) {
-						auto id=edg.nodes[i];
-						gapr::node_attr attr{edg.points[i]};
-						if(!bbox.hit_test(attr.ipos))
-							continue;
-						if(!attr.misc.coverage())
-							todo.push_back(id);
-					}
+				auto seed=bins.draw(rng, stale);
+				if(!seed.first) {
+					// pick up nodes added by others
+					fill_bins(model);
+					seed=bins.draw(rng, stale);
+				}
+				if(!seed.first) {
+					stop=true;
+					break;
 				}
+				bins.collect(seed.second, radius, todo, stale);
+				to_trace=seed.second;
+				break;
 			}
 			assert(!todo.empty());
 
@@ -2528,37 +3011,68 @@ int Tracer::run_benchmark(gapr::fiber_ctx& ctx) {
 			auto idx1=idx+10<edg->nodes.size()?idx+10:edg->nodes.size();
 			for(idx=idx0; idx<idx1; ++idx) {
 				gapr::node_attr attr{edg->points[idx]};
-				if(!attr.misc.coverage())
+				if(!attr.misc.coverage()) {
 					delta.nodes.push_back(edg->nodes[idx].data);
+					marked.emplace_back(edg->nodes[idx], attr.ipos);
+				}
 			}
 		} while(false);
+		st.delta+=clock::now()-t1;
 
-
+		if(to_trace) {
+			// the tracer goes ahead, proofreading follows
+			trace_at(*to_trace);
+			continue;
+		}
 		if(!delta.nodes.empty()) {
-			auto t1=std::chrono::steady_clock::now();
-
-			auto res=submit_commit(ctx, std::move(delta));
-			if(!model_apply(true))
-				throw gapr::reported_error{"failed to update model 2"};
-			switch(res.first) {
+			switch(commit(std::move(delta))) {
 				case SubmitRes::Retry:
 				case SubmitRes::Deny:
-					if(!res.second.empty()) {
-						gapr::str_glue err{"failed to commit: ", res.second};
-						throw gapr::reported_error{err.str()};
-					}
 					std::shuffle(todo.begin(), todo.end(), rng);
 					break;
 				case SubmitRes::Accept:
+					for(auto& [id, pos]: marked)
+						bins.remove(id, pos);
+					st.proofread+=marked.size();
 					break;
 			}
-			auto t2=std::chrono::steady_clock::now();
-			fprintf(stderr, "dt: %u\n", (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(t2-t1).count());
-			std::this_thread::sleep_until(t0+std::chrono::milliseconds{2000});
-			t0=std::chrono::steady_clock::now();
+			if(!offline) {
+				// a proofreader's pace, when sharing the server
+				auto t2=clock::now();
+				std::this_thread::sleep_until(t0+std::chrono::milliseconds{2000});
+				t0=clock::now();
+				paced+=t0-t2;
+			}
 		}
 
 	} while(!stop);
+	st.total=clock::now()-t_start-paced;
+
+	auto report=[&st,offline,this](std::ostream& str) {
+		auto ms=[](clock::duration d) {
+			return std::chrono::duration<double, std::milli>{d}.count();
+		};
+		auto secs=std::chrono::duration<double>{st.total}.count();
+		str<<"{\"seed\":"<<_args.bench_seed<<",\"offline\":"<<(offline?"true":"false");
+		str<<",\"cubes\":"<<st.cubes<<",\"commits\":"<<st.commits;
+		str<<",\"nodes\":{\"traced\":"<<st.traced<<",\"proofread\":"<<st.proofread<<'}';
+		str<<",\"stages_ms\":{\"cube_load\":"<<ms(st.cube);
+		str<<",\"connect\":"<<ms(st.connect);
+		str<<",\"evaluator\":"<<ms(st.evaluate);
+		str<<",\"delta_build\":"<<ms(st.delta);
+		str<<",\"submit\":"<<ms(st.submit);
+		str<<",\"model_apply\":"<<ms(st.apply)<<'}';
+		str<<",\"elapsed_ms\":"<<ms(st.total);
+		str<<",\"nodes_per_second\":"<<(secs>0?(st.traced+st.proofread)/secs:0.0)<<"}\n";
+	};
+	if(!_args.bench_out.empty()) {
+		std::ofstream fs{_args.bench_out};
+		report(fs);
+		if(!fs.flush())
+			throw gapr::reported_error{"failed to write benchmark report"};
+	} else {
+		report(std::cout);
+	}
 
 	{
 		auto cli=std::move(_cur_conn);
@@ -2609,6 +3123,10 @@ constexpr static const struct option opts_long[]={
 	{"near", 1, nullptr, 1001+'n'},
 	{"distant", 1, nullptr, 1001+'d'},
 	{"benchmark", 0, nullptr, 1100+'b'},
+	{"bench-seed", 1, nullptr, 1100+'s'},
+	{"bench-model", 1, nullptr, 1100+'m'},
+	{"bench-catalog", 1, nullptr, 1100+'c'},
+	{"bench-out", 1, nullptr, 1100+'o'},
 	{"import", 1, nullptr, 1200+'I'},
 	{"import-fin", 1, nullptr, 1200+'F'},
 	{"cube", 1, nullptr, 1500+'c'},
@@ -2659,7 +3177,7 @@ int trace_cube(const std::string& evaluator, const gapr::vec3<double>& res, cons
 		auto cubef=gapr::make_streambuf(cubefn);
 		if(!cubef)
 			gapr::report("Cannot open file: ", cubefn);
-		auto loader=gapr::make_cube_loader(cubefn, *cubef);
+		auto loader=gapr::make_cube_loader(cubefn, *cubef, std::thread::hardware_concurrency());
 		if(!loader)
 			gapr::report("Cannot open image: ", cubefn);
 		gapr::cube_type type=loader->type();
@@ -2714,6 +3232,189 @@ int trace_cube(const std::string& evaluator, const gapr::vec3<double>& res, cons
 	return 0;
 }
 
+namespace gapr_test { int chk_running_grid() {
+	std::mt19937 rng{12345};
+	std::array<unsigned int, 3> cube_sizes{256, 256, 128};
+	std::array<unsigned int, 3> span;
+	for(unsigned int i=0; i<3; i++)
+		span[i]=cube_sizes[i]*3+4;
+	// the scan it replaces
+	auto avoid_running=[&cube_sizes](const std::vector<std::array<unsigned int, 3>>& running, const std::array<unsigned, 3>& offset) ->bool {
+		for(auto& o2: running) {
+			bool hit=true;
+			for(unsigned int i=0; i<3; i++) {
+				unsigned int pad=4;
+				unsigned int s=cube_sizes[i]*3+pad;
+				hit=hit&&(offset[i]<o2[i]+s);
+				hit=hit&&(o2[i]<offset[i]+s);
+			}
+			if(hit)
+				return true;
+		}
+		return false;
+	};
+	auto rand_offset=[&rng,&cube_sizes]() {
+		std::array<unsigned int, 3> o;
+		for(unsigned int i=0; i<3; i++) {
+			// mostly aligned as voted, sometimes not
+			auto v=std::uniform_int_distribution<unsigned int>{0, 40}(rng)*cube_sizes[i];
+			if(rng()%8==0)
+				v+=rng()%cube_sizes[i];
+			o[i]=v;
+		}
+		return o;
+	};
+
+	running_grid grid{span};
+	std::vector<std::array<unsigned int, 3>> running;
+	std::size_t nhits{0};
+	for(unsigned int iter=0; iter<20000; iter++) {
+		if(!running.empty() && (running.size()>=32 || rng()%3==0)) {
+			auto k=rng()%running.size();
+			grid.remove(running[k]);
+			running[k]=running.back();
+			running.pop_back();
+		} else {
+			auto o=rand_offset();
+			grid.add(o);
+			running.push_back(o);
+		}
+		for(unsigned int k=0; k<8; k++) {
+			auto o=rand_offset();
+			auto a=avoid_running(running, o);
+			if(a!=grid.conflicts(o)) {
+				gapr::print("running_grid mismatch: ", o[0], ':', o[1], ':', o[2]);
+				return -1;
+			}
+			nhits+=a;
+		}
+	}
+	gapr::print("running_grid: ", nhits, " conflicts agreed");
+	return 0;
+} }
+
+namespace gapr_test { int chk_seed_bins() {
+	constexpr uint32_t nnodes=200000;
+	constexpr int32_t radius=1024*50;
+	std::mt19937 rng{23456};
+	std::vector<gapr::node_attr::ipos_type> points(nnodes+1);
+	std::vector<bool> covered(nnodes+1, false);
+	seed_bins bins{radius};
+	for(uint32_t i=1; i<=nnodes; i++) {
+		for(unsigned int k=0; k<3; k++)
+			points[i][k]=static_cast<int32_t>(rng()%(1024*4000))-1024*500;
+		bins.add(gapr::node_id{i}, points[i]);
+	}
+	auto stale=[&covered](gapr::node_id id) { return static_cast<bool>(covered[id.data]); };
+
+	// the scan it replaces
+	auto scan=[&](const gapr::node_attr::ipos_type& center) {
+		gapr::bbox_int bbox{};
+		bbox.add(center);
+		bbox.grow(radius);
+		std::vector<gapr::node_id> res;
+		for(uint32_t i=1; i<=nnodes; i++) {
+			if(!covered[i] && bbox.hit_test(points[i]))
+				res.push_back(gapr::node_id{i});
+		}
+		return res;
+	};
+	std::chrono::steady_clock::duration dt_scan{0}, dt_bins{0};
+	unsigned int nseeds{0};
+	std::vector<gapr::node_id> todo;
+	while(true) {
+		auto t0=std::chrono::steady_clock::now();
+		auto seed=bins.draw(rng, stale);
+		if(!seed.first)
+			break;
+		if(covered[seed.first.data] || seed.second!=points[seed.first.data])
+			return -1;
+		todo.clear();
+		bins.collect(seed.second, radius, todo, stale);
+		auto t1=std::chrono::steady_clock::now();
+		auto ref=scan(seed.second);
+		auto t2=std::chrono::steady_clock::now();
+		dt_bins+=t1-t0;
+		dt_scan+=t2-t1;
+		std::sort(todo.begin(), todo.end());
+		if(todo!=ref) {
+			gapr::print("seed_bins mismatch at seed ", seed.first.data);
+			return -1;
+		}
+		// cover some, by own deltas or by others
+		for(auto id: todo) {
+			if(rng()%4==0)
+				continue;
+			covered[id.data]=true;
+			if(rng()%2==0)
+				bins.remove(id, points[id.data]);
+		}
+		if(++nseeds>=200)
+			break;
+	}
+	gapr::print("seed_bins: ", nseeds, " seeds, scan ",
+			std::chrono::duration_cast<std::chrono::microseconds>(dt_scan).count(), "us, bins ",
+			std::chrono::duration_cast<std::chrono::microseconds>(dt_bins).count(), "us");
+	if(nseeds<200)
+		return -1;
+	return 0;
+} }
+
+/*! per-task root lookup: full vertex scan vs. the per-key root index */
+namespace gapr_test { int bench_root_lookup() {
+	constexpr uint32_t nverts=1000000;
+	std::mt19937 rng{54321};
+	std::unordered_map<gapr::node_id, gapr::edge_model::vertex> vertices;
+	gapr::node_props props;
+	vertices.reserve(nverts);
+	for(uint32_t i=1; i<=nverts; i++) {
+		gapr::node_attr attr{rng()%10000*1.0, rng()%10000*1.0, rng()%10000*1.0};
+		vertices.emplace(gapr::node_id{i}, gapr::edge_model::vertex{attr, {}});
+		if(rng()%10==0)
+			props.try_emplace(gapr::prop_id{gapr::node_id{i}, "state"}, "end");
+		if(rng()%10000==0)
+			props.try_emplace(gapr::prop_id{gapr::node_id{i}, "root"}, "");
+	}
+
+	auto scan=[&]() {
+		std::vector<gapr::node_attr> to_skip;
+		for(auto& [vid, vert]: vertices) {
+			gapr::edge_model::prop_id pid{vid, "root"};
+			if(props.find(pid)!=props.end())
+				to_skip.push_back(vert.attr);
+		}
+		return to_skip;
+	};
+	auto index=[&]() {
+		std::vector<gapr::node_attr> to_skip;
+		for(auto nid: props.per_key("root")) {
+			if(auto it=vertices.find(nid); it!=vertices.end())
+				to_skip.push_back(it->second.attr);
+		}
+		return to_skip;
+	};
+	auto timeit=[](auto&& fn, std::vector<gapr::node_attr>& res) {
+		constexpr unsigned int nrep=5;
+		auto t0=std::chrono::steady_clock::now();
+		for(unsigned int k=0; k<nrep; k++)
+			res=fn();
+		auto t1=std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count()/nrep;
+	};
+	std::vector<gapr::node_attr> r1, r2;
+	auto dt1=timeit(scan, r1);
+	auto dt2=timeit(index, r2);
+	gapr::print("root lookup, ", nverts, " vertices, ", r1.size(), " roots: scan ", dt1, "us, index ", dt2, "us");
+	auto less=[](const gapr::node_attr& a, const gapr::node_attr& b) {
+		return a.data()<b.data();
+	};
+	std::sort(r1.begin(), r1.end(), less);
+	std::sort(r2.begin(), r2.end(), less);
+	if(r1.size()!=r2.size() || !std::equal(r1.begin(), r1.end(), r2.begin(), [](auto& a, auto& b) { return a.data()==b.data(); }))
+		return -1;
+	return 0;
+} }
+
 int main(int argc, char* argv[]) {
 	gapr::cli_helper cli_helper{};
 
@@ -2812,6 +3513,29 @@ int main(int argc, char* argv[]) {
 				case 1100+'b':
 					args.benchmark=true;
 					break;
+				case 1100+'s':
+					{
+						char* eptr;
+						errno=0;
+						auto n=std::strtoul(optarg, &eptr, 10);
+						if(errno!=0 || *eptr!='\0')
+							throw gapr::reported_error{"unable to parse <seed>"};
+						args.bench_seed=n;
+					}
+					args.benchmark=true;
+					break;
+				case 1100+'m':
+					args.bench_model=std::filesystem::u8path(optarg);
+					args.benchmark=true;
+					break;
+				case 1100+'c':
+					args.bench_catalog=std::filesystem::u8path(optarg);
+					args.benchmark=true;
+					break;
+				case 1100+'o':
+					args.bench_out=std::filesystem::u8path(optarg);
+					args.benchmark=true;
+					break;
 				case 1200+'I':
 					args.from_swc=std::filesystem::u8path(optarg);
 					break;
@@ -2860,6 +3584,12 @@ int main(int argc, char* argv[]) {
 				throw gapr::reported_error{"too many arguments"};
 			break;
 		}
+		if(args.benchmark && !args.bench_model.empty() && !args.bench_catalog.empty()) {
+			// nothing to connect to
+			if(optind<argc)
+				throw gapr::reported_error{"too many arguments"};
+			break;
+		}
 		/////////////////////////////
 		if(optind+1>argc)
 			throw gapr::reported_error{"argument <repo> missing"};
@@ -2954,3 +3684,141 @@ int main(int argc, char* argv[]) {
 
 }
 
+
+namespace gapr_test { int chk_import_pipeline() {
+	// stands in for gather, numbers new nodes like edge_model::load() does
+	struct fake_server {
+		gapr::node_id::data_type next_id{1};
+		std::vector<std::pair<gapr::node_id::data_type, gapr::node_id::data_type>> edges;
+		std::vector<std::pair<gapr::node_id::data_type, std::string>> props;
+		std::unordered_map<gapr::node_id::data_type, gapr::node_attr> attrs;
+		unsigned int ncommits{0};
+		gapr::node_id commit(gapr::delta_add_patch_&& delta) {
+			if(gapr::cannolize(delta)<0)
+				throw std::runtime_error{"invalid patch"};
+			gapr::node_id nid0{next_id};
+			std::vector<gapr::node_id::data_type> ids;
+			std::size_t j=0;
+			for(std::size_t i=0; i<delta.nodes.size(); i++) {
+				gapr::node_id::data_type id;
+				if(j<delta.links.size() && delta.links[j].first==i+1) {
+					id=gapr::link_id{delta.links[j++].second}.nodes[0].data;
+				} else {
+					id=next_id++;
+					attrs.emplace(id, gapr::node_attr{delta.nodes[i].first});
+				}
+				ids.push_back(id);
+				if(auto par=delta.nodes[i].second)
+					edges.emplace_back(ids[par-1], id);
+			}
+			for(auto& [id, val]: delta.props)
+				props.emplace_back(ids[id-1], std::move(val));
+			++ncommits;
+			return nid0;
+		}
+	};
+
+	std::mt19937 rng{34567};
+	constexpr int64_t nnodes=20000;
+	ImportHelper swc;
+	std::vector<gapr::vec3<>> pos(nnodes);
+	for(int64_t i=0; i<nnodes; i++) {
+		gapr::swc_node n{};
+		n.id=i*2+1;
+		n.type=rng()%4;
+		n.radius=1;
+		n.par_id=-1;
+		if(i>0 && rng()%64!=0) {
+			auto p=i-1-static_cast<int64_t>(rng()%std::min<int64_t>(i, 8));
+			n.par_id=p*2+1;
+			for(unsigned int k=0; k<3; k++)
+				pos[i][k]=pos[p][k]+static_cast<double>(rng()%11)-5;
+		} else {
+			for(unsigned int k=0; k<3; k++)
+				pos[i][k]=static_cast<double>(rng()%400);
+		}
+		n.pos=pos[i];
+		swc.add_node(n.id, n, gapr::misc_attr{});
+		if(i>16 && rng()%128==0)
+			swc.add_loop(n.id, (i-2-static_cast<int64_t>(rng()%16))*2+1);
+		if(rng()%64==0)
+			swc.add_prop(n.id, rng()%2?"state=end":"root=x");
+	}
+	std::reverse(swc.todo.begin(), swc.todo.end());
+
+	auto check=[&swc](const ImportHelper& helper, const fake_server& srv) {
+		std::vector<std::pair<gapr::node_id::data_type, gapr::node_id::data_type>> edges;
+		auto add_edge=[&edges](gapr::node_id::data_type a, gapr::node_id::data_type b) {
+			edges.emplace_back(std::min(a, b), std::max(a, b));
+		};
+		for(auto& [id, n]: helper.nodes) {
+			if(n.state!=2)
+				return false;
+			auto it=srv.attrs.find(n.id2.data);
+			if(it==srv.attrs.end())
+				return false;
+			for(unsigned int k=0; k<3; k++) {
+				if(it->second.pos(k)!=n.pos(k))
+					return false;
+			}
+			if(n.par_id!=-1)
+				add_edge(n.id2.data, helper.nodes.at(n.par_id).id2.data);
+		}
+		if(srv.attrs.size()!=helper.nodes.size())
+			return false;
+		for(auto [a, b]: swc.loops)
+			add_edge(helper.nodes.at(a).id2.data, helper.nodes.at(b).id2.data);
+		std::vector<std::pair<gapr::node_id::data_type, gapr::node_id::data_type>> edges2;
+		for(auto [a, b]: srv.edges)
+			edges2.emplace_back(std::min(a, b), std::max(a, b));
+		std::sort(edges.begin(), edges.end());
+		std::sort(edges2.begin(), edges2.end());
+		if(edges!=edges2)
+			return false;
+		std::vector<std::pair<gapr::node_id::data_type, std::string>> props;
+		for(auto& [id, val]: swc.props)
+			props.emplace_back(helper.nodes.at(id).id2.data, val);
+		auto props2=srv.props;
+		std::sort(props.begin(), props.end());
+		std::sort(props2.begin(), props2.end());
+		return props==props2;
+	};
+
+	int r=0;
+	for(bool overlap: {false, true}) {
+		auto helper=swc;
+		fake_server srv;
+		// build on another thread, so it really overlaps commit()
+		ba::thread_pool pool{1};
+		auto start=[&pool](ImportHelper::DeltaBuilder& builder, gapr::vec3<> seed_pos) {
+			std::packaged_task<void()> task{[&builder,seed_pos]() {
+				builder.finish([seed_pos](const auto& pos) {
+					double maxl1=0;
+					for(unsigned int i=0; i<3; ++i)
+						maxl1=std::max(maxl1, std::abs(pos[i]-seed_pos[i]));
+					return maxl1>100?1u:0u;
+				});
+			}};
+			auto fut=task.get_future();
+			ba::post(pool, std::move(task));
+			return fut;
+		};
+		auto wait=[](std::future<void>&& fut) { fut.get(); };
+		auto commit=[&srv](gapr::delta_add_patch_&& delta) {
+			return srv.commit(std::move(delta));
+		};
+		try {
+			helper.commit_all(start, wait, commit, overlap);
+		} catch(const std::runtime_error& e) {
+			gapr::print("import ", overlap, ": ", e.what());
+			r=-1;
+			continue;
+		}
+		gapr::print("import ", overlap?"overlapped":"serial", ": ", srv.ncommits, " commits");
+		if(!check(helper, srv)) {
+			gapr::print("import ", overlap, ": model mismatch");
+			r=-1;
+		}
+	}
+	return r;
+} }